@@ -0,0 +1,61 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "audio_core/audio_core.h"
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+#include "audio_core/sink.h"
+#include "audio_core/sink_details.h"
+
+#include "common/logging/log.h"
+
+#include "core/core_timing.h"
+#include "core/hle/service/dsp_dsp.h"
+
+namespace AudioCore {
+
+// Audio Ticks occur about every 5 miliseconds.
+static int tick_event;                                                    ///< CoreTiming event
+static constexpr u64 audio_frame_ticks = 268123480ull * DSP::HLE::samples_per_frame / native_sample_rate; ///< Units: ARM11 cycles
+
+static void AudioTickCallback(u64 /*userdata*/, int cycles_late) {
+    if (DSP::HLE::Tick()) {
+        // TODO: Signal all the other interrupts as appropriate.
+        DSP_DSP::SignalInterrupt();
+    }
+
+    // Reschedule recurrent event
+    CoreTiming::ScheduleEvent(audio_frame_ticks - cycles_late, tick_event);
+}
+
+void Init() {
+    DSP::HLE::Init();
+
+    tick_event = CoreTiming::RegisterEvent("AudioCore::tick_event", AudioTickCallback);
+    CoreTiming::ScheduleEvent(audio_frame_ticks, tick_event);
+}
+
+void Shutdown() {
+    CoreTiming::UnscheduleEvent(tick_event, 0);
+    DSP::HLE::Shutdown();
+}
+
+void SelectSink(const std::string& sink_id) {
+    auto iter = std::find_if(g_sink_details.begin(), g_sink_details.end(), [&sink_id](const SinkDetails& sink_detail) {
+        return sink_detail.id == sink_id;
+    });
+
+    if (iter == g_sink_details.end()) {
+        LOG_ERROR(Audio, "AudioCore::SelectSink given invalid sink_id %s, falling back to %s", sink_id.c_str(), g_sink_details.front().id);
+        iter = g_sink_details.begin();
+    }
+
+    DSP::HLE::SetSink(iter->factory());
+}
+
+} // namespace AudioCore
@@ -0,0 +1,25 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+namespace AudioCore {
+
+constexpr int native_sample_rate = 32728;  ///< 32kHz
+
+/// Initialise Audio Core
+void Init();
+
+/// Shutdown Audio Core
+void Shutdown();
+
+/**
+ * Selects the sink the HLE DSP outputs to
+ * @param sink_id Identifier of the sink, as listed in g_sink_details. Unknown ids select the null sink.
+ */
+void SelectSink(const std::string& sink_id);
+
+} // namespace
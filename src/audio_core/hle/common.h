@@ -0,0 +1,25 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "common/common_types.h"
+
+namespace DSP {
+namespace HLE {
+
+constexpr size_t num_sources = 24;
+constexpr size_t samples_per_frame = 160;      ///< Samples per audio frame at native sample rate
+
+/// The final output to the speakers is stereo. Preprocessing output in Source is also stereo.
+using StereoFrame16 = std::array<std::array<s16, 2>, samples_per_frame>;
+
+/// The DSP is quadraphonic internally.
+using QuadFrame32   = std::array<std::array<s32, 4>, samples_per_frame>;
+
+} // namespace HLE
+} // namespace DSP
@@ -0,0 +1,111 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <memory>
+
+#include "audio_core/hle/dsp.h"
+#include "audio_core/hle/mixers.h"
+#include "audio_core/hle/source.h"
+#include "audio_core/sink.h"
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+
+#include "core/memory.h"
+
+namespace DSP {
+namespace HLE {
+
+static std::array<Source, num_sources> sources = {{
+    Source(0), Source(1), Source(2), Source(3), Source(4), Source(5),
+    Source(6), Source(7), Source(8), Source(9), Source(10), Source(11),
+    Source(12), Source(13), Source(14), Source(15), Source(16), Source(17),
+    Source(18), Source(19), Source(20), Source(21), Source(22), Source(23)
+}};
+static Mixers mixers;
+
+static std::unique_ptr<AudioCore::Sink> sink;
+
+MICROPROFILE_DEFINE(DSP_Tick, "DSP", "Audio Frame", MP_RGB(100, 200, 100));
+
+/// Gets the shared memory region located at `offset` in DSP RAM, or nullptr if it isn't mapped.
+static SharedMemory* GetRegion(u32 offset) {
+    return reinterpret_cast<SharedMemory*>(Memory::GetPointer(Memory::DSP_RAM_VADDR + offset));
+}
+
+/**
+ * The application and the DSP alternate between the two regions every frame. The DSP reads the
+ * region with the most recent frame counter, and writes its results to the other region.
+ * The frame counter wraps around from 0xFFFF to 0.
+ */
+static bool IsRegion0Newer(u16 frame_counter_0, u16 frame_counter_1) {
+    if (frame_counter_0 == 0xFFFF && frame_counter_1 != 0xFFFE) {
+        // Wraparound has occured.
+        return false;
+    }
+
+    if (frame_counter_1 == 0xFFFF && frame_counter_0 != 0xFFFE) {
+        // Wraparound has occured.
+        return true;
+    }
+
+    return frame_counter_0 > frame_counter_1;
+}
+
+void Init() {
+    for (auto& source : sources) {
+        source.Reset();
+    }
+
+    mixers.Reset();
+}
+
+void Shutdown() {
+    sink.reset();
+}
+
+bool Tick() {
+    MICROPROFILE_SCOPE(DSP_Tick);
+
+    SharedMemory* region0 = GetRegion(region0_offset);
+    SharedMemory* region1 = GetRegion(region1_offset);
+    if (region0 == nullptr || region1 == nullptr)
+        return false;
+
+    const bool region0_newer = IsRegion0Newer(region0->frame_counter, region1->frame_counter);
+    SharedMemory& read = region0_newer ? *region0 : *region1;
+    SharedMemory& write = region0_newer ? *region1 : *region0;
+
+    std::array<QuadFrame32, 3> intermediate_mixes = {};
+
+    for (size_t i = 0; i < num_sources; i++) {
+        write.source_statuses.status[i] = sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
+        for (size_t mix = 0; mix < 3; mix++) {
+            sources[i].MixInto(intermediate_mixes[mix], mix);
+        }
+    }
+
+    write.dsp_status = mixers.Tick(read.dsp_configuration, intermediate_mixes);
+
+    const StereoFrame16& output = mixers.GetOutput();
+    for (size_t i = 0; i < samples_per_frame; i++) {
+        write.final_samples.pcm16[i][0] = output[i][0];
+        write.final_samples.pcm16[i][1] = output[i][1];
+    }
+
+    if (sink) {
+        sink->EnqueueSamples(&output[0][0], output.size());
+    }
+
+    return true;
+}
+
+void SetSink(std::unique_ptr<AudioCore::Sink> sink_) {
+    sink = std::move(sink_);
+}
+
+} // namespace HLE
+} // namespace DSP
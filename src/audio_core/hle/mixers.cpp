@@ -0,0 +1,193 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef ARCHITECTURE_x86_64
+#include <smmintrin.h>
+#endif
+
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+#include "audio_core/hle/mixers.h"
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/math_util.h"
+
+namespace DSP {
+namespace HLE {
+
+void MixStereoInto(QuadFrame32& dest, const StereoFrame16& src, const std::array<float, 4>& gain) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128 gain_vec = _mm_loadu_ps(gain.data());
+    for (size_t i = 0; i < samples_per_frame; i++) {
+        s32 stereo_sample;
+        std::memcpy(&stereo_sample, src[i].data(), sizeof(stereo_sample));
+
+        // [L, R] -> [L, R, L, R], sign-extended to 32 bits
+        __m128i sample = _mm_cvtepi16_epi32(_mm_shuffle_epi32(_mm_cvtsi32_si128(stereo_sample), 0));
+        __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(sample), gain_vec);
+
+        __m128i* row = reinterpret_cast<__m128i*>(dest[i].data());
+        _mm_storeu_si128(row, _mm_add_epi32(_mm_loadu_si128(row), _mm_cvttps_epi32(scaled)));
+    }
+#else
+    for (size_t i = 0; i < samples_per_frame; i++) {
+        for (size_t channel = 0; channel < 4; channel++) {
+            dest[i][channel] += static_cast<s32>(gain[channel] * src[i][channel % 2]);
+        }
+    }
+#endif
+}
+
+void Mixers::Reset() {
+    current_frame.fill({});
+    state = {};
+}
+
+DspStatus Mixers::Tick(DspConfiguration& config, const std::array<QuadFrame32, 3>& intermediate_mixes) {
+    ParseConfig(config);
+
+    // Mixer 0 is always enabled; mixers 1 and 2 may be disabled by the application.
+    const bool mixer_enabled[3] = { true, state.mixer1_enabled, state.mixer2_enabled };
+
+    QuadFrame32 final_mix;
+    final_mix.fill({});
+
+    for (size_t mix = 0; mix < 3; mix++) {
+        if (!mixer_enabled[mix] || state.intermediate_mixer_volume[mix] == 0.0f)
+            continue;
+
+        const float volume = state.intermediate_mixer_volume[mix];
+        const QuadFrame32& samples = intermediate_mixes[mix];
+
+#ifdef ARCHITECTURE_x86_64
+        const __m128 volume_vec = _mm_set1_ps(volume);
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples[i].data()));
+            const __m128i scaled = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(in), volume_vec));
+
+            __m128i* row = reinterpret_cast<__m128i*>(final_mix[i].data());
+            _mm_storeu_si128(row, _mm_add_epi32(_mm_loadu_si128(row), scaled));
+        }
+#else
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            for (size_t channel = 0; channel < 4; channel++) {
+                final_mix[i][channel] += static_cast<s32>(volume * samples[i][channel]);
+            }
+        }
+#endif
+    }
+
+    DownmixAndMixIntoCurrentFrame(final_mix);
+
+    return GetCurrentStatus();
+}
+
+void Mixers::ParseConfig(DspConfiguration& config) {
+    if (!config.dirty_raw) {
+        return;
+    }
+
+    if (config.mixer1_enabled_dirty) {
+        config.mixer1_enabled_dirty.Assign(0);
+        state.mixer1_enabled = config.mixer1_enabled != 0;
+        LOG_TRACE(Audio_DSP, "mixers mixer1_enabled = %hu", static_cast<u16>(config.mixer1_enabled));
+    }
+
+    if (config.mixer2_enabled_dirty) {
+        config.mixer2_enabled_dirty.Assign(0);
+        state.mixer2_enabled = config.mixer2_enabled != 0;
+        LOG_TRACE(Audio_DSP, "mixers mixer2_enabled = %hu", static_cast<u16>(config.mixer2_enabled));
+    }
+
+    if (config.volume_0_dirty) {
+        config.volume_0_dirty.Assign(0);
+        state.intermediate_mixer_volume[0] = config.volume[0];
+        LOG_TRACE(Audio_DSP, "mixers volume[0] = %f", state.intermediate_mixer_volume[0]);
+    }
+
+    if (config.volume_1_dirty) {
+        config.volume_1_dirty.Assign(0);
+        state.intermediate_mixer_volume[1] = config.volume[1];
+        LOG_TRACE(Audio_DSP, "mixers volume[1] = %f", state.intermediate_mixer_volume[1]);
+    }
+
+    if (config.volume_2_dirty) {
+        config.volume_2_dirty.Assign(0);
+        state.intermediate_mixer_volume[2] = config.volume[2];
+        LOG_TRACE(Audio_DSP, "mixers volume[2] = %f", state.intermediate_mixer_volume[2]);
+    }
+
+    if (config.output_format_dirty) {
+        config.output_format_dirty.Assign(0);
+        state.output_format = config.output_format;
+        LOG_TRACE(Audio_DSP, "mixers output_format = %zu", static_cast<size_t>(config.output_format));
+    }
+
+    if (config.headphones_connected_dirty) {
+        config.headphones_connected_dirty.Assign(0);
+        // Do nothing.
+        // (Note: Whether headphones are connected does affect coefficients used for surround sound.)
+        LOG_TRACE(Audio_DSP, "mixers headphones_connected=%hu", static_cast<u16>(config.headphones_connected));
+    }
+
+    if (config.dirty_raw) {
+        LOG_DEBUG(Audio_DSP, "mixers remaining_dirty=%x", static_cast<u32>(config.dirty_raw));
+    }
+
+    config.dirty_raw = 0;
+}
+
+void Mixers::DownmixAndMixIntoCurrentFrame(const QuadFrame32& samples) {
+    // TODO: Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
+
+    switch (state.output_format) {
+    case OutputFormat::Mono:
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            const s32 left = MathUtil::Clamp<s32>(samples[i][0] + samples[i][2], -32768, 32767);
+            const s32 right = MathUtil::Clamp<s32>(samples[i][1] + samples[i][3], -32768, 32767);
+            const s16 mono = static_cast<s16>((left + right) / 2);
+            current_frame[i][0] = mono;
+            current_frame[i][1] = mono;
+        }
+        return;
+
+    case OutputFormat::Surround:
+        // TODO: Implement surround sound.
+        // fallthrough
+
+    case OutputFormat::Stereo:
+#ifdef ARCHITECTURE_x86_64
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            // [FL, FR, RL, RR] -> [FL + RL, FR + RR], saturated to s16
+            const __m128i quad = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples[i].data()));
+            const __m128i stereo = _mm_add_epi32(quad, _mm_shuffle_epi32(quad, _MM_SHUFFLE(1, 0, 3, 2)));
+            const s32 packed = _mm_cvtsi128_si32(_mm_packs_epi32(stereo, stereo));
+            std::memcpy(current_frame[i].data(), &packed, sizeof(packed));
+        }
+#else
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            current_frame[i][0] = static_cast<s16>(MathUtil::Clamp<s32>(samples[i][0] + samples[i][2], -32768, 32767));
+            current_frame[i][1] = static_cast<s16>(MathUtil::Clamp<s32>(samples[i][1] + samples[i][3], -32768, 32767));
+        }
+#endif
+        return;
+    }
+
+    UNREACHABLE();
+}
+
+DspStatus Mixers::GetCurrentStatus() const {
+    DspStatus status = {};
+    status.unknown = 0;
+    status.dropped_frames = 0;
+    return status;
+}
+
+} // namespace HLE
+} // namespace DSP
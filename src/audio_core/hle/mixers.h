@@ -0,0 +1,77 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+
+namespace DSP {
+namespace HLE {
+
+/**
+ * Mixes a stereo frame into a quadraphonic frame. Channel 0 and 2 of `dest` receive the left
+ * channel and channels 1 and 3 receive the right channel, each scaled by the corresponding gain.
+ * @param dest The frame to accumulate into.
+ * @param src The stereo frame to be mixed.
+ * @param gain Gains for each of the four channels of `dest`.
+ */
+void MixStereoInto(QuadFrame32& dest, const StereoFrame16& src, const std::array<float, 4>& gain);
+
+/**
+ * This module performs the final mixing stage: the outputs of the three intermediate mixers are
+ * attenuated by their respective volumes and downmixed to the stereo output format.
+ * This module is not yet implemented:
+ * - Delay and reverb effects
+ * - Surround output
+ * - The limiter
+ */
+class Mixers final {
+public:
+    Mixers() {
+        Reset();
+    }
+
+    /// Resets internal state.
+    void Reset();
+
+    /**
+     * This is called once every audio frame.
+     * @param config The DSP configuration we've got from the application.
+     * @param intermediate_mixes The outputs of the three intermediate mixers for this frame.
+     * @return The current status of the DSP. This is given back to the application via SharedMemory.
+     */
+    DspStatus Tick(DspConfiguration& config, const std::array<QuadFrame32, 3>& intermediate_mixes);
+
+    /// Gets the output of the final mixer for the last frame.
+    const StereoFrame16& GetOutput() const {
+        return current_frame;
+    }
+
+private:
+    StereoFrame16 current_frame = {};
+
+    using OutputFormat = DspConfiguration::OutputFormat;
+
+    struct {
+        std::array<float, 3> intermediate_mixer_volume = {};
+
+        bool mixer1_enabled = false;
+        bool mixer2_enabled = false;
+
+        OutputFormat output_format = OutputFormat::Stereo;
+    } state;
+
+    /// INTERNAL: Update our internal state based on the current config.
+    void ParseConfig(DspConfiguration& config);
+    /// INTERNAL: Downmix the attenuated sum of the intermediate mixes into current_frame.
+    void DownmixAndMixIntoCurrentFrame(const QuadFrame32& samples);
+    /// INTERNAL: Generate DspStatus based on internal state.
+    DspStatus GetCurrentStatus() const;
+};
+
+} // namespace HLE
+} // namespace DSP
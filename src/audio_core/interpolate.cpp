@@ -0,0 +1,64 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "audio_core/interpolate.h"
+
+#include "common/assert.h"
+#include "common/math_util.h"
+
+namespace AudioInterp {
+
+// Calculations are done in fixed point with 24 fractional bits.
+// (This is not verified. This was chosen for minimal error.)
+constexpr u64 scale_factor = 1 << 24;
+constexpr u64 scale_mask = scale_factor - 1;
+
+/// Here we step over the input in steps of rate_multiplier, until we consume all of the input.
+/// Three adjacent samples are passed to fn each step.
+template <typename Function>
+static void StepOverSamples(State& state, const Codec::StereoBuffer16& input, size_t& input_position,
+                            float rate_multiplier, DSP::HLE::StereoFrame16& output, size_t& outputi, Function fn) {
+    ASSERT(rate_multiplier > 0);
+
+    const u64 step_size = static_cast<u64>(rate_multiplier * scale_factor);
+
+    while (outputi < output.size() && input_position < input.size()) {
+        const std::array<s16, 2>& x0 = state.xn1;
+        const std::array<s16, 2>& x1 = input[input_position];
+
+        output[outputi++] = fn(state.fposition & scale_mask, x0, x1);
+
+        state.fposition += step_size;
+        while (state.fposition >= scale_factor && input_position < input.size()) {
+            state.fposition -= scale_factor;
+            state.xn1 = input[input_position++];
+        }
+    }
+}
+
+void None(State& state, const Codec::StereoBuffer16& input, size_t& input_position, float rate_multiplier,
+          DSP::HLE::StereoFrame16& output, size_t& outputi) {
+    StepOverSamples(state, input, input_position, rate_multiplier, output, outputi,
+        [](u64 fraction, const std::array<s16, 2>& x0, const std::array<s16, 2>& x1) {
+            return x0;
+        });
+}
+
+void Linear(State& state, const Codec::StereoBuffer16& input, size_t& input_position, float rate_multiplier,
+            DSP::HLE::StereoFrame16& output, size_t& outputi) {
+    // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
+    StepOverSamples(state, input, input_position, rate_multiplier, output, outputi,
+        [](u64 fraction, const std::array<s16, 2>& x0, const std::array<s16, 2>& x1) {
+            // This is a saturated subtraction. (Verified by black-box fuzzing.)
+            s64 delta0 = MathUtil::Clamp<s64>(x1[0] - x0[0], -32768, 32767);
+            s64 delta1 = MathUtil::Clamp<s64>(x1[1] - x0[1], -32768, 32767);
+
+            return std::array<s16, 2> {{
+                static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+                static_cast<s16>(x0[1] + fraction * delta1 / scale_factor)
+            }};
+        });
+}
+
+} // namespace
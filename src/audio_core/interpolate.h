@@ -0,0 +1,45 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+
+#include "audio_core/codec.h"
+#include "audio_core/hle/common.h"
+
+#include "common/common_types.h"
+
+namespace AudioInterp {
+
+/// Interpolation state that is carried over between input buffers.
+struct State {
+    /// The last sample consumed from the input, x[n-1]
+    std::array<s16, 2> xn1;
+    /// Position between x[n-1] and x[n], as fixed point with 24 fractional bits
+    u64 fposition;
+};
+
+/**
+ * No interpolation. This is equivalent to a zero-order hold. There is a two-sample predelay.
+ * @param state Interpolation state.
+ * @param input Input buffer.
+ * @param input_position Position of the next sample to be consumed from `input`. Updated.
+ * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
+ *                        rate_multiplier > 1.0 performs decimation and rate_multipler < 1.0
+ *                        performs upsampling.
+ * @param output The resampled audio buffer.
+ * @param outputi Index into `output` of the next sample to be produced. Updated.
+ */
+void None(State& state, const Codec::StereoBuffer16& input, size_t& input_position, float rate_multiplier,
+          DSP::HLE::StereoFrame16& output, size_t& outputi);
+
+/**
+ * Linear interpolation. This is equivalent to a first-order hold. There is a two-sample predelay.
+ * Parameters are as for AudioInterp::None.
+ */
+void Linear(State& state, const Codec::StereoBuffer16& input, size_t& input_position, float rate_multiplier,
+            DSP::HLE::StereoFrame16& output, size_t& outputi);
+
+} // namespace
@@ -0,0 +1,25 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+
+#include "common/file_util.h"
+#include "common/make_unique.h"
+
+#include "audio_core/null_sink.h"
+#include "audio_core/sink_details.h"
+#include "audio_core/wav_sink.h"
+
+namespace AudioCore {
+
+// The first entry is the default, used when the configured sink id is unknown.
+const std::vector<SinkDetails> g_sink_details = {
+    { "null", []() -> std::unique_ptr<Sink> { return Common::make_unique<NullSink>(); } },
+    { "wav", []() -> std::unique_ptr<Sink> {
+        return Common::make_unique<WavSink>(FileUtil::GetUserPath(D_USER_IDX) + "audio_output.wav");
+    } },
+};
+
+} // namespace
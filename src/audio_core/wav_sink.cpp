@@ -0,0 +1,84 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+
+#include "common/logging/log.h"
+#include "common/swap.h"
+
+#include "audio_core/audio_core.h"
+#include "audio_core/wav_sink.h"
+
+namespace AudioCore {
+
+namespace {
+
+struct WavHeader {
+    char riff_id[4];
+    u32_le riff_size;
+    char wave_id[4];
+
+    char fmt_id[4];
+    u32_le fmt_size;
+    u16_le audio_format;
+    u16_le num_channels;
+    u32_le sample_rate;
+    u32_le byte_rate;
+    u16_le block_align;
+    u16_le bits_per_sample;
+
+    char data_id[4];
+    u32_le data_size;
+};
+static_assert(sizeof(WavHeader) == 44, "WavHeader has incorrect size");
+
+constexpr u16 num_channels = 2;
+constexpr u16 bytes_per_sample = sizeof(s16);
+
+}
+
+WavSink::WavSink(const std::string& filename) : file(filename, "wb") {
+    if (!file.IsOpen()) {
+        LOG_ERROR(Audio_Sink, "Could not open %s for writing", filename.c_str());
+        return;
+    }
+
+    // Reserve space for the header, which is rewritten with the final sizes on destruction
+    WriteHeader();
+}
+
+WavSink::~WavSink() {
+    if (file.IsOpen()) {
+        file.Seek(0, SEEK_SET);
+        WriteHeader();
+    }
+}
+
+unsigned int WavSink::GetNativeSampleRate() const {
+    return native_sample_rate;
+}
+
+void WavSink::EnqueueSamples(const s16* samples, size_t sample_count) {
+    if (!file.IsOpen())
+        return;
+
+    file.WriteArray(samples, sample_count * num_channels);
+    samples_written += static_cast<u32>(sample_count);
+}
+
+void WavSink::WriteHeader() {
+    const u32 data_size = samples_written * num_channels * bytes_per_sample;
+
+    WavHeader header = {
+        {'R', 'I', 'F', 'F'}, 36 + data_size, {'W', 'A', 'V', 'E'},
+        {'f', 'm', 't', ' '}, 16, 1 /* PCM */, num_channels, native_sample_rate,
+        native_sample_rate * num_channels * bytes_per_sample, num_channels * bytes_per_sample,
+        8 * bytes_per_sample,
+        {'d', 'a', 't', 'a'}, data_size,
+    };
+
+    file.WriteObject(header);
+}
+
+} // namespace
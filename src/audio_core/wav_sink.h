@@ -0,0 +1,40 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "common/file_util.h"
+
+#include "audio_core/sink.h"
+
+namespace AudioCore {
+
+/// Sink that writes all samples to a WAV file, useful for checking the DSP output headless.
+class WavSink final : public Sink {
+public:
+    /// @param filename Path of the WAV file to create. An existing file is overwritten.
+    explicit WavSink(const std::string& filename);
+    ~WavSink() override;
+
+    unsigned int GetNativeSampleRate() const override;
+
+    void EnqueueSamples(const s16* samples, size_t sample_count) override;
+
+    size_t SamplesInQueue() const override {
+        return 0;
+    }
+
+private:
+    /// Writes the RIFF/WAVE header for the samples written so far
+    void WriteHeader();
+
+    FileUtil::IOFile file;
+    /// Number of stereo frames written to the file
+    u32 samples_written = 0;
+};
+
+} // namespace
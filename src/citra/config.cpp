@@ -62,11 +62,16 @@ void Config::ReadValues() {
     // Renderer
     Settings::values.use_hw_renderer = glfw_config->GetBoolean("Renderer", "use_hw_renderer", false);
     Settings::values.use_shader_jit = glfw_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_shader_jit_fma = glfw_config->GetBoolean("Renderer", "use_shader_jit_fma", false);
+    Settings::values.shader_threading_min_vertices = glfw_config->GetInteger("Renderer", "shader_threading_min_vertices", 4096);
 
     Settings::values.bg_red   = (float)glfw_config->GetReal("Renderer", "bg_red",   1.0);
     Settings::values.bg_green = (float)glfw_config->GetReal("Renderer", "bg_green", 1.0);
     Settings::values.bg_blue  = (float)glfw_config->GetReal("Renderer", "bg_blue",  1.0);
 
+    // Audio
+    Settings::values.sink_id = glfw_config->Get("Audio", "output_engine", "null");
+
     // Data Storage
     Settings::values.use_virtual_sd = glfw_config->GetBoolean("Data Storage", "use_virtual_sd", true);
 
@@ -46,12 +46,26 @@ use_hw_renderer =
 # 0 : Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether the shader JIT may use fused multiply-add for MAD on CPUs supporting FMA3.
+# Faster, but the results are no longer bit-exact with the interpreter.
+# 0 (default): Off, 1: On
+use_shader_jit_fma =
+
+# Minimum number of vertices a draw must shade before the work is split across multiple threads
+# 0: Always shade on a single thread, 4096 (default)
+shader_threading_min_vertices =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 1.0 for all.
 bg_red =
 bg_blue =
 bg_green =
 
+[Audio]
+# Which audio output engine to use.
+# null (default): No audio output, wav: Writes the output to audio_output.wav in the user directory
+output_engine =
+
 [Data Storage]
 # Whether to create a virtual SD card.
 # 1 (default): Yes, 0: No
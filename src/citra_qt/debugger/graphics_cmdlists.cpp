@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <vector>
+
 #include <QApplication>
 #include <QClipboard>
 #include <QComboBox>
@@ -24,10 +26,13 @@
 #include "video_core/debug_utils/debug_utils.h"
 
 QImage LoadTexture(u8* src, const Pica::DebugUtils::TextureInfo& info) {
+    std::vector<Math::Vec4<u8>> texels(info.width * info.height);
+    Pica::DebugUtils::DecodeTexture(src, info, texels.data(), true);
+
     QImage decoded_image(info.width, info.height, QImage::Format_ARGB32);
     for (int y = 0; y < info.height; ++y) {
         for (int x = 0; x < info.width; ++x) {
-            Math::Vec4<u8> color = Pica::DebugUtils::LookupTexture(src, x, y, info, true);
+            const Math::Vec4<u8>& color = texels[x + info.width * y];
             decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
         }
     }
@@ -0,0 +1,71 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(unsigned num_workers) : next_task(0) {
+    for (unsigned i = 0; i < num_workers; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    work_available.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(unsigned num_tasks, const std::function<void(unsigned)>& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        this->num_tasks = num_tasks;
+        next_task = 0;
+        busy_workers = static_cast<unsigned>(workers.size());
+        ++generation;
+    }
+    work_available.notify_all();
+
+    RunTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this] { return busy_workers == 0; });
+    current_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    SetCurrentThreadName("ThreadPool worker");
+
+    u64 last_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(lock, [&] { return shutting_down || generation != last_generation; });
+            if (shutting_down)
+                return;
+            last_generation = generation;
+        }
+
+        RunTasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0)
+            work_done.notify_one();
+    }
+}
+
+void ThreadPool::RunTasks() {
+    // Tasks are handed out one at a time, so that faster threads pick up more of them
+    for (unsigned task = next_task++; task < num_tasks; task = next_task++)
+        (*current_task)(task);
+}
+
+} // namespace Common
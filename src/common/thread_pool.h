@@ -0,0 +1,63 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Fixed set of worker threads for splitting a piece of work into independent tasks. The thread
+ * submitting the work takes part in running the tasks, and waits until all of them are done.
+ */
+class ThreadPool {
+public:
+    /// @param num_workers Number of worker threads to start, in addition to the calling thread
+    explicit ThreadPool(unsigned num_workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Returns the number of threads running tasks, including the one submitting them
+    unsigned GetNumThreads() const {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    /**
+     * Runs task(0) to task(num_tasks - 1) spread over all threads, returning once all of them
+     * finished. Tasks must not submit work to the same pool.
+     */
+    void ParallelFor(unsigned num_tasks, const std::function<void(unsigned)>& task);
+
+private:
+    void WorkerLoop();
+    void RunTasks();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    /// Incremented for every ParallelFor call, so that workers can tell new work from old
+    u64 generation = 0;
+    /// Number of workers that haven't finished the current generation yet
+    unsigned busy_workers = 0;
+    bool shutting_down = false;
+
+    const std::function<void(unsigned)>* current_task = nullptr;
+    unsigned num_tasks = 0;
+    std::atomic<unsigned> next_task;
+};
+
+} // namespace Common
@@ -350,7 +350,7 @@ private:
     void WriteSSSE3Op(u8 opPrefix, u16 op, X64Reg regOp, const OpArg& arg, int extrabytes = 0);
     void WriteSSE41Op(u8 opPrefix, u16 op, X64Reg regOp, const OpArg& arg, int extrabytes = 0);
     void WriteAVXOp(u8 opPrefix, u16 op, X64Reg regOp, const OpArg& arg, int extrabytes = 0);
-    void WriteAVXOp(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg, int extrabytes = 0);
+    void WriteAVXOp(u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg, int extrabytes = 0, int W = 0);
     void WriteVEXOp(int size, u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg, int extrabytes = 0);
     void WriteBMI1Op(int size, u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg, int extrabytes = 0);
     void WriteBMI2Op(int size, u8 opPrefix, u16 op, X64Reg regOp1, X64Reg regOp2, const OpArg& arg, int extrabytes = 0);
@@ -776,6 +776,9 @@ public:
     void PINSRW(X64Reg dest, const OpArg& arg, u8 subreg);
 
     void PMADDWD(X64Reg dest, const OpArg& arg);
+    void PMULLW(X64Reg dest, const OpArg& arg);
+    // SSE4: Low 32 bits of the signed product.
+    void PMULLD(X64Reg dest, const OpArg& arg);
     void PSADBW(X64Reg dest, const OpArg& arg);
 
     void PMAXSW(X64Reg dest, const OpArg& arg);
@@ -874,6 +877,22 @@ public:
     void VUNPCKLPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
     void VUNPCKHPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
 
+    void VADDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VSUBPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMULPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VDIVPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMINPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VMAXPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VCMPPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 compare);
+    void VSHUFPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 shuffle);
+    void VUNPCKLPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VUNPCKHPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
+    void VBLENDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, u8 blend);
+    void VBLENDVPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg, X64Reg mask);
+    void VPERMILPS(X64Reg regOp, const OpArg& arg, u8 shuffle);
+    // Broadcasting from a register requires AVX2, from memory only AVX
+    void VBROADCASTSS(X64Reg regOp, const OpArg& arg);
+
     void VANDPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
     void VANDPD(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
     void VANDNPS(X64Reg regOp1, X64Reg regOp2, const OpArg& arg);
@@ -5,10 +5,13 @@
 #pragma once
 
 #include <string>
+#include <utility>
 
+#include "common/assert.h"
 #include "common/common_types.h"
 
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/vm_manager.h"
 #include "core/hle/result.h"
 
 namespace Kernel {
@@ -77,4 +80,62 @@ private:
     ~SharedMemory() override;
 };
 
+/**
+ * Typed view of a structure stored at a fixed offset inside a shared memory block. The host pointer
+ * is resolved the first time the view is accessed after the block is mapped, and is only looked up
+ * again when the block is remapped or the page table changes (tracked by g_page_table_generation),
+ * so that frequently updated structures can be accessed directly.
+ */
+template <typename T>
+class SharedMemoryView {
+public:
+    SharedMemoryView() = default;
+
+    /**
+     * @param block Shared memory block holding the structure
+     * @param offset Offset of the first structure from the start of the block
+     */
+    explicit SharedMemoryView(SharedPtr<SharedMemory> block, u32 offset = 0)
+        : block(std::move(block)), offset(offset) {}
+
+    /**
+     * Gets a pointer to the viewed structure
+     * @param index Index of the structure, for views of arrays of consecutive structures
+     * @return Host pointer to the structure, or nullptr if the block isn't mapped yet
+     */
+    T* Get(u32 index = 0) {
+        if (block == nullptr)
+            return nullptr;
+
+        if (generation != g_page_table_generation || address != block->base_address) {
+            pointer = reinterpret_cast<T*>(block->GetPointer(offset));
+            address = block->base_address;
+            generation = g_page_table_generation;
+        }
+
+        return (pointer != nullptr) ? pointer + index : nullptr;
+    }
+
+    T* operator->() {
+        T* structure = Get();
+        ASSERT_MSG(structure != nullptr, "Accessing shared memory view of an unmapped block");
+        return structure;
+    }
+
+    T& operator[](u32 index) {
+        T* structure = Get(index);
+        ASSERT_MSG(structure != nullptr, "Accessing shared memory view of an unmapped block");
+        return *structure;
+    }
+
+private:
+    SharedPtr<SharedMemory> block = nullptr;
+    u32 offset = 0;
+
+    /// Cached host pointer, valid while `address` and `generation` match the current state
+    T* pointer = nullptr;
+    VAddr address = 0;
+    u32 generation = 0;
+};
+
 } // namespace
@@ -11,6 +11,8 @@
 
 namespace Kernel {
 
+u32 g_page_table_generation = 0;
+
 static const char* GetMemoryStateName(MemoryState state) {
     static const char* names[] = {
         "Free", "Reserved", "IO", "Static", "Code", "Private", "Shared", "Continuous", "Aliased",
@@ -319,6 +321,8 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
 }
 
 void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
+    ++g_page_table_generation;
+
     switch (vma.type) {
     case VMAType::Free:
         Memory::UnmapRegion(vma.base, vma.size);
@@ -63,6 +63,12 @@ enum class MemoryState : u8 {
     Locked = 11,
 };
 
+/**
+ * Incremented every time a VMManager changes the page table. Host pointers cached from guest
+ * memory (see SharedMemoryView) compare against it to detect that they must be re-resolved.
+ */
+extern u32 g_page_table_generation;
+
 /**
  * Represents a VMA in an address space. A VMA is a contiguous region of virtual addressing space
  * with homogeneous attributes across its extents. In this particular implementation each VMA is
@@ -7,6 +7,7 @@
 #include "core/hle/hle.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/service/dsp_dsp.h"
+#include "core/hle/service/service_wrappers.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Namespace DSP_DSP
@@ -36,15 +37,11 @@ void SignalInterrupt() {
  *      1 : Result of function, 0 on success, otherwise error code
  *      2 : (inaddr << 1) + 0x1FF40000 (where 0x1FF00000 is the DSP RAM address)
  */
-static void ConvertProcessAddressFromDspDram(Service::Interface* self) {
-    u32* cmd_buff = Kernel::GetCommandBuffer();
-
-    u32 addr = cmd_buff[1];
-
-    cmd_buff[1] = 0; // No error
-    cmd_buff[2] = (addr << 1) + (Memory::DSP_RAM_VADDR + 0x40000);
+static ResultCode ConvertProcessAddressFromDspDram(u32* out_addr, u32 addr) {
+    *out_addr = (addr << 1) + (Memory::DSP_RAM_VADDR + 0x40000);
 
     LOG_WARNING(Service_DSP, "(STUBBED) called with address 0x%08X", addr);
+    return RESULT_SUCCESS;
 }
 
 /**
@@ -156,14 +153,11 @@ static void RegisterInterruptEvents(Service::Interface* self) {
  *  Outputs:
  *      1 : Result of function, 0 on success, otherwise error code
  */
-static void SetSemaphore(Service::Interface* self) {
-    u32* cmd_buff = Kernel::GetCommandBuffer();
-
+static ResultCode SetSemaphore(u32 value) {
     SignalInterrupt();
 
-    cmd_buff[1] = 0; // No error
-
-    LOG_WARNING(Service_DSP, "(STUBBED) called");
+    LOG_WARNING(Service_DSP, "(STUBBED) called value=0x%04X", value);
+    return RESULT_SUCCESS;
 }
 
 /**
@@ -243,14 +237,9 @@ static void ReadPipeIfPossible(Service::Interface* self) {
  *  Outputs:
  *      1 : Result of function, 0 on success, otherwise error code
  */
-static void SetSemaphoreMask(Service::Interface* self) {
-    u32* cmd_buff = Kernel::GetCommandBuffer();
-
-    u32 mask = cmd_buff[1];
-
-    cmd_buff[1] = RESULT_SUCCESS.raw; // No error
-
+static ResultCode SetSemaphoreMask(u32 mask) {
     LOG_WARNING(Service_DSP, "(STUBBED) called mask=0x%08X", mask);
+    return RESULT_SUCCESS;
 }
 
 /**
@@ -262,13 +251,11 @@ static void SetSemaphoreMask(Service::Interface* self) {
  *      2 : The headphone status response, 0 = Not using headphones?,
  *          1 = using headphones?
  */
-static void GetHeadphoneStatus(Service::Interface* self) {
-    u32* cmd_buff = Kernel::GetCommandBuffer();
-
-    cmd_buff[1] = RESULT_SUCCESS.raw; // No error
-    cmd_buff[2] = 0; // Not using headphones?
+static ResultCode GetHeadphoneStatus(u32* status) {
+    *status = 0; // Not using headphones?
 
     LOG_DEBUG(Service_DSP, "(STUBBED) called");
+    return RESULT_SUCCESS;
 }
 
 const Interface::FunctionInfo FunctionTable[] = {
@@ -278,12 +265,12 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x00040040, nullptr,                          "SendDataIsEmpty"},
     {0x000500C2, nullptr,                          "SendFifoEx"},
     {0x000600C0, nullptr,                          "RecvFifoEx"},
-    {0x00070040, SetSemaphore,                     "SetSemaphore"},
+    {0x00070040, Service::Wrap<SetSemaphore>,      "SetSemaphore"},
     {0x00080000, nullptr,                          "GetSemaphore"},
     {0x00090040, nullptr,                          "ClearSemaphore"},
     {0x000A0040, nullptr,                          "MaskSemaphore"},
     {0x000B0000, nullptr,                          "CheckSemaphoreRequest"},
-    {0x000C0040, ConvertProcessAddressFromDspDram, "ConvertProcessAddressFromDspDram"},
+    {0x000C0040, Service::Wrap<ConvertProcessAddressFromDspDram>, "ConvertProcessAddressFromDspDram"},
     {0x000D0082, WriteProcessPipe,                 "WriteProcessPipe"},
     {0x000E00C0, nullptr,                          "ReadPipe"},
     {0x000F0080, nullptr,                          "GetPipeReadableSize"},
@@ -294,7 +281,7 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x00140082, nullptr,                          "InvalidateDCache"},
     {0x00150082, RegisterInterruptEvents,          "RegisterInterruptEvents"},
     {0x00160000, GetSemaphoreEventHandle,          "GetSemaphoreEventHandle"},
-    {0x00170040, SetSemaphoreMask,                 "SetSemaphoreMask"},
+    {0x00170040, Service::Wrap<SetSemaphoreMask>,  "SetSemaphoreMask"},
     {0x00180040, nullptr,                          "GetPhysicalAddress"},
     {0x00190040, nullptr,                          "GetVirtualAddress"},
     {0x001A0042, nullptr,                          "SetIirFilterI2S1_cmd1"},
@@ -302,7 +289,7 @@ const Interface::FunctionInfo FunctionTable[] = {
     {0x001C0082, nullptr,                          "SetIirFilterEQ"},
     {0x001D00C0, nullptr,                          "ReadMultiEx_SPI2"},
     {0x001E00C2, nullptr,                          "WriteMultiEx_SPI2"},
-    {0x001F0000, GetHeadphoneStatus,               "GetHeadphoneStatus"},
+    {0x001F0000, Service::Wrap<GetHeadphoneStatus>, "GetHeadphoneStatus"},
     {0x00200040, nullptr,                          "ForceHeadphoneOut"},
     {0x00210000, nullptr,                          "GetIsDspOccupied"},
 };
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
+
 #include "common/bit_field.h"
 #include "common/microprofile.h"
 
@@ -38,24 +41,31 @@ Kernel::SharedPtr<Kernel::SharedMemory> g_shared_memory;
 /// Thread index into interrupt relay queue
 u32 g_thread_id = 0;
 
+/// Views of the per-thread structures in GSP shared memory
+static Kernel::SharedMemoryView<InterruptRelayQueue> interrupt_relay_queues;
+static Kernel::SharedMemoryView<FrameBufferUpdate> framebuffer_updates;
+static Kernel::SharedMemoryView<CommandBuffer> command_buffers;
+
+/// True while a batch of GX commands is being executed, during which interrupts are only queued
+static bool defer_interrupts = false;
+/// Interrupts raised while executing a batch of GX commands, posted together once it completes
+static std::vector<InterruptId> deferred_interrupts;
+
 /// Gets a pointer to a thread command buffer in GSP shared memory
-static inline u8* GetCommandBuffer(u32 thread_id) {
-    return g_shared_memory->GetPointer(0x800 + (thread_id * sizeof(CommandBuffer)));
+static inline CommandBuffer* GetCommandBuffer(u32 thread_id) {
+    return command_buffers.Get(thread_id);
 }
 
 FrameBufferUpdate* GetFrameBufferInfo(u32 thread_id, u32 screen_index) {
     DEBUG_ASSERT_MSG(screen_index < 2, "Invalid screen index");
 
     // For each thread there are two FrameBufferUpdate fields
-    u32 offset = 0x200 + (2 * thread_id + screen_index) * sizeof(FrameBufferUpdate);
-    u8* ptr = g_shared_memory->GetPointer(offset);
-    return reinterpret_cast<FrameBufferUpdate*>(ptr);
+    return framebuffer_updates.Get(2 * thread_id + screen_index);
 }
 
 /// Gets a pointer to the interrupt relay queue for a given thread index
 static inline InterruptRelayQueue* GetInterruptRelayQueue(u32 thread_id) {
-    u8* ptr = g_shared_memory->GetPointer(sizeof(InterruptRelayQueue) * thread_id);
-    return reinterpret_cast<InterruptRelayQueue*>(ptr);
+    return interrupt_relay_queues.Get(thread_id);
 }
 
 /**
@@ -313,6 +323,8 @@ static void RegisterInterruptRelayQueue(Service::Interface* self) {
     g_interrupt_event->Signal(); // TODO(bunnei): Is this correct?
 }
 
+static void RelayInterrupt(InterruptId interrupt_id);
+
 /**
  * Signals that the specified interrupt type has occurred to userland code
  * @param interrupt_id ID of interrupt that is being signalled
@@ -328,6 +340,19 @@ void SignalInterrupt(InterruptId interrupt_id) {
         LOG_WARNING(Service_GSP, "cannot synchronize until GSP shared memory has been created!");
         return;
     }
+    if (defer_interrupts) {
+        deferred_interrupts.push_back(interrupt_id);
+        return;
+    }
+    RelayInterrupt(interrupt_id);
+    g_interrupt_event->Signal();
+}
+
+/**
+ * Writes an interrupt into the relay queue of every GSP thread, without signalling the event
+ * @param interrupt_id ID of interrupt that is being relayed
+ */
+static void RelayInterrupt(InterruptId interrupt_id) {
     for (int thread_id = 0; thread_id < 0x4; ++thread_id) {
         InterruptRelayQueue* interrupt_relay_queue = GetInterruptRelayQueue(thread_id);
         u8 next = interrupt_relay_queue->index;
@@ -351,7 +376,6 @@ void SignalInterrupt(InterruptId interrupt_id) {
             }
         }
     }
-    g_interrupt_event->Signal();
 }
 
 /// Executes the next GSP command
@@ -507,22 +531,51 @@ static void SetLcdForceBlack(Service::Interface* self) {
     cmd_buff[1] = RESULT_SUCCESS.raw;
 }
 
+MICROPROFILE_DEFINE(GSP_CommandQueue, "GSP", "Command Queue", MP_RGB(100, 100, 200));
+
+/**
+ * Executes all GX commands pending in the command queue of a GSP thread. Interrupts raised by the
+ * commands are collected and relayed together once the whole queue has been drained, so that the
+ * interrupt event is only signalled once per batch.
+ */
+static void ExecuteCommandQueue(u32 thread_id) {
+    CommandBuffer* command_buffer = GetCommandBuffer(thread_id);
+    if (command_buffer == nullptr)
+        return;
+
+    const u32 num_commands = std::min<u32>(command_buffer->number_commands, ARRAY_SIZE(command_buffer->commands));
+    if (num_commands == 0)
+        return;
+
+    defer_interrupts = true;
+    for (u32 i = 0; i < num_commands; ++i) {
+        const Command& command = command_buffer->commands[i];
+        g_debugger.GXCommandProcessed((u8*)&command);
+
+        // Decode and execute command
+        ExecuteCommand(command, thread_id);
+    }
+    defer_interrupts = false;
+
+    // Indicates that all commands have completed
+    command_buffer->number_commands.Assign(0);
+
+    if (!deferred_interrupts.empty()) {
+        for (InterruptId interrupt_id : deferred_interrupts)
+            RelayInterrupt(interrupt_id);
+        deferred_interrupts.clear();
+
+        g_interrupt_event->Signal();
+    }
+}
+
 /// This triggers handling of the GX command written to the command buffer in shared memory.
 static void TriggerCmdReqQueue(Service::Interface* self) {
+    MICROPROFILE_SCOPE(GSP_CommandQueue);
+
     // Iterate through each thread's command queue...
     for (unsigned thread_id = 0; thread_id < 0x4; ++thread_id) {
-        CommandBuffer* command_buffer = (CommandBuffer*)GetCommandBuffer(thread_id);
-
-        // Iterate through each command...
-        for (unsigned i = 0; i < command_buffer->number_commands; ++i) {
-            g_debugger.GXCommandProcessed((u8*)&command_buffer->commands[i]);
-
-            // Decode and execute command
-            ExecuteCommand(command_buffer->commands[i], thread_id);
-
-            // Indicates that command has completed
-            command_buffer->number_commands = command_buffer->number_commands - 1;
-        }
+        ExecuteCommandQueue(thread_id);
     }
 
     u32* cmd_buff = Kernel::GetCommandBuffer();
@@ -621,10 +674,18 @@ Interface::Interface() {
     g_shared_memory = Kernel::SharedMemory::Create(0x1000, MemoryPermission::ReadWrite,
             MemoryPermission::ReadWrite, "GSPSharedMem");
 
+    interrupt_relay_queues = Kernel::SharedMemoryView<InterruptRelayQueue>(g_shared_memory, 0);
+    framebuffer_updates = Kernel::SharedMemoryView<FrameBufferUpdate>(g_shared_memory, 0x200);
+    command_buffers = Kernel::SharedMemoryView<CommandBuffer>(g_shared_memory, 0x800);
+
     g_thread_id = 0;
 }
 
 Interface::~Interface() {
+    interrupt_relay_queues = Kernel::SharedMemoryView<InterruptRelayQueue>();
+    framebuffer_updates = Kernel::SharedMemoryView<FrameBufferUpdate>();
+    command_buffers = Kernel::SharedMemoryView<CommandBuffer>();
+
     g_interrupt_event = nullptr;
     g_shared_memory = nullptr;
 }
@@ -24,6 +24,7 @@ static const int MAX_CIRCLEPAD_POS = 0x9C; ///< Max value for a circle pad posit
 
 // Handle to shared memory region designated to HID_User service
 static Kernel::SharedPtr<Kernel::SharedMemory> shared_mem;
+static Kernel::SharedMemoryView<SharedMem> shared_mem_view;
 
 // Event handles
 static Kernel::SharedPtr<Kernel::Event> event_pad_or_touch_1;
@@ -59,7 +60,7 @@ const std::array<Service::HID::PadState, Settings::NativeInput::NUM_INPUTS> pad_
 //     * Set PadData.current_state.circle_right = 1 if current PadEntry.circle_pad_y <= -41
 
 void Update() {
-    SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
+    SharedMem* mem = shared_mem_view.Get();
     const PadState state = VideoCore::g_emu_window->GetPadState();
 
     if (mem == nullptr) {
@@ -197,6 +198,7 @@ void Init() {
     using Kernel::MemoryPermission;
     shared_mem = SharedMemory::Create(0x1000, MemoryPermission::ReadWrite,
             MemoryPermission::Read, "HID:SharedMem");
+    shared_mem_view = SharedMemoryView<SharedMem>(shared_mem);
 
     next_pad_index = 0;
     next_touch_index = 0;
@@ -210,6 +212,7 @@ void Init() {
 }
 
 void Shutdown() {
+    shared_mem_view = Kernel::SharedMemoryView<SharedMem>();
     shared_mem = nullptr;
     event_pad_or_touch_1 = nullptr;
     event_pad_or_touch_2 = nullptr;
@@ -61,29 +61,53 @@ static std::string MakeFunctionString(const char* name, const char* port_name, c
 
 ResultVal<bool> Interface::SyncRequest() {
     u32* cmd_buff = Kernel::GetCommandBuffer();
-    auto itr = m_functions.find(cmd_buff[0]);
+    const FunctionInfo* info = FindFunction(cmd_buff[0]);
 
-    if (itr == m_functions.end() || itr->second.func == nullptr) {
-        std::string function_name = (itr == m_functions.end()) ? Common::StringFromFormat("0x%08X", cmd_buff[0]) : itr->second.name;
+    if (info == nullptr || info->func == nullptr) {
+        std::string function_name = (info == nullptr) ? Common::StringFromFormat("0x%08X", cmd_buff[0]) : info->name;
         LOG_ERROR(Service, "unknown / unimplemented %s", MakeFunctionString(function_name.c_str(), GetPortName().c_str(), cmd_buff).c_str());
 
         // TODO(bunnei): Hack - ignore error
         cmd_buff[1] = 0;
         return MakeResult<bool>(false);
     } else {
-        LOG_TRACE(Service, "%s", MakeFunctionString(itr->second.name, GetPortName().c_str(), cmd_buff).c_str());
+        LOG_TRACE(Service, "%s", MakeFunctionString(info->name, GetPortName().c_str(), cmd_buff).c_str());
     }
 
-    itr->second.func(this);
+    info->func(this);
 
     return MakeResult<bool>(false); // TODO: Implement return from actual function
 }
 
+const Interface::FunctionInfo* Interface::FindFunction(u32 header) const {
+    u32 command_id = GetCommandId(header);
+    if (command_id >= m_function_index.size())
+        return nullptr;
+
+    u16 index = m_function_index[command_id];
+    if (index == 0)
+        return nullptr;
+
+    // The parameter description in the lower half of the header must match as well
+    const FunctionInfo& info = m_functions[index - 1];
+    return (info.id == header) ? &info : nullptr;
+}
+
 void Interface::Register(const FunctionInfo* functions, size_t n) {
-    m_functions.reserve(n);
+    m_functions.reserve(m_functions.size() + n);
     for (size_t i = 0; i < n; ++i) {
-        // Usually this array is sorted by id already, so hint to instead at the end
-        m_functions.emplace_hint(m_functions.cend(), functions[i].id, functions[i]);
+        u32 command_id = GetCommandId(functions[i].id);
+        if (command_id >= m_function_index.size())
+            m_function_index.resize(command_id + 1, 0);
+
+        if (m_function_index[command_id] != 0) {
+            LOG_ERROR(Service, "%s: command 0x%08X registered twice, ignoring",
+                      GetPortName().c_str(), functions[i].id);
+            continue;
+        }
+
+        m_functions.push_back(functions[i]);
+        m_function_index[command_id] = static_cast<u16>(m_functions.size());
     }
 }
 
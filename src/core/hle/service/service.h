@@ -7,8 +7,7 @@
 #include <cstddef>
 #include <string>
 #include <unordered_map>
-
-#include <boost/container/flat_map.hpp>
+#include <vector>
 
 #include "common/common_types.h"
 
@@ -48,6 +47,15 @@ public:
 
     ResultVal<bool> SyncRequest() override;
 
+    /**
+     * Extracts the command ID (bits 31:16) from an IPC command header
+     * @param header IPC command header, as found in cmd_buff[0]
+     * @return Command ID used to index the function table
+     */
+    static constexpr u32 GetCommandId(u32 header) {
+        return header >> 16;
+    }
+
 protected:
 
     /**
@@ -61,7 +69,17 @@ protected:
     void Register(const FunctionInfo* functions, size_t n);
 
 private:
-    boost::container::flat_map<u32, FunctionInfo> m_functions;
+    /**
+     * Looks up the function registered for a command header
+     * @param header IPC command header, as found in cmd_buff[0]
+     * @return Pointer to the registered function info, or nullptr if the command isn't known
+     */
+    const FunctionInfo* FindFunction(u32 header) const;
+
+    /// Registered functions, stored in registration order
+    std::vector<FunctionInfo> m_functions;
+    /// Direct-indexed table mapping a command ID to its (1-based) index in m_functions, 0 if unused
+    std::vector<u16> m_function_index;
 
 };
 
@@ -0,0 +1,74 @@
+// Copyright 2015 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+#include "core/hle/kernel/session.h"
+#include "core/hle/result.h"
+#include "core/hle/service/service.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Namespace Service
+
+namespace Service {
+
+/**
+ * Typed wrappers for service functions, analogous to HLE::Wrap for SVCs. Normal parameters are read
+ * from cmd_buff[1] onwards in declaration order, the returned ResultCode is written to cmd_buff[1]
+ * and output (pointer) parameters are written from cmd_buff[2] onwards. Register the wrapper in a
+ * FunctionTable in place of a hand-written handler, e.g. `Service::Wrap<GetHeadphoneStatus>`.
+ */
+
+template<ResultCode func()> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    cmd_buff[1] = func().raw;
+}
+
+template<ResultCode func(u32)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    cmd_buff[1] = func(cmd_buff[1]).raw;
+}
+
+template<ResultCode func(u32, u32)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    cmd_buff[1] = func(cmd_buff[1], cmd_buff[2]).raw;
+}
+
+template<ResultCode func(u32, u32, u32)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    cmd_buff[1] = func(cmd_buff[1], cmd_buff[2], cmd_buff[3]).raw;
+}
+
+template<ResultCode func(u32*)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    u32 out_1 = 0;
+    cmd_buff[1] = func(&out_1).raw;
+    cmd_buff[2] = out_1;
+}
+
+template<ResultCode func(u32*, u32)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    u32 out_1 = 0;
+    cmd_buff[1] = func(&out_1, cmd_buff[1]).raw;
+    cmd_buff[2] = out_1;
+}
+
+template<ResultCode func(u32*, u32, u32)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    u32 out_1 = 0;
+    cmd_buff[1] = func(&out_1, cmd_buff[1], cmd_buff[2]).raw;
+    cmd_buff[2] = out_1;
+}
+
+template<ResultCode func(u32*, u32*)> void Wrap(Interface* self) {
+    u32* cmd_buff = Kernel::GetCommandBuffer();
+    u32 out_1 = 0, out_2 = 0;
+    cmd_buff[1] = func(&out_1, &out_2).raw;
+    cmd_buff[2] = out_1;
+    cmd_buff[3] = out_2;
+}
+
+} // namespace
@@ -3,16 +3,28 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/make_unique.h"
 #include "common/scope_exit.h"
+#include "common/thread.h"
 
+#include "core/core_timing.h"
 #include "core/hle/kernel/session.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 #include "core/memory.h"
@@ -42,6 +54,11 @@
     #include <unistd.h>
 #endif
 
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
 #ifdef _WIN32
 #    define WSAEAGAIN      WSAEWOULDBLOCK
 #    define WSAEMULTIHOP   -1 // Invalid dummy value
@@ -153,7 +170,7 @@ static int TranslateError(int error) {
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    bool blocking; ///< Whether the socket is blocking for the guest. Host sockets are always non-blocking.
 };
 
 /// Structure to represent the 3ds' pollfd structure, which is different than most implementations
@@ -304,6 +321,389 @@ static void CleanupSockets() {
     open_sockets.clear();
 }
 
+/// Returns whether the guest expects operations on the socket to block
+static bool IsBlocking(u32 socket_handle) {
+    auto iter = open_sockets.find(socket_handle);
+    return iter != open_sockets.end() && iter->second.blocking;
+}
+
+/// Returns whether a failed socket call only failed because it would have blocked
+static bool WouldBlock(int error) {
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK) || error == ERRNO(EINPROGRESS);
+}
+
+/// Puts a host socket into non-blocking mode, blocking is emulated by parking the guest thread instead
+static void SetHostNonBlocking(u32 socket_handle) {
+#ifdef _WIN32
+    unsigned long non_blocking = 1;
+    ioctlsocket(socket_handle, FIONBIO, &non_blocking);
+#else
+    int flags = ::fcntl(socket_handle, F_GETFL, 0);
+    if (flags != SOCKET_ERROR_VALUE)
+        ::fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+/// A socket and the poll events (POLLIN, POLLOUT, ...) that an operation is waiting for on it
+struct SocketWatch {
+    u32 socket_fd;
+    short events;
+};
+
+/**
+ * Waits on a dedicated host thread for the sockets of parked operations to become ready. Ready
+ * operations are reported back to the emulation thread through a CoreTiming event, so that they
+ * are only ever retried (and their guest threads resumed) from the emulation thread.
+ * Uses epoll on Linux, and falls back to polling with a short timeout on other platforms.
+ */
+class SocketReactor {
+public:
+    /// @param ready_event CoreTiming event to schedule when operations become ready
+    explicit SocketReactor(int ready_event);
+    ~SocketReactor();
+
+    /// Starts watching the given sockets on behalf of an operation. The operation becomes ready
+    /// (and all its watches are removed) as soon as any of them is signalled.
+    void Watch(u64 operation_id, const std::vector<SocketWatch>& socket_watches);
+
+    /// Stops watching the sockets of an operation.
+    void Cancel(u64 operation_id);
+
+    /// Makes all operations waiting on a socket ready, e.g. because the socket is being closed.
+    void Interrupt(u32 socket_fd);
+
+    /// Returns the operations that became ready since the last call.
+    std::vector<u64> TakeReadyOperations();
+
+private:
+    /// Operation waiting on a socket, and the events it is waiting for
+    using Waiter = std::pair<u64, short>;
+
+    void Run();
+    void MarkReady(u64 operation_id);
+    void UpdateInterest(u32 socket_fd);
+
+    std::mutex mutex;
+    std::unordered_map<u32, std::vector<Waiter>> waiters;
+    std::vector<u64> ready_operations;
+    bool running = true;
+    int ready_event;
+
+#ifdef __linux__
+    int epoll_fd;
+    int wake_fd;
+#endif
+
+    std::thread thread;
+};
+
+SocketReactor::SocketReactor(int ready_event) : ready_event(ready_event) {
+#ifdef __linux__
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    epoll_event wake = {};
+    wake.events = EPOLLIN;
+    wake.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake);
+#endif
+
+    thread = std::thread(&SocketReactor::Run, this);
+}
+
+SocketReactor::~SocketReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+#ifdef __linux__
+    u64 value = 1;
+    if (write(wake_fd, &value, sizeof(value)) != sizeof(value))
+        LOG_ERROR(Service_SOC, "Failed to wake the socket reactor");
+#endif
+
+    thread.join();
+
+#ifdef __linux__
+    close(wake_fd);
+    close(epoll_fd);
+#endif
+}
+
+void SocketReactor::Watch(u64 operation_id, const std::vector<SocketWatch>& socket_watches) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const SocketWatch& watch : socket_watches) {
+        waiters[watch.socket_fd].emplace_back(operation_id, watch.events);
+        UpdateInterest(watch.socket_fd);
+    }
+}
+
+void SocketReactor::Cancel(u64 operation_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& entry : waiters) {
+        auto& list = entry.second;
+        auto end = std::remove_if(list.begin(), list.end(),
+                [operation_id](const Waiter& waiter) { return waiter.first == operation_id; });
+        if (end != list.end()) {
+            list.erase(end, list.end());
+            UpdateInterest(entry.first);
+        }
+    }
+}
+
+void SocketReactor::Interrupt(u32 socket_fd) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto iter = waiters.find(socket_fd);
+    if (iter == waiters.end())
+        return;
+
+    std::vector<Waiter> interrupted = std::move(iter->second);
+    iter->second.clear();
+    UpdateInterest(socket_fd);
+
+    for (const Waiter& waiter : interrupted)
+        MarkReady(waiter.first);
+
+    if (!interrupted.empty())
+        CoreTiming::ScheduleEvent_Threadsafe_Immediate(ready_event);
+}
+
+std::vector<u64> SocketReactor::TakeReadyOperations() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<u64> ready;
+    ready.swap(ready_operations);
+    return ready;
+}
+
+/// Moves an operation to the ready list and removes its other watches. Must hold the mutex.
+void SocketReactor::MarkReady(u64 operation_id) {
+    ready_operations.push_back(operation_id);
+
+    for (auto& entry : waiters) {
+        auto& list = entry.second;
+        auto end = std::remove_if(list.begin(), list.end(),
+                [operation_id](const Waiter& waiter) { return waiter.first == operation_id; });
+        if (end != list.end()) {
+            list.erase(end, list.end());
+            UpdateInterest(entry.first);
+        }
+    }
+}
+
+/// Updates the host interest set of a socket after its waiters changed. Must hold the mutex.
+void SocketReactor::UpdateInterest(u32 socket_fd) {
+    auto iter = waiters.find(socket_fd);
+    short events = 0;
+    if (iter != waiters.end()) {
+        for (const Waiter& waiter : iter->second)
+            events |= waiter.second;
+    }
+
+#ifdef __linux__
+    epoll_event event = {};
+    event.data.fd = static_cast<int>(socket_fd);
+    if (events & POLLIN)
+        event.events |= EPOLLIN;
+    if (events & POLLPRI)
+        event.events |= EPOLLPRI;
+    if (events & POLLOUT)
+        event.events |= EPOLLOUT;
+
+    if (events == 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket_fd, &event);
+    } else if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &event) != 0 && errno == ENOENT) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &event);
+    }
+#endif
+
+    if (events == 0 && iter != waiters.end())
+        waiters.erase(iter);
+}
+
+void SocketReactor::Run() {
+    Common::SetCurrentThreadName("SocketReactor");
+
+    while (true) {
+        // Sockets that were signalled, and the poll events they were signalled with
+        std::vector<std::pair<u32, short>> signalled;
+
+#ifdef __linux__
+        std::array<epoll_event, 64> events;
+        int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd == wake_fd) {
+                u64 value;
+                if (read(wake_fd, &value, sizeof(value)) != sizeof(value))
+                    LOG_ERROR(Service_SOC, "Failed to reset the socket reactor wakeup event");
+                continue;
+            }
+
+            short revents = 0;
+            if (events[i].events & EPOLLIN)
+                revents |= POLLIN;
+            if (events[i].events & EPOLLPRI)
+                revents |= POLLPRI;
+            if (events[i].events & EPOLLOUT)
+                revents |= POLLOUT;
+            if (events[i].events & EPOLLERR)
+                revents |= POLLERR;
+            if (events[i].events & EPOLLHUP)
+                revents |= POLLHUP;
+            signalled.emplace_back(static_cast<u32>(events[i].data.fd), revents);
+        }
+#else
+        std::vector<pollfd> fds;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running)
+                return;
+
+            for (const auto& entry : waiters) {
+                pollfd fd = {};
+                fd.fd = entry.first;
+                for (const Waiter& waiter : entry.second)
+                    fd.events |= waiter.second & (POLLIN | POLLOUT);
+                fds.push_back(fd);
+            }
+        }
+
+        // There is no portable way to interrupt a poll from another thread, so wait with a short
+        // timeout to pick up newly watched sockets.
+        if (fds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        } else {
+            int count = poll(fds.data(), static_cast<unsigned long>(fds.size()), 10);
+            for (size_t i = 0; count > 0 && i < fds.size(); ++i) {
+                if (fds[i].revents != 0)
+                    signalled.emplace_back(static_cast<u32>(fds[i].fd), fds[i].revents);
+            }
+        }
+#endif
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+
+        bool any_ready = false;
+        for (const auto& socket : signalled) {
+            auto iter = waiters.find(socket.first);
+            if (iter == waiters.end())
+                continue;
+
+            // Errors and hangups complete every operation waiting on the socket
+            std::vector<u64> woken;
+            for (const Waiter& waiter : iter->second) {
+                if ((waiter.second | POLLERR | POLLHUP) & socket.second)
+                    woken.push_back(waiter.first);
+            }
+
+            for (u64 operation_id : woken)
+                MarkReady(operation_id);
+            any_ready |= !woken.empty();
+        }
+
+        if (any_ready)
+            CoreTiming::ScheduleEvent_Threadsafe_Immediate(ready_event);
+    }
+}
+
+/**
+ * Performs a socket command on behalf of a guest thread, writing the reply to `cmd_buffer`.
+ * @param cmd_buffer Command buffer of the guest thread that issued the command
+ * @param may_block Whether the command may still block. If false, it must reply even if nothing
+ *                  is available (e.g. once a Poll timeout has elapsed).
+ * @return false, without replying, if the command would block the guest thread
+ */
+using SocketOperation = bool (*)(u32* cmd_buffer, bool may_block);
+
+/// A socket command whose guest thread is parked until its sockets become ready
+struct PendingOperation {
+    Kernel::SharedPtr<Kernel::Thread> thread;
+    SocketOperation operation;
+    std::vector<SocketWatch> watches;
+};
+
+static std::unique_ptr<SocketReactor> reactor;
+static std::unordered_map<u64, PendingOperation> pending_operations;
+static u64 next_operation_id;
+
+static int operation_ready_event;   ///< CoreTiming event scheduled by the reactor
+static int operation_timeout_event; ///< CoreTiming event for Poll timeouts
+
+/**
+ * Parks the calling guest thread until one of `watches` becomes ready or `timeout_ns` has
+ * elapsed, after which `operation` is retried from the emulation thread.
+ */
+static void ParkCurrentThread(SocketOperation operation, std::vector<SocketWatch> watches, s64 timeout_ns = -1) {
+    const u64 operation_id = next_operation_id++;
+
+    reactor->Watch(operation_id, watches);
+    pending_operations.emplace(operation_id, PendingOperation{ Kernel::GetCurrentThread(), operation, std::move(watches) });
+
+    if (timeout_ns >= 0)
+        CoreTiming::ScheduleEvent(usToCycles(static_cast<s64>(timeout_ns / 1000)), operation_timeout_event, operation_id);
+
+    Kernel::WaitCurrentThread_Sleep();
+}
+
+/// Performs a socket command, parking the calling guest thread if it would block
+static void PerformOperation(SocketOperation operation, std::vector<SocketWatch> watches, s64 timeout_ns = -1) {
+    if (!operation(Kernel::GetCommandBuffer(), reactor != nullptr))
+        ParkCurrentThread(operation, std::move(watches), timeout_ns);
+}
+
+/// Retries a parked operation, and resumes its guest thread if it completes
+static void RetryOperation(u64 operation_id, bool timed_out) {
+    auto iter = pending_operations.find(operation_id);
+    if (iter == pending_operations.end())
+        return;
+
+    PendingOperation& pending = iter->second;
+    if (pending.thread->status != THREADSTATUS_WAIT_SLEEP) {
+        // The thread was stopped while it was waiting
+        reactor->Cancel(operation_id);
+        CoreTiming::UnscheduleEvent(operation_timeout_event, operation_id);
+        pending_operations.erase(iter);
+        return;
+    }
+
+    u32* cmd_buffer = reinterpret_cast<u32*>(Memory::GetPointer(pending.thread->GetTLSAddress() + Kernel::kCommandHeaderOffset));
+    if (!pending.operation(cmd_buffer, !timed_out)) {
+        // Spurious wakeup, keep waiting
+        reactor->Watch(operation_id, pending.watches);
+        return;
+    }
+
+    if (timed_out) {
+        reactor->Cancel(operation_id);
+    } else {
+        CoreTiming::UnscheduleEvent(operation_timeout_event, operation_id);
+    }
+
+    pending.thread->ResumeFromWait();
+    pending_operations.erase(iter);
+}
+
+static void OperationReadyCallback(u64 userdata, int cycles_late) {
+    if (reactor == nullptr)
+        return;
+
+    for (u64 operation_id : reactor->TakeReadyOperations())
+        RetryOperation(operation_id, false);
+}
+
+static void OperationTimeoutCallback(u64 operation_id, int cycles_late) {
+    if (reactor == nullptr)
+        return;
+
+    RetryOperation(operation_id, true);
+}
+
 static void Socket(Service::Interface* self) {
     u32* cmd_buffer = Kernel::GetCommandBuffer();
     u32 domain = cmd_buffer[1]; // Address family
@@ -328,13 +728,15 @@ static void Socket(Service::Interface* self) {
 
     u32 socket_handle = static_cast<u32>(::socket(domain, type, protocol));
 
-    if ((s32)socket_handle != SOCKET_ERROR_VALUE)
-        open_sockets[socket_handle] = { socket_handle, true };
-
     int result = 0;
     if ((s32)socket_handle == SOCKET_ERROR_VALUE)
         result = TranslateError(GET_ERRNO);
 
+    if ((s32)socket_handle != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(socket_handle);
+        open_sockets[socket_handle] = { socket_handle, true };
+    }
+
     cmd_buffer[0] = IPC::MakeHeader(2, 2, 0);
     cmd_buffer[1] = result;
     cmd_buffer[2] = socket_handle;
@@ -377,54 +779,20 @@ static void Fcntl(Service::Interface* self) {
             cmd_buffer[2] = posix_ret;
     });
 
+    auto iter = open_sockets.find(socket_handle);
+    if (iter == open_sockets.end()) {
+        result = TranslateError(ERRNO(EBADF));
+        posix_ret = -1;
+        return;
+    }
+
+    // The host socket always stays non-blocking, only the blocking mode seen by the guest changes
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
-        posix_ret = 0;
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end() && iter->second.blocking == false)
-            posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret = ::fcntl(socket_handle, F_GETFL, 0);
-        if (ret == SOCKET_ERROR_VALUE) {
-            result = TranslateError(GET_ERRNO);
-            posix_ret = -1;
-            return;
-        }
         posix_ret = 0;
-        if (ret & O_NONBLOCK)
+        if (!iter->second.blocking)
             posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp = (ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0;
-        int ret = ioctlsocket(socket_handle, FIONBIO, &tmp);
-        if (ret == SOCKET_ERROR_VALUE) {
-            result = TranslateError(GET_ERRNO);
-            posix_ret = -1;
-            return;
-        }
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags = ::fcntl(socket_handle, F_GETFL, 0);
-        if (flags == SOCKET_ERROR_VALUE) {
-            result = TranslateError(GET_ERRNO);
-            posix_ret = -1;
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret = ::fcntl(socket_handle, F_SETFL, flags);
-        if (ret == SOCKET_ERROR_VALUE) {
-            result = TranslateError(GET_ERRNO);
-            posix_ret = -1;
-            return;
-        }
-#endif
+        iter->second.blocking = (ctr_arg & 4 /* O_NONBLOCK */) == 0;
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command (%d) in fcntl call", ctr_cmd);
         result = TranslateError(EINVAL); // TODO: Find the correct error
@@ -448,23 +816,25 @@ static void Listen(Service::Interface* self) {
     cmd_buffer[2] = ret;
 }
 
-static void Accept(Service::Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static bool AcceptImpl(u32* cmd_buffer, bool may_block) {
     u32 socket_handle = cmd_buffer[1];
     socklen_t max_addr_len = static_cast<socklen_t>(cmd_buffer[2]);
     sockaddr addr;
     socklen_t addr_len = sizeof(addr);
     u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
+    int error = GET_ERRNO;
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(error) && IsBlocking(socket_handle))
+        return false;
+
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(ret);
         open_sockets[ret] = { ret, true };
+    }
 
     int result = 0;
     if ((s32)ret == SOCKET_ERROR_VALUE) {
-        result = TranslateError(GET_ERRNO);
+        result = TranslateError(error);
     } else {
         CTRSockAddr ctr_addr = CTRSockAddr::FromPlatform(addr);
         Memory::WriteBlock(cmd_buffer[0x104 >> 2], (const u8*)&ctr_addr, max_addr_len);
@@ -474,6 +844,12 @@ static void Accept(Service::Interface* self) {
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
     cmd_buffer[3] = IPC::StaticBufferDesc(static_cast<u32>(max_addr_len), 0);
+    return true;
+}
+
+static void Accept(Service::Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    PerformOperation(AcceptImpl, { { socket_handle, POLLIN } });
 }
 
 static void GetHostId(Service::Interface* self) {
@@ -501,6 +877,10 @@ static void Close(Service::Interface* self) {
     int ret = 0;
     open_sockets.erase(socket_handle);
 
+    // Threads blocked on the socket are resumed and see the error from their retried operation
+    if (reactor != nullptr)
+        reactor->Interrupt(socket_handle);
+
     ret = closesocket(socket_handle);
 
     int result = 0;
@@ -511,8 +891,7 @@ static void Close(Service::Interface* self) {
     cmd_buffer[1] = result;
 }
 
-static void SendTo(Service::Interface* self) {
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static bool SendToImpl(u32* cmd_buffer, bool may_block) {
     u32 socket_handle = cmd_buffer[1];
     u32 len = cmd_buffer[2];
     u32 flags = cmd_buffer[3];
@@ -523,7 +902,7 @@ static void SendTo(Service::Interface* self) {
 
     if (ctr_dest_addr == nullptr) {
         cmd_buffer[1] = -1; // TODO(Subv): Find the right error code
-        return;
+        return true;
     }
 
     int ret = -1;
@@ -533,31 +912,40 @@ static void SendTo(Service::Interface* self) {
     } else {
         ret = ::sendto(socket_handle, (const char*)input_buff, len, flags, nullptr, 0);
     }
+    int error = GET_ERRNO;
+
+    if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(error) && IsBlocking(socket_handle))
+        return false;
 
     int result = 0;
     if (ret == SOCKET_ERROR_VALUE)
-        result = TranslateError(GET_ERRNO);
+        result = TranslateError(error);
 
     cmd_buffer[2] = ret;
     cmd_buffer[1] = result;
+    return true;
 }
 
-static void RecvFrom(Service::Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static void SendTo(Service::Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    PerformOperation(SendToImpl, { { socket_handle, POLLOUT } });
+}
+
+static bool RecvFromImpl(u32* cmd_buffer, bool may_block) {
     u32 socket_handle = cmd_buffer[1];
     u32 len = cmd_buffer[2];
     u32 flags = cmd_buffer[3];
-    socklen_t addr_len = static_cast<socklen_t>(cmd_buffer[4]);
 
     u8* output_buff = Memory::GetPointer(cmd_buffer[0x104 >> 2]);
     sockaddr src_addr;
     socklen_t src_addr_len = sizeof(src_addr);
     int ret = ::recvfrom(socket_handle, (char*)output_buff, len, flags, &src_addr, &src_addr_len);
+    int error = GET_ERRNO;
+
+    if (ret == SOCKET_ERROR_VALUE && may_block && WouldBlock(error) && IsBlocking(socket_handle))
+        return false;
 
-    if (cmd_buffer[0x1A0 >> 2] != 0) {
+    if (ret != SOCKET_ERROR_VALUE && cmd_buffer[0x1A0 >> 2] != 0) {
         CTRSockAddr* ctr_src_addr = reinterpret_cast<CTRSockAddr*>(Memory::GetPointer(cmd_buffer[0x1A0 >> 2]));
         *ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
     }
@@ -565,17 +953,22 @@ static void RecvFrom(Service::Interface* self) {
     int result = 0;
     int total_received = ret;
     if (ret == SOCKET_ERROR_VALUE) {
-        result = TranslateError(GET_ERRNO);
+        result = TranslateError(error);
         total_received = 0;
     }
 
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
     cmd_buffer[3] = total_received;
+    return true;
 }
 
-static void Poll(Service::Interface* self) {
-    u32* cmd_buffer = Kernel::GetCommandBuffer();
+static void RecvFrom(Service::Interface* self) {
+    u32 socket_handle = Kernel::GetCommandBuffer()[1];
+    PerformOperation(RecvFromImpl, { { socket_handle, POLLIN } });
+}
+
+static bool PollImpl(u32* cmd_buffer, bool may_block) {
     u32 nfds = cmd_buffer[1];
     int timeout = cmd_buffer[2];
     CTRPollFD* input_fds = reinterpret_cast<CTRPollFD*>(Memory::GetPointer(cmd_buffer[6]));
@@ -583,24 +976,48 @@ static void Poll(Service::Interface* self) {
 
     // The 3ds_pollfd and the pollfd structures may be different (Windows/Linux have different sizes)
     // so we have to copy the data
-    pollfd* platform_pollfd = new pollfd[nfds];
+    std::vector<pollfd> platform_pollfd(nfds);
     for (unsigned current_fds = 0; current_fds < nfds; ++current_fds)
         platform_pollfd[current_fds] = CTRPollFD::ToPlatform(input_fds[current_fds]);
 
-    int ret = ::poll(platform_pollfd, nfds, timeout);
+    // The host poll never waits, waiting is done by parking the guest thread on the reactor
+    int ret = ::poll(platform_pollfd.data(), nfds, 0);
+    int error = GET_ERRNO;
+
+    if (ret == 0 && may_block && timeout != 0)
+        return false;
 
     // Now update the output pollfd structure
     for (unsigned current_fds = 0; current_fds < nfds; ++current_fds)
         output_fds[current_fds] = CTRPollFD::FromPlatform(platform_pollfd[current_fds]);
 
-    delete[] platform_pollfd;
-
     int result = 0;
     if (ret == SOCKET_ERROR_VALUE)
-        result = TranslateError(GET_ERRNO);
+        result = TranslateError(error);
 
     cmd_buffer[1] = result;
     cmd_buffer[2] = ret;
+    return true;
+}
+
+/**
+ * SOC_U::Poll service function. This is also what select() is built on in the 3DS socket library,
+ * so it is the only readiness query the service needs to provide.
+ */
+static void Poll(Service::Interface* self) {
+    u32* cmd_buffer = Kernel::GetCommandBuffer();
+    u32 nfds = cmd_buffer[1];
+    int timeout = cmd_buffer[2];
+    CTRPollFD* input_fds = reinterpret_cast<CTRPollFD*>(Memory::GetPointer(cmd_buffer[6]));
+
+    std::vector<SocketWatch> watches;
+    for (unsigned current_fds = 0; current_fds < nfds; ++current_fds) {
+        const CTRPollFD& fd = input_fds[current_fds];
+        watches.push_back({ fd.fd, static_cast<short>(CTRPollFD::Events::TranslateToPlatform(fd.events)) });
+    }
+
+    // A negative timeout waits indefinitely
+    PerformOperation(PollImpl, std::move(watches), timeout < 0 ? -1 : timeout * 1000000LL);
 }
 
 static void GetSockName(Service::Interface* self) {
@@ -668,13 +1085,32 @@ static void GetPeerName(Service::Interface* self) {
     cmd_buffer[1] = result;
 }
 
+/// Replies to a Connect on a blocking socket once the host connection attempt has finished
+static bool FinishConnect(u32* cmd_buffer, bool may_block) {
+    u32 socket_handle = cmd_buffer[1];
+
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+    int ret = ::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, (char*)&error, &error_len);
+    if (ret != 0) {
+        error = GET_ERRNO;
+    } else if (error != 0) {
+        ret = SOCKET_ERROR_VALUE;
+    }
+
+    int result = 0;
+    if (ret != 0)
+        result = TranslateError(error);
+
+    cmd_buffer[0] = IPC::MakeHeader(6, 2, 0);
+    cmd_buffer[1] = result;
+    cmd_buffer[2] = ret;
+    return true;
+}
+
 static void Connect(Service::Interface* self) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     u32* cmd_buffer = Kernel::GetCommandBuffer();
     u32 socket_handle = cmd_buffer[1];
-    socklen_t len = cmd_buffer[2];
 
     CTRSockAddr* ctr_input_addr = reinterpret_cast<CTRSockAddr*>(Memory::GetPointer(cmd_buffer[6]));
     if (ctr_input_addr == nullptr) {
@@ -684,9 +1120,17 @@ static void Connect(Service::Interface* self) {
 
     sockaddr input_addr = CTRSockAddr::ToPlatform(*ctr_input_addr);
     int ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
+    int error = GET_ERRNO;
+
+    // The host socket is non-blocking, so the connection completes asynchronously
+    if (ret != 0 && WouldBlock(error) && IsBlocking(socket_handle) && reactor != nullptr) {
+        ParkCurrentThread(FinishConnect, { { socket_handle, POLLOUT } });
+        return;
+    }
+
     int result = 0;
     if (ret != 0)
-        result = TranslateError(GET_ERRNO);
+        result = TranslateError(error);
 
     cmd_buffer[0] = IPC::MakeHeader(6, 2, 0);
     cmd_buffer[1] = result;
@@ -756,9 +1200,17 @@ const Interface::FunctionInfo FunctionTable[] = {
 
 Interface::Interface() {
     Register(FunctionTable);
+
+    operation_ready_event = CoreTiming::RegisterEvent("SOC_U::OperationReady", OperationReadyCallback);
+    operation_timeout_event = CoreTiming::RegisterEvent("SOC_U::OperationTimeout", OperationTimeoutCallback);
+
+    next_operation_id = 0;
+    reactor = Common::make_unique<SocketReactor>(operation_ready_event);
 }
 
 Interface::~Interface() {
+    reactor.reset();
+    pending_operations.clear();
     CleanupSockets();
 #ifdef _WIN32
     WSACleanup();
@@ -2,14 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <numeric>
 #include <type_traits>
+#include <vector>
+
+#ifdef ARCHITECTURE_x86_64
+#include <smmintrin.h>
+#endif
 
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/math_util.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 
 #include "core/settings.h"
@@ -17,7 +25,6 @@
 #include "core/core_timing.h"
 
 #include "core/hle/service/gsp_gpu.h"
-#include "core/hle/service/dsp_dsp.h"
 #include "core/hle/service/hid/hid.h"
 
 #include "core/hw/hw.h"
@@ -63,29 +70,312 @@ inline void Read(T &var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Math::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
+/// Decodes and encodes the pixels of a display transfer format
+template <Regs::PixelFormat format>
+struct PixelCodec;
+
+template <>
+struct PixelCodec<Regs::PixelFormat::RGBA8> {
+    static const u32 bytes_per_pixel = 4;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGBA8(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGBA8(color, bytes); }
+};
+
+template <>
+struct PixelCodec<Regs::PixelFormat::RGB8> {
+    static const u32 bytes_per_pixel = 3;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB8(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB8(color, bytes); }
+};
+
+template <>
+struct PixelCodec<Regs::PixelFormat::RGB565> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB565(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB565(color, bytes); }
+};
+
+template <>
+struct PixelCodec<Regs::PixelFormat::RGB5A1> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB5A1(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB5A1(color, bytes); }
+};
+
+template <>
+struct PixelCodec<Regs::PixelFormat::RGBA4> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGBA4(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGBA4(color, bytes); }
+};
+
+template <Regs::PixelFormat format>
+static void DecodeRow(const u8* source, Math::Vec4<u8>* colors, u32 width) {
+    for (u32 x = 0; x < width; ++x)
+        colors[x] = PixelCodec<format>::Decode(source + x * PixelCodec<format>::bytes_per_pixel);
+}
 
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
+template <Regs::PixelFormat format>
+static void EncodeRow(const Math::Vec4<u8>* colors, u8* dest, u32 width) {
+    for (u32 x = 0; x < width; ++x)
+        PixelCodec<format>::Encode(colors[x], dest + x * PixelCodec<format>::bytes_per_pixel);
+}
 
-    case Regs::PixelFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
+#ifdef ARCHITECTURE_x86_64
 
-    case Regs::PixelFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
+// RGBA8 pixels are stored as ABGR, so converting them from and to RGBA byte order reverses each pixel
+template <>
+void DecodeRow<Regs::PixelFormat::RGBA8>(const u8* source, Math::Vec4<u8>* colors, u32 width) {
+    const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    u32 x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + x), _mm_shuffle_epi8(pixels, shuffle));
+    }
+    for (; x < width; ++x)
+        colors[x] = Color::DecodeRGBA8(source + x * 4);
+}
+
+template <>
+void EncodeRow<Regs::PixelFormat::RGBA8>(const Math::Vec4<u8>* colors, u8* dest, u32 width) {
+    const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    u32 x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_shuffle_epi8(pixels, shuffle));
+    }
+    for (; x < width; ++x)
+        Color::EncodeRGBA8(colors[x], dest + x * 4);
+}
+
+// Four RGB8 pixels take up 12 bytes, which are loaded and stored as 8 + 4 bytes to stay in the row
+template <>
+void DecodeRow<Regs::PixelFormat::RGB8>(const u8* source, Math::Vec4<u8>* colors, u32 width) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const __m128i opaque = _mm_set1_epi32(0xFF000000);
+    u32 x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const u8* pixels = source + x * 3;
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels));
+        bytes = _mm_insert_epi32(bytes, *reinterpret_cast<const u32*>(pixels + 8), 2);
+        __m128i result = _mm_or_si128(_mm_shuffle_epi8(bytes, shuffle), opaque);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + x), result);
+    }
+    for (; x < width; ++x)
+        colors[x] = Color::DecodeRGB8(source + x * 3);
+}
+
+template <>
+void EncodeRow<Regs::PixelFormat::RGB8>(const Math::Vec4<u8>* colors, u8* dest, u32 width) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128);
+    u32 x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + x));
+        __m128i bytes = _mm_shuffle_epi8(pixels, shuffle);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x * 3), bytes);
+        *reinterpret_cast<u32*>(dest + x * 3 + 8) = _mm_extract_epi32(bytes, 2);
+    }
+    for (; x < width; ++x)
+        Color::EncodeRGB8(colors[x], dest + x * 3);
+}
+
+#endif // ARCHITECTURE_x86_64
+
+/// Averages each horizontal pair of pixels of `row` into `output`, which is `width` pixels wide
+static void DownscaleRowX(const Math::Vec4<u8>* row, Math::Vec4<u8>* output, u32 width) {
+    u32 x = 0;
+#ifdef ARCHITECTURE_x86_64
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 2 <= width; x += 2) {
+        // Widen the four input pixels to 16 bits per channel and add up the pairs
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 2 * x));
+        __m128i left = _mm_unpacklo_epi8(pixels, zero);
+        __m128i right = _mm_unpackhi_epi8(pixels, zero);
+        __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+        __m128i result = _mm_packus_epi16(_mm_srli_epi16(sums, 1), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + x), result);
+    }
+#endif
+    for (; x < width; ++x)
+        output[x] = ((row[2 * x] + row[2 * x + 1]) / 2).Cast<u8>();
+}
+
+/// Averages each 2x2 block of pixels of the rows `row0` and `row1` into `output`
+static void DownscaleRowXY(const Math::Vec4<u8>* row0, const Math::Vec4<u8>* row1, Math::Vec4<u8>* output, u32 width) {
+    u32 x = 0;
+#ifdef ARCHITECTURE_x86_64
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 2 <= width; x += 2) {
+        __m128i pixels0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x));
+        __m128i pixels1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x));
+        __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(pixels0, zero), _mm_unpacklo_epi8(pixels1, zero));
+        __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(pixels0, zero), _mm_unpackhi_epi8(pixels1, zero));
+        __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+        __m128i result = _mm_packus_epi16(_mm_srli_epi16(sums, 2), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + x), result);
+    }
+#endif
+    for (; x < width; ++x)
+        output[x] = (((row0[2 * x] + row0[2 * x + 1]) + (row1[2 * x] + row1[2 * x + 1])) / 4).Cast<u8>();
+}
+
+/// Layout and size of the surfaces of a display transfer
+struct DisplayTransferParams {
+    const u8* input;
+    u8* output;
+    u32 input_width;   ///< Width of the input surface, which sets its row/tile row stride
+    u32 output_width;
+    u32 output_height;
+    bool input_tiled;
+    bool output_tiled;
+    bool flip_vertically;
+    u32 scale_x;       ///< Log2 of the horizontal downscaling factor
+    u32 scale_y;       ///< Log2 of the vertical downscaling factor
+};
+
+/// Output rows are converted in bands of whole tile rows
+static const u32 TRANSFER_BAND_HEIGHT = 8;
+
+/**
+ * Runs the display transfer for output rows [first_band * 8, last_band * 8). Each band of rows
+ * is gathered from the input into linear rows, then converted a row at a time and finally
+ * written to the output, swizzling it if needed.
+ */
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format>
+static void DisplayTransferBands(const DisplayTransferParams& params, u32 first_band, u32 last_band) {
+    const u32 input_bpp = PixelCodec<input_format>::bytes_per_pixel;
+    const u32 output_bpp = PixelCodec<output_format>::bytes_per_pixel;
+    // Pixels with the same format need no conversion unless they are averaged
+    const bool copy_pixels = input_format == output_format && params.scale_x == 0;
+
+    const u32 input_row_pixels = params.output_width << params.scale_x;
+    const int input_stride = params.input_width * input_bpp;
+    const int linear_input_stride = input_row_pixels * input_bpp;
+    const int output_stride = params.output_width * output_bpp;
+
+    std::vector<u8> linear_input(params.input_tiled ? (TRANSFER_BAND_HEIGHT << params.scale_y) * linear_input_stride : 0);
+    std::vector<u8> linear_output(params.output_tiled ? TRANSFER_BAND_HEIGHT * output_stride : 0);
+    std::vector<Math::Vec4<u8>> colors(2 * input_row_pixels + params.output_width);
+    Math::Vec4<u8>* const row0_colors = colors.data();
+    Math::Vec4<u8>* const row1_colors = row0_colors + input_row_pixels;
+    Math::Vec4<u8>* const scaled_colors = row1_colors + input_row_pixels;
+
+    for (u32 band = first_band; band < last_band; ++band) {
+        const u32 first_row = band * TRANSFER_BAND_HEIGHT;
+        const u32 num_rows = std::min(params.output_height - first_row, TRANSFER_BAND_HEIGHT);
+        const u32 first_input_row = first_row << params.scale_y;
+        const u32 num_input_rows = num_rows << params.scale_y;
+
+        // Gather the input rows, untiling them into a linear buffer if needed. Only the pixels
+        // that contribute to the output are untiled.
+        const u8* input_rows = params.input + first_input_row * input_stride;
+        int input_rows_stride = input_stride;
+        if (params.input_tiled) {
+            for (u32 y = 0; y < num_input_rows; y += 8) {
+                VideoCore::TiledToLinear(input_rows + y * input_stride, &linear_input[y * linear_input_stride],
+                                         linear_input_stride, input_row_pixels, std::min(num_input_rows - y, 8u),
+                                         input_bpp);
+            }
+            input_rows = linear_input.data();
+            input_rows_stride = linear_input_stride;
+        }
+
+        for (u32 y = 0; y < num_rows; ++y) {
+            const u8* input_row = input_rows + (y << params.scale_y) * input_rows_stride;
+
+            u8* output_row;
+            if (params.output_tiled) {
+                output_row = &linear_output[y * output_stride];
+            } else {
+                const u32 output_y = params.flip_vertically ? params.output_height - 1 - (first_row + y) : first_row + y;
+                output_row = params.output + output_y * output_stride;
+            }
+
+            if (copy_pixels) {
+                std::memcpy(output_row, input_row, output_stride);
+                continue;
+            }
+
+            DecodeRow<input_format>(input_row, row0_colors, input_row_pixels);
+            const Math::Vec4<u8>* output_colors = row0_colors;
+            if (params.scale_y) {
+                DecodeRow<input_format>(input_row + input_rows_stride, row1_colors, input_row_pixels);
+                DownscaleRowXY(row0_colors, row1_colors, scaled_colors, params.output_width);
+                output_colors = scaled_colors;
+            } else if (params.scale_x) {
+                DownscaleRowX(row0_colors, scaled_colors, params.output_width);
+                output_colors = scaled_colors;
+            }
+            EncodeRow<output_format>(output_colors, output_row, params.output_width);
+        }
+
+        if (!params.output_tiled)
+            continue;
+
+        // Swizzle the band into the output. When flipping, the band lands on whole tile rows only
+        // if the output height is a multiple of the tile size.
+        if (!params.flip_vertically) {
+            VideoCore::LinearToTiled(linear_output.data(), output_stride, params.output + first_row * output_stride,
+                                     params.output_width, num_rows, output_bpp);
+        } else if ((params.output_height - first_row - num_rows) % 8 == 0) {
+            const u32 output_y = params.output_height - first_row - num_rows;
+            VideoCore::LinearToTiled(&linear_output[(num_rows - 1) * output_stride], -output_stride,
+                                     params.output + output_y * output_stride, params.output_width, num_rows,
+                                     output_bpp);
+        } else {
+            for (u32 y = 0; y < num_rows; ++y) {
+                const u32 output_y = params.output_height - 1 - (first_row + y);
+                const u32 coarse_y = output_y & ~7;
+                for (u32 x = 0; x < params.output_width; ++x) {
+                    u32 offset = VideoCore::GetMortonOffset(x, output_y, output_bpp) + coarse_y * output_stride;
+                    std::memcpy(params.output + offset, &linear_output[y * output_stride + x * output_bpp], output_bpp);
+                }
+            }
+        }
+    }
+}
+
+using DisplayTransferFunction = void(const DisplayTransferParams& params, u32 first_band, u32 last_band);
 
+template <Regs::PixelFormat input_format>
+static DisplayTransferFunction* GetDisplayTransferFunction(Regs::PixelFormat output_format) {
+    switch (output_format) {
+    case Regs::PixelFormat::RGBA8:
+        return DisplayTransferBands<input_format, Regs::PixelFormat::RGBA8>;
+    case Regs::PixelFormat::RGB8:
+        return DisplayTransferBands<input_format, Regs::PixelFormat::RGB8>;
+    case Regs::PixelFormat::RGB565:
+        return DisplayTransferBands<input_format, Regs::PixelFormat::RGB565>;
+    case Regs::PixelFormat::RGB5A1:
+        return DisplayTransferBands<input_format, Regs::PixelFormat::RGB5A1>;
     case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
+        return DisplayTransferBands<input_format, Regs::PixelFormat::RGBA4>;
+    default:
+        return nullptr;
+    }
+}
 
+/// Returns the converter for the given formats, or nullptr if either of them is invalid
+static DisplayTransferFunction* GetDisplayTransferFunction(Regs::PixelFormat input_format, Regs::PixelFormat output_format) {
+    switch (input_format) {
+    case Regs::PixelFormat::RGBA8:
+        return GetDisplayTransferFunction<Regs::PixelFormat::RGBA8>(output_format);
+    case Regs::PixelFormat::RGB8:
+        return GetDisplayTransferFunction<Regs::PixelFormat::RGB8>(output_format);
+    case Regs::PixelFormat::RGB565:
+        return GetDisplayTransferFunction<Regs::PixelFormat::RGB565>(output_format);
+    case Regs::PixelFormat::RGB5A1:
+        return GetDisplayTransferFunction<Regs::PixelFormat::RGB5A1>(output_format);
+    case Regs::PixelFormat::RGBA4:
+        return GetDisplayTransferFunction<Regs::PixelFormat::RGBA4>(output_format);
     default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format %x", input_format);
-        return {0, 0, 0, 0};
+        return nullptr;
     }
 }
 
+/// Transfers with at least this many output pixels are split across the worker threads
+static const u32 MIN_THREADED_TRANSFER_PIXELS = 64 * 1024;
+
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -223,6 +513,13 @@ inline void Write(u32 addr, const T data) {
                 break;
             }
 
+            DisplayTransferFunction* transfer = GetDisplayTransferFunction(config.input_format, config.output_format);
+            if (transfer == nullptr) {
+                LOG_ERROR(HW_GPU, "Unknown display transfer formats %x -> %x",
+                          config.input_format.Value(), config.output_format.Value());
+                break;
+            }
+
             bool horizontal_scale = config.scaling != config.NoScale;
             bool vertical_scale = config.scaling == config.ScaleXY;
 
@@ -234,100 +531,34 @@ inline void Write(u32 addr, const T data) {
 
             VideoCore::g_renderer->rasterizer->FlushRegion(config.GetPhysicalInputAddress(), input_size);
 
-            for (u32 y = 0; y < output_height; ++y) {
-                for (u32 x = 0; x < output_width; ++x) {
-                    Math::Vec4<u8> src_color;
-
-                    // Calculate the [x,y] position of the input image
-                    // based on the current output position and the scale
-                    u32 input_x = x << horizontal_scale;
-                    u32 input_y = y << vertical_scale;
-
-                    if (config.flip_vertically) {
-                        // Flip the y value of the output data,
-                        // we do this after calculating the [x,y] position of the input image
-                        // to account for the scaling options.
-                        y = output_height - y - 1;
-                    }
-
-                    u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-                    u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-                    u32 src_offset;
-                    u32 dst_offset;
-
-                    if (config.input_linear) {
-                        if (!config.dont_swizzle) {
-                            // Interpret the input as linear and the output as tiled
-                            u32 coarse_y = y & ~7;
-                            u32 stride = output_width * dst_bytes_per_pixel;
-
-                            src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                            dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + coarse_y * stride;
-                        } else {
-                           // Both input and output are linear
-                            src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                            dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
-                        }
-                    } else {
-                        if (!config.dont_swizzle) {
-                            // Interpret the input as tiled and the output as linear
-                            u32 coarse_y = input_y & ~7;
-                            u32 stride = config.input_width * src_bytes_per_pixel;
-
-                            src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + coarse_y * stride;
-                            dst_offset = (x + y * output_width) * dst_bytes_per_pixel;
-                        } else {
-                            // Both input and output are tiled
-                            u32 out_coarse_y = y & ~7;
-                            u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                            u32 in_coarse_y = input_y & ~7;
-                            u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                            src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) + in_coarse_y * in_stride;
-                            dst_offset = VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel) + out_coarse_y * out_stride;
-                        }
-                    }
-
-                    const u8* src_pixel = src_pointer + src_offset;
-                    src_color = DecodePixel(config.input_format, src_pixel);
-                    if (config.scaling == config.ScaleX) {
-                        Math::Vec4<u8> pixel = DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                        src_color = ((src_color + pixel) / 2).Cast<u8>();
-                    } else if (config.scaling == config.ScaleXY) {
-                        Math::Vec4<u8> pixel1 = DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                        Math::Vec4<u8> pixel2 = DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                        Math::Vec4<u8> pixel3 = DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                        src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-                    }
-
-                    u8* dst_pixel = dst_pointer + dst_offset;
-                    switch (config.output_format) {
-                    case Regs::PixelFormat::RGBA8:
-                        Color::EncodeRGBA8(src_color, dst_pixel);
-                        break;
-
-                    case Regs::PixelFormat::RGB8:
-                        Color::EncodeRGB8(src_color, dst_pixel);
-                        break;
-
-                    case Regs::PixelFormat::RGB565:
-                        Color::EncodeRGB565(src_color, dst_pixel);
-                        break;
-
-                    case Regs::PixelFormat::RGB5A1:
-                        Color::EncodeRGB5A1(src_color, dst_pixel);
-                        break;
-
-                    case Regs::PixelFormat::RGBA4:
-                        Color::EncodeRGBA4(src_color, dst_pixel);
-                        break;
-
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format %x", config.output_format.Value());
-                        break;
-                    }
-                }
+            DisplayTransferParams params;
+            params.input = src_pointer;
+            params.output = dst_pointer;
+            params.input_width = config.input_width;
+            params.output_width = output_width;
+            params.output_height = output_height;
+            // Swizzling converts linear input to tiled output and vice versa
+            params.input_tiled = !config.input_linear;
+            params.output_tiled = config.input_linear != config.dont_swizzle;
+            // Flipping writes converted row y to output row (output_height - 1 - y)
+            params.flip_vertically = config.flip_vertically != 0;
+            params.scale_x = horizontal_scale;
+            params.scale_y = vertical_scale;
+
+            // Bands of output rows are independent, unless the transfer works in place
+            const u32 num_bands = (output_height + TRANSFER_BAND_HEIGHT - 1) / TRANSFER_BAND_HEIGHT;
+            Common::ThreadPool* workers = VideoCore::GetWorkerThreads();
+            if (workers != nullptr && output_width * output_height >= MIN_THREADED_TRANSFER_PIXELS &&
+                !MathUtil::IntervalsIntersect(config.GetPhysicalInputAddress(), input_size,
+                                              config.GetPhysicalOutputAddress(), output_size)) {
+                const unsigned num_tasks = std::min(workers->GetNumThreads(), num_bands);
+                const u32 bands_per_task = (num_bands + num_tasks - 1) / num_tasks;
+                workers->ParallelFor(num_tasks, [&](unsigned task) {
+                    const u32 first_band = task * bands_per_task;
+                    transfer(params, first_band, std::min(first_band + bands_per_task, num_bands));
+                });
+            } else {
+                transfer(params, 0, num_bands);
             }
 
             LOG_TRACE(HW_GPU, "DisplayTriggerTransfer: 0x%08x bytes from 0x%08x(%ux%u)-> 0x%08x(%ux%u), dst format %x, flags 0x%08X",
@@ -414,11 +645,6 @@ static void VBlankCallback(u64 userdata, int cycles_late) {
     GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PDC0);
     GSP_GPU::SignalInterrupt(GSP_GPU::InterruptId::PDC1);
 
-    // TODO(bunnei): Fake a DSP interrupt on each frame. This does not belong here, but
-    // until we can emulate DSP interrupts, this is probably the only reasonable place to do
-    // this. Certain games expect this to be periodically signaled.
-    DSP_DSP::SignalInterrupt();
-
     // Check for user input updates
     Service::HID::Update();
 
@@ -55,11 +55,16 @@ struct Values {
     // Renderer
     bool use_hw_renderer;
     bool use_shader_jit;
+    bool use_shader_jit_fma;
+    int shader_threading_min_vertices;
 
     float bg_red;
     float bg_green;
     float bg_blue;
 
+    // Audio
+    std::string sink_id;
+
     std::string log_filter;
 
     // Debugging
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "audio_core/audio_core.h"
+
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/system.h"
@@ -9,6 +11,7 @@
 #include "core/hle/hle.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
+#include "core/settings.h"
 
 #include "video_core/video_core.h"
 
@@ -24,11 +27,14 @@ void Init(EmuWindow* emu_window) {
     Kernel::Init();
     HLE::Init();
     VideoCore::Init(emu_window);
+    AudioCore::Init();
+    AudioCore::SelectSink(Settings::values.sink_id);
     GDBStub::Init();
 }
 
 void Shutdown() {
     GDBStub::Shutdown();
+    AudioCore::Shutdown();
     VideoCore::Shutdown();
     HLE::Shutdown();
     Kernel::Shutdown();
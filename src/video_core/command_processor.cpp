@@ -2,11 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
-#include <boost/range/algorithm/fill.hpp>
+#include <vector>
 
 #include "common/microprofile.h"
 #include "common/profiler.h"
+#include "common/thread_pool.h"
 
 #include "core/settings.h"
 #include "core/hle/service/gsp_gpu.h"
@@ -17,6 +19,7 @@
 #include "video_core/pica.h"
 #include "video_core/primitive_assembly.h"
 #include "video_core/renderer_base.h"
+#include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/shader/shader_interpreter.h"
@@ -35,6 +38,8 @@ static u32 default_attr_write_buffer[3];
 
 Common::Profiling::TimingCategory category_drawing("Drawing");
 
+static VertexCacheStatistics vertex_cache_statistics;
+
 // Expand a 4-bit mask to 4-byte mask, e.g. 0b0101 -> 0x00FF00FF
 static const u32 expand_bits_to_bytes[] = {
     0x00000000, 0x000000ff, 0x0000ff00, 0x0000ffff,
@@ -137,37 +142,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             if (g_debug_context)
                 g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
-            const auto& attribute_config = regs.vertex_attributes;
-            const u32 base_address = attribute_config.GetPhysicalBaseAddress();
-
-            // Information about internal vertex attributes
-            u32 vertex_attribute_sources[16];
-            boost::fill(vertex_attribute_sources, 0xdeadbeef);
-            u32 vertex_attribute_strides[16] = {};
-            Regs::VertexAttributeFormat vertex_attribute_formats[16] = {};
-
-            u32 vertex_attribute_elements[16] = {};
-            u32 vertex_attribute_element_size[16] = {};
-
-            // Setup attribute data from loaders
-            for (int loader = 0; loader < 12; ++loader) {
-                const auto& loader_config = attribute_config.attribute_loaders[loader];
-
-                u32 load_address = base_address + loader_config.data_offset;
-
-                // TODO: What happens if a loader overwrites a previous one's data?
-                for (unsigned component = 0; component < loader_config.component_count; ++component) {
-                    if (component >= 12)
-                        LOG_ERROR(HW_GPU, "Overflow in the vertex attribute loader %u trying to load component %u", loader, component);
-                    u32 attribute_index = loader_config.GetComponent(component);
-                    vertex_attribute_sources[attribute_index] = load_address;
-                    vertex_attribute_strides[attribute_index] = static_cast<u32>(loader_config.byte_count);
-                    vertex_attribute_formats[attribute_index] = attribute_config.GetFormat(attribute_index);
-                    vertex_attribute_elements[attribute_index] = attribute_config.GetNumElements(attribute_index);
-                    vertex_attribute_element_size[attribute_index] = attribute_config.GetElementSizeInBytes(attribute_index);
-                    load_address += attribute_config.GetStride(attribute_index);
-                }
-            }
+            const u32 base_address = regs.vertex_attributes.GetPhysicalBaseAddress();
+
+            VertexLoader loader;
+            loader.Setup(regs);
 
             // Load vertices
             bool is_indexed = (id == PICA_REG_INDEX(trigger_draw_indexed));
@@ -195,155 +173,146 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 }
             }
 
-            class {
-                /// Combine overlapping and close ranges
-                void SimplifyRanges() {
-                    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
-                        // NOTE: We add 32 to the range end address to make sure "close" ranges are combined, too
-                        auto it2 = std::next(it);
-                        while (it2 != ranges.end() && it->first + it->second + 32 >= it2->first) {
-                            it->second = std::max(it->second, it2->first + it2->second - it->first);
-                            it2 = ranges.erase(it2);
-                        }
-                    }
-                }
-
-            public:
-                /// Record a particular memory access in the list
-                void AddAccess(u32 paddr, u32 size) {
-                    // Create new range or extend existing one
-                    ranges[paddr] = std::max(ranges[paddr], size);
-
-                    // Simplify ranges...
-                    SimplifyRanges();
-                }
-
-                /// Map of accessed ranges (mapping start address to range size)
-                std::map<u32, u32> ranges;
-            } memory_accesses;
-
-            // Simple circular-replacement vertex cache
-            // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-            const size_t VERTEX_CACHE_SIZE = 32;
-            std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-            std::array<Shader::OutputVertex, VERTEX_CACHE_SIZE> vertex_cache;
-
-            unsigned int vertex_cache_pos = 0;
-            vertex_cache_ids.fill(-1);
+            DebugUtils::MemoryAccessTracker memory_accesses;
 
             Shader::UnitState<false> shader_unit;
             Shader::Setup(shader_unit);
 
-            for (unsigned int index = 0; index < regs.num_vertices; ++index)
-            {
+            auto GetVertex = [&](unsigned int index) -> unsigned int {
                 // Indexed rendering doesn't use the start offset
-                unsigned int vertex = is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
+                return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index]) : (index + regs.vertex_offset);
+            };
 
-                // -1 is a common special value used for primitive restart. Since it's unknown if
-                // the PICA supports it, and it would mess up the caching, guard against it here.
-                ASSERT(vertex != -1);
+            auto LoadVertex = [&](unsigned int index, unsigned int vertex, Shader::InputVertex& input,
+                                  DebugUtils::MemoryAccessTracker& accesses) {
+                // Initialize data for the current vertex
+                loader.LoadVertex(index, vertex, input, accesses);
 
-                bool vertex_cache_hit = false;
-                Shader::OutputVertex output;
+                if (g_debug_context)
+                    g_debug_context->OnEvent(DebugContext::Event::VertexLoaded, (void*)&input);
+
+#if PICA_DUMP_GEOMETRY
+                // NOTE: When dumping geometry, we simply assume that the first input attribute
+                //       corresponds to the position for now.
+                DebugUtils::GeometryDumper::Vertex dumped_vertex = {
+                    input.attr[0][0].ToFloat32(), input.attr[0][1].ToFloat32(), input.attr[0][2].ToFloat32()
+                };
+                using namespace std::placeholders;
+                dumping_primitive_assembler.SubmitVertex(dumped_vertex,
+                                                         std::bind(&DebugUtils::GeometryDumper::AddTriangle,
+                                                                   &geometry_dumper, _1, _2, _3));
+#endif
+            };
+
+            // Send to renderer
+            using Pica::Shader::OutputVertex;
+            auto AddTriangle = [](
+                    const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+                VideoCore::g_renderer->rasterizer->AddTriangle(v0, v1, v2);
+            };
+
+            // Indices of the vertices which need to be shaded, in the order they are first used.
+            // Scratch storage is kept around to avoid allocating per draw.
+            static std::vector<unsigned int> shaded_indices;
+            static std::vector<OutputVertex> shaded_vertices;
+
+            // For indexed draws, maps each referenced vertex to its position in shaded_indices
+            static const u32 VERTEX_NOT_SEEN = 0xFFFFFFFF;
+            static std::vector<u32> vertex_slots;
+            unsigned int min_vertex = 0;
+
+            shaded_indices.clear();
+            if (is_indexed && regs.num_vertices != 0) {
+                // Pre-pass over the index buffer: find the range of referenced vertices so that a
+                // flat table can map each of them to its shaded output.
+                min_vertex = GetVertex(0);
+                unsigned int max_vertex = min_vertex;
+                for (unsigned int index = 0; index < regs.num_vertices; ++index) {
+                    unsigned int vertex = GetVertex(index);
+
+                    // -1 is a common special value used for primitive restart. Since it's unknown if
+                    // the PICA supports it, and it would mess up the caching, guard against it here.
+                    ASSERT(vertex != -1);
+
+                    min_vertex = std::min(min_vertex, vertex);
+                    max_vertex = std::max(max_vertex, vertex);
 
-                if (is_indexed) {
                     if (g_debug_context && Pica::g_debug_context->recorder) {
                         int size = index_u16 ? 2 : 1;
                         memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
                     }
-
-                    for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                        if (vertex == vertex_cache_ids[i]) {
-                            output = vertex_cache[i];
-                            vertex_cache_hit = true;
-                            break;
-                        }
-                    }
                 }
 
-                if (!vertex_cache_hit) {
-                    // Initialize data for the current vertex
-                    Shader::InputVertex input;
-
-                    for (int i = 0; i < attribute_config.GetNumTotalAttributes(); ++i) {
-                        if (vertex_attribute_elements[i] != 0) {
-                            // Default attribute values set if array elements have < 4 components. This
-                            // is *not* carried over from the default attribute settings even if they're
-                            // enabled for this attribute.
-                            static const float24 zero = float24::FromFloat32(0.0f);
-                            static const float24 one = float24::FromFloat32(1.0f);
-                            input.attr[i] = Math::Vec4<float24>(zero, zero, zero, one);
-
-                            // Load per-vertex data from the loader arrays
-                            for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                                u32 source_addr = vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex + comp * vertex_attribute_element_size[i];
-                                const u8* srcdata = Memory::GetPhysicalPointer(source_addr);
-
-                                if (g_debug_context && Pica::g_debug_context->recorder) {
-                                    memory_accesses.AddAccess(source_addr,
-                                        (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::FLOAT) ? 4
-                                        : (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::SHORT) ? 2 : 1);
-                                }
-
-                                const float srcval = (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::BYTE) ? *(s8*)srcdata :
-                                    (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::UBYTE) ? *(u8*)srcdata :
-                                    (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::SHORT) ? *(s16*)srcdata :
-                                    *(float*)srcdata;
-
-                                input.attr[i][comp] = float24::FromFloat32(srcval);
-                                LOG_TRACE(HW_GPU, "Loaded component %x of attribute %x for vertex %x (index %x) from 0x%08x + 0x%08x + 0x%04x: %f",
-                                    comp, i, vertex, index,
-                                    attribute_config.GetPhysicalBaseAddress(),
-                                    vertex_attribute_sources[i] - base_address,
-                                    vertex_attribute_strides[i] * vertex + comp * vertex_attribute_element_size[i],
-                                    input.attr[i][comp].ToFloat32());
-                            }
-                        } else if (attribute_config.IsDefaultAttribute(i)) {
-                            // Load the default attribute if we're configured to do so
-                            input.attr[i] = g_state.vs.default_attributes[i];
-                            LOG_TRACE(HW_GPU, "Loaded default attribute %x for vertex %x (index %x): (%f, %f, %f, %f)",
-                                      i, vertex, index,
-                                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-                        } else {
-                            // TODO(yuriks): In this case, no data gets loaded and the vertex
-                            // remains with the last value it had. This isn't currently maintained
-                            // as global state, however, and so won't work in Citra yet.
-                        }
+                // Collect the unique vertices in order of first use, remembering where each of them
+                // was first referenced.
+                vertex_slots.assign(max_vertex - min_vertex + 1, VERTEX_NOT_SEEN);
+                for (unsigned int index = 0; index < regs.num_vertices; ++index) {
+                    u32& slot = vertex_slots[GetVertex(index) - min_vertex];
+                    if (slot == VERTEX_NOT_SEEN) {
+                        slot = static_cast<u32>(shaded_indices.size());
+                        shaded_indices.push_back(index);
                     }
+                }
 
-                    if (g_debug_context)
-                        g_debug_context->OnEvent(DebugContext::Event::VertexLoaded, (void*)&input);
+                vertex_cache_statistics.num_indices += regs.num_vertices;
+                vertex_cache_statistics.num_unique_vertices += shaded_indices.size();
+            } else {
+                for (unsigned int index = 0; index < regs.num_vertices; ++index)
+                    shaded_indices.push_back(index);
+            }
 
-#if PICA_DUMP_GEOMETRY
-                    // NOTE: When dumping geometry, we simply assume that the first input attribute
-                    //       corresponds to the position for now.
-                    DebugUtils::GeometryDumper::Vertex dumped_vertex = {
-                        input.attr[0][0].ToFloat32(), input.attr[0][1].ToFloat32(), input.attr[0][2].ToFloat32()
-                    };
-                    using namespace std::placeholders;
-                    dumping_primitive_assembler.SubmitVertex(dumped_vertex,
-                                                             std::bind(&DebugUtils::GeometryDumper::AddTriangle,
-                                                                       &geometry_dumper, _1, _2, _3));
-#endif
-                    // Send to vertex shader
-                    output = Shader::Run(shader_unit, input, attribute_config.GetNumTotalAttributes());
+            // Loads and shades the given range of shaded_indices, in batches
+            auto ShadeVertices = [&](Shader::UnitState<false>& unit, DebugUtils::MemoryAccessTracker& accesses,
+                                     size_t begin, size_t end) {
+                for (size_t first = begin; first < end; first += Shader::BATCH_SIZE) {
+                    int count = static_cast<int>(std::min<size_t>(Shader::BATCH_SIZE, end - first));
 
-                    if (is_indexed) {
-                        vertex_cache[vertex_cache_pos] = output;
-                        vertex_cache_ids[vertex_cache_pos] = vertex;
-                        vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    Shader::InputVertex inputs[Shader::BATCH_SIZE];
+                    for (int i = 0; i < count; ++i) {
+                        unsigned int index = shaded_indices[first + i];
+                        LoadVertex(index, GetVertex(index), inputs[i], accesses);
                     }
-                }
 
-                // Send to renderer
-                using Pica::Shader::OutputVertex;
-                auto AddTriangle = [](
-                        const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
-                    VideoCore::g_renderer->rasterizer->AddTriangle(v0, v1, v2);
-                };
+                    // Send to vertex shader
+                    Shader::RunBatch(unit, inputs, &shaded_vertices[first], count, loader.GetNumTotalAttributes());
+                }
+            };
+
+            shaded_vertices.resize(shaded_indices.size());
+
+            // Large draws are split across worker threads, each with its own shader unit. The debug
+            // context expects to observe the vertices one after another, so it forces a single thread.
+            const int min_threaded_vertices = Settings::values.shader_threading_min_vertices;
+            bool threaded = !PICA_DUMP_GEOMETRY && g_debug_context == nullptr && min_threaded_vertices > 0 &&
+                            shaded_indices.size() >= static_cast<size_t>(min_threaded_vertices);
+
+            Common::ThreadPool* workers = threaded ? VideoCore::GetWorkerThreads() : nullptr;
+            if (workers != nullptr) {
+                // The compiled shaders set up above are shared; only the register state is per thread
+                static std::vector<Shader::UnitState<false>> worker_units;
+                worker_units.resize(workers->GetNumThreads());
+
+                // Split the vertices evenly, keeping the ranges aligned to whole batches
+                const size_t num_batches = (shaded_indices.size() + Shader::BATCH_SIZE - 1) / Shader::BATCH_SIZE;
+                const size_t batches_per_task = (num_batches + worker_units.size() - 1) / worker_units.size();
+                const size_t vertices_per_task = batches_per_task * Shader::BATCH_SIZE;
+
+                workers->ParallelFor(static_cast<unsigned>(worker_units.size()), [&](unsigned task) {
+                    size_t begin = std::min(task * vertices_per_task, shaded_indices.size());
+                    size_t end = std::min(begin + vertices_per_task, shaded_indices.size());
+
+                    // Memory accesses are only tracked for the recorder, which isn't active here
+                    DebugUtils::MemoryAccessTracker unused_accesses;
+                    ShadeVertices(worker_units[task], unused_accesses, begin, end);
+                });
+            } else {
+                ShadeVertices(shader_unit, memory_accesses, 0, shaded_indices.size());
+            }
 
-                primitive_assembler.SubmitVertex(output, AddTriangle);
+            // Assemble primitives from the shaded vertices, in draw order
+            for (unsigned int index = 0; index < regs.num_vertices; ++index) {
+                u32 slot = is_indexed ? vertex_slots[GetVertex(index) - min_vertex] : index;
+                primitive_assembler.SubmitVertex(shaded_vertices[slot], AddTriangle);
             }
 
             for (auto& range : memory_accesses.ranges) {
@@ -474,6 +443,14 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed, reinterpret_cast<void*>(&id));
 }
 
+const VertexCacheStatistics& GetVertexCacheStatistics() {
+    return vertex_cache_statistics;
+}
+
+void ResetVertexCacheStatistics() {
+    vertex_cache_statistics = {};
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
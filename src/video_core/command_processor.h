@@ -35,6 +35,30 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/// Counters for the reuse of shaded vertices in indexed draws
+struct VertexCacheStatistics {
+    /// Number of indices processed by indexed draws
+    u64 num_indices = 0;
+    /// Number of vertices which actually had to be shaded for those indices
+    u64 num_unique_vertices = 0;
+
+    /// Fraction of indices whose vertex had already been shaded earlier in the same draw
+    float GetHitRate() const {
+        return num_indices != 0 ? 1.0f - GetUniqueVertexRatio() : 0.0f;
+    }
+
+    /// Fraction of indices which referenced a vertex for the first time in their draw
+    float GetUniqueVertexRatio() const {
+        return num_indices != 0 ? static_cast<float>(num_unique_vertices) / num_indices : 0.0f;
+    }
+};
+
+/// Returns the vertex cache counters accumulated since the last reset
+const VertexCacheStatistics& GetVertexCacheStatistics();
+
+/// Resets the vertex cache counters
+void ResetVertexCacheStatistics();
+
 void ProcessCommandList(const u32* list, u32 size);
 
 } // namespace
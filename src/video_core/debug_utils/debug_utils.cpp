@@ -11,6 +11,10 @@
 #include <mutex>
 #include <string>
 
+#ifdef ARCHITECTURE_x86_64
+#include <smmintrin.h>
+#endif
+
 #ifdef HAVE_PNG
 #include <png.h>
 #endif
@@ -20,6 +24,7 @@
 
 #include "common/assert.h"
 #include "common/color.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/math_util.h"
@@ -355,6 +360,111 @@ std::unique_ptr<PicaTrace> FinishPicaTracing()
     return std::move(ret);
 }
 
+/// Encoded colors of a 4x4 subtile of an ETC1 texture
+union ETC1Tile {
+    // Each of these two is a collection of 16 bits (one per lookup value)
+    BitField< 0, 16, u64> table_subindexes;
+    BitField<16, 16, u64> negation_flags;
+
+    unsigned GetTableSubIndex(unsigned index) const {
+        return (table_subindexes >> index) & 1;
+    }
+
+    bool GetNegationFlag(unsigned index) const {
+        return ((negation_flags >> index) & 1) == 1;
+    }
+
+    BitField<32, 1, u64> flip;
+    BitField<33, 1, u64> differential_mode;
+
+    BitField<34, 3, u64> table_index_2;
+    BitField<37, 3, u64> table_index_1;
+
+    union {
+        // delta value + base value
+        BitField<40, 3, s64> db;
+        BitField<43, 5, u64> b;
+
+        BitField<48, 3, s64> dg;
+        BitField<51, 5, u64> g;
+
+        BitField<56, 3, s64> dr;
+        BitField<59, 5, u64> r;
+    } differential;
+
+    union {
+        BitField<40, 4, u64> b2;
+        BitField<44, 4, u64> b1;
+
+        BitField<48, 4, u64> g2;
+        BitField<52, 4, u64> g1;
+
+        BitField<56, 4, u64> r2;
+        BitField<60, 4, u64> r1;
+    } separate;
+
+    /**
+     * Returns one of the colors the texels of the subtile can have
+     * @param second_half Whether the color is for the second half of the subtile
+     * @param sub_index,negate Modifier of the texel within the half
+     */
+    const Math::Vec3<u8> GetColor(bool second_half, unsigned sub_index, bool negate) const {
+        // Lookup base value
+        Math::Vec3<int> ret;
+        if (differential_mode) {
+            ret.r() = static_cast<int>(differential.r);
+            ret.g() = static_cast<int>(differential.g);
+            ret.b() = static_cast<int>(differential.b);
+            if (second_half) {
+                ret.r() += static_cast<int>(differential.dr);
+                ret.g() += static_cast<int>(differential.dg);
+                ret.b() += static_cast<int>(differential.db);
+            }
+            ret.r() = Color::Convert5To8(ret.r());
+            ret.g() = Color::Convert5To8(ret.g());
+            ret.b() = Color::Convert5To8(ret.b());
+        } else {
+            if (!second_half) {
+                ret.r() = Color::Convert4To8(static_cast<u8>(separate.r1));
+                ret.g() = Color::Convert4To8(static_cast<u8>(separate.g1));
+                ret.b() = Color::Convert4To8(static_cast<u8>(separate.b1));
+            } else {
+                ret.r() = Color::Convert4To8(static_cast<u8>(separate.r2));
+                ret.g() = Color::Convert4To8(static_cast<u8>(separate.g2));
+                ret.b() = Color::Convert4To8(static_cast<u8>(separate.b2));
+            }
+        }
+
+        // Add modifier
+        unsigned table_index = static_cast<int>(!second_half ? table_index_1.Value() : table_index_2.Value());
+
+        static const std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
+            {{  2,  8 }}, {{  5, 17 }}, {{  9,  29 }}, {{ 13,  42 }},
+            {{ 18, 60 }}, {{ 24, 80 }}, {{ 33, 106 }}, {{ 47, 183 }}
+        }};
+
+        int modifier = etc1_modifier_table.at(table_index).at(sub_index);
+        if (negate)
+            modifier *= -1;
+
+        ret.r() = MathUtil::Clamp(ret.r() + modifier, 0, 255);
+        ret.g() = MathUtil::Clamp(ret.g() + modifier, 0, 255);
+        ret.b() = MathUtil::Clamp(ret.b() + modifier, 0, 255);
+
+        return ret.Cast<u8>();
+    }
+
+    /// Returns whether the texel at the given subtile coordinates is in the second half
+    bool IsInSecondHalf(int x, int y) const {
+        return (flip ? y : x) >= 2;
+    }
+
+    const Math::Vec3<u8> GetRGB(int x, int y) const {
+        int texel = 4 * x + y;
+        return GetColor(IsInSecondHalf(x, y), GetTableSubIndex(texel), GetNegationFlag(texel));
+    }
+};
+
 const Math::Vec4<u8> LookupTexture(const u8* source, int x, int y, const TextureInfo& info, bool disable_alpha) {
     const unsigned int coarse_x = x & ~7;
     const unsigned int coarse_y = y & ~7;
@@ -496,109 +606,303 @@ const Math::Vec4<u8> LookupTexture(const u8* source, int x, int y, const Texture
             source_ptr++;
         }
 
-        union ETC1Tile {
-            // Each of these two is a collection of 16 bits (one per lookup value)
-            BitField< 0, 16, u64> table_subindexes;
-            BitField<16, 16, u64> negation_flags;
+        const ETC1Tile* etc1_tile = reinterpret_cast<const ETC1Tile*>(source_ptr);
 
-            unsigned GetTableSubIndex(unsigned index) const {
-                return (table_subindexes >> index) & 1;
-            }
+        alpha >>= 4 * ((x & 3) * 4 + (y & 3));
+        return Math::MakeVec(etc1_tile->GetRGB(x & 3, y & 3),
+                             disable_alpha ? (u8)255 : Color::Convert4To8(alpha & 0xF));
+    }
 
-            bool GetNegationFlag(unsigned index) const {
-                return ((negation_flags >> index) & 1) == 1;
-            }
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: %x", (u32)info.format);
+        DEBUG_ASSERT(false);
+        return {};
+    }
+}
 
-            BitField<32, 1, u64> flip;
-            BitField<33, 1, u64> differential_mode;
+/// Number of texels in the 8x8 tiles textures are made of
+static const int TILE_TEXELS = 64;
 
-            BitField<34, 3, u64> table_index_2;
-            BitField<37, 3, u64> table_index_1;
+/// Decodes an 8x8 tile of an ETC1 or ETC1A4 texture to `texels` in Morton order
+static void DecodeETC1Tile(const u8* source, bool has_alpha, bool disable_alpha, Math::Vec4<u8>* texels) {
+    const u64* source_ptr = reinterpret_cast<const u64*>(source);
 
-            union {
-                // delta value + base value
-                BitField<40, 3, s64> db;
-                BitField<43, 5, u64> b;
+    // The four 4x4 subtiles are stored one after another
+    for (int subtile = 0; subtile < 4; ++subtile) {
+        u64 alpha = 0xFFFFFFFFFFFFFFFF;
+        if (has_alpha) {
+            alpha = *source_ptr;
+            source_ptr++;
+        }
+        const ETC1Tile* etc1_tile = reinterpret_cast<const ETC1Tile*>(source_ptr);
+        source_ptr++;
+
+        // Rather than decoding each texel separately, decode the four colors of each half once
+        Math::Vec3<u8> colors[2][4];
+        for (int half = 0; half < 2; ++half) {
+            for (int modifier = 0; modifier < 4; ++modifier)
+                colors[half][modifier] = etc1_tile->GetColor(half == 1, modifier & 1, modifier >= 2);
+        }
 
-                BitField<48, 3, s64> dg;
-                BitField<51, 5, u64> g;
+        const int subtile_x = (subtile & 1) * 4;
+        const int subtile_y = (subtile / 2) * 4;
+        for (int x = 0; x < 4; ++x) {
+            for (int y = 0; y < 4; ++y) {
+                int texel = 4 * x + y;
+                int modifier = etc1_tile->GetTableSubIndex(texel) + (etc1_tile->GetNegationFlag(texel) ? 2 : 0);
+                const Math::Vec3<u8>& rgb = colors[etc1_tile->IsInSecondHalf(x, y)][modifier];
+                u8 a = disable_alpha ? 255 : Color::Convert4To8((alpha >> (4 * texel)) & 0xF);
 
-                BitField<56, 3, s64> dr;
-                BitField<59, 5, u64> r;
-            } differential;
+                texels[VideoCore::MortonInterleave(subtile_x + x, subtile_y + y)] = Math::MakeVec(rgb, a);
+            }
+        }
+    }
+}
 
-            union {
-                BitField<40, 4, u64> b2;
-                BitField<44, 4, u64> b1;
+#ifdef ARCHITECTURE_x86_64
+/**
+ * Stores the 16 texels built from the 16 bytes of `values`. `shuffle` selects the bytes of the
+ * first four texels from the first four values.
+ */
+static void StoreExpandedBytes(__m128i values, __m128i shuffle, __m128i alpha, Math::Vec4<u8>* texels) {
+    for (int i = 0; i < 4; ++i) {
+        __m128i texel_shuffle = _mm_add_epi8(shuffle, _mm_set1_epi8(4 * i));
+        __m128i result = _mm_or_si128(_mm_shuffle_epi8(values, texel_shuffle), alpha);
+        _mm_store_si128(reinterpret_cast<__m128i*>(texels + 4 * i), result);
+    }
+}
 
-                BitField<48, 4, u64> g2;
-                BitField<52, 4, u64> g1;
+/**
+ * Decodes an 8x8 tile to `texels` in Morton order, several texels at a time. Since the texels of
+ * a tile are stored in Morton order, too, this is a plain conversion of consecutive texels.
+ * @return Whether the format is supported
+ */
+static bool DecodeTileSSE(const u8* source, Regs::TextureFormat format, bool disable_alpha, Math::Vec4<u8>* texels) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(0xFF000000);
+    // Forced alpha of the formats which have an alpha channel
+    const __m128i alpha = disable_alpha ? opaque : zero;
+
+    auto Load = [source](int offset) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+    };
+    auto Store = [texels](int index, __m128i value) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(texels + index), value);
+    };
+    // Loads four 16-bit texels, zero-extended to 32 bits
+    auto Load16 = [source](int index) {
+        return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + index * 2)));
+    };
+    auto And = [](__m128i value, u32 mask) { return _mm_and_si128(value, _mm_set1_epi32(mask)); };
+
+    // Shuffles which expand (alpha, intensity) byte pairs to {i, i, i, a} and {i, a, 0, 0} texels
+    const __m128i ia_shuffle = _mm_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6);
+    const __m128i ia_split_shuffle = _mm_setr_epi8(1, 0, -128, -128, 3, 2, -128, -128,
+                                                   5, 4, -128, -128, 7, 6, -128, -128);
+    // Shuffles which expand bytes to {v, v, v, 0} and {0, 0, 0, v} texels
+    const __m128i intensity_shuffle = _mm_setr_epi8(0, 0, 0, -128, 1, 1, 1, -128, 2, 2, 2, -128, 3, 3, 3, -128);
+    const __m128i alpha_shuffle = _mm_setr_epi8(-128, -128, -128, 0, -128, -128, -128, 1,
+                                                -128, -128, -128, 2, -128, -128, -128, 3);
+    const __m128i ia_pair_shuffle = disable_alpha ? ia_split_shuffle : ia_shuffle;
+    const __m128i a_shuffle = disable_alpha ? intensity_shuffle : alpha_shuffle;
+
+    switch (format) {
+    case Regs::TextureFormat::RGBA8:
+    {
+        const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for (int i = 0; i < TILE_TEXELS; i += 4)
+            Store(i, _mm_or_si128(_mm_shuffle_epi8(Load(i * 4), shuffle), alpha));
+        return true;
+    }
 
-                BitField<56, 4, u64> r2;
-                BitField<60, 4, u64> r1;
-            } separate;
+    case Regs::TextureFormat::RGB8:
+    {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+        // 16 texels are exactly three loads
+        for (int i = 0; i < TILE_TEXELS; i += 16) {
+            __m128i a = Load(i * 3);
+            __m128i b = Load(i * 3 + 16);
+            __m128i c = Load(i * 3 + 32);
+            Store(i,      _mm_or_si128(_mm_shuffle_epi8(a, shuffle), opaque));
+            Store(i + 4,  _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), opaque));
+            Store(i + 8,  _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), opaque));
+            Store(i + 12, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), opaque));
+        }
+        return true;
+    }
 
-            const Math::Vec3<u8> GetRGB(int x, int y) const {
-                int texel = 4 * x + y;
+    case Regs::TextureFormat::RGB5A1:
+        for (int i = 0; i < TILE_TEXELS; i += 4) {
+            __m128i pixel = Load16(i);
+            // Gather the 5-bit components in the bytes they end up in, then expand them to 8 bits
+            __m128i rgb = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(pixel, 11),
+                                                    And(_mm_slli_epi32(pixel, 2), 0x1F00)),
+                                       And(_mm_slli_epi32(pixel, 15), 0x1F0000));
+            rgb = _mm_or_si128(And(_mm_slli_epi32(rgb, 3), 0xF8F8F8), And(_mm_srli_epi32(rgb, 2), 0x070707));
+            __m128i a = disable_alpha ? opaque : _mm_and_si128(_mm_sub_epi32(zero, And(pixel, 1)), opaque);
+            Store(i, _mm_or_si128(rgb, a));
+        }
+        return true;
 
-                if (flip)
-                    std::swap(x, y);
-
-                // Lookup base value
-                Math::Vec3<int> ret;
-                if (differential_mode) {
-                    ret.r() = static_cast<int>(differential.r);
-                    ret.g() = static_cast<int>(differential.g);
-                    ret.b() = static_cast<int>(differential.b);
-                    if (x >= 2) {
-                        ret.r() += static_cast<int>(differential.dr);
-                        ret.g() += static_cast<int>(differential.dg);
-                        ret.b() += static_cast<int>(differential.db);
-                    }
-                    ret.r() = Color::Convert5To8(ret.r());
-                    ret.g() = Color::Convert5To8(ret.g());
-                    ret.b() = Color::Convert5To8(ret.b());
-                } else {
-                    if (x < 2) {
-                        ret.r() = Color::Convert4To8(static_cast<u8>(separate.r1));
-                        ret.g() = Color::Convert4To8(static_cast<u8>(separate.g1));
-                        ret.b() = Color::Convert4To8(static_cast<u8>(separate.b1));
-                    } else {
-                        ret.r() = Color::Convert4To8(static_cast<u8>(separate.r2));
-                        ret.g() = Color::Convert4To8(static_cast<u8>(separate.g2));
-                        ret.b() = Color::Convert4To8(static_cast<u8>(separate.b2));
-                    }
-                }
+    case Regs::TextureFormat::RGB565:
+        for (int i = 0; i < TILE_TEXELS; i += 4) {
+            __m128i pixel = Load16(i);
+            __m128i rgb = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(pixel, 11),
+                                                    And(_mm_slli_epi32(pixel, 3), 0x3F00)),
+                                       And(_mm_slli_epi32(pixel, 16), 0x1F0000));
+            __m128i rb = _mm_or_si128(And(_mm_slli_epi32(rgb, 3), 0xF800F8), And(_mm_srli_epi32(rgb, 2), 0x070007));
+            __m128i g = _mm_or_si128(And(_mm_slli_epi32(rgb, 2), 0xFC00), And(_mm_srli_epi32(rgb, 4), 0x0300));
+            Store(i, _mm_or_si128(_mm_or_si128(rb, g), opaque));
+        }
+        return true;
 
-                // Add modifier
-                unsigned table_index = static_cast<int>((x < 2) ? table_index_1.Value() : table_index_2.Value());
+    case Regs::TextureFormat::RGBA4:
+        for (int i = 0; i < TILE_TEXELS; i += 4) {
+            __m128i pixel = Load16(i);
+            __m128i rgba = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(pixel, 12), And(pixel, 0xF00)),
+                                        _mm_or_si128(And(_mm_slli_epi32(pixel, 12), 0xF0000),
+                                                     And(_mm_slli_epi32(pixel, 24), 0xF000000)));
+            rgba = _mm_or_si128(rgba, _mm_slli_epi32(rgba, 4));
+            Store(i, _mm_or_si128(rgba, alpha));
+        }
+        return true;
 
-                static const std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
-                    {{  2,  8 }}, {{  5, 17 }}, {{  9,  29 }}, {{ 13,  42 }},
-                    {{ 18, 60 }}, {{ 24, 80 }}, {{ 33, 106 }}, {{ 47, 183 }}
-                }};
+    case Regs::TextureFormat::IA8:
+        for (int i = 0; i < TILE_TEXELS; i += 8) {
+            __m128i pairs = Load(i * 2);
+            Store(i,     _mm_or_si128(_mm_shuffle_epi8(pairs, ia_pair_shuffle), alpha));
+            Store(i + 4, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(pairs, 8), ia_pair_shuffle), alpha));
+        }
+        return true;
 
-                int modifier = etc1_modifier_table.at(table_index).at(GetTableSubIndex(texel));
-                if (GetNegationFlag(texel))
-                    modifier *= -1;
+    case Regs::TextureFormat::RG8:
+        for (int i = 0; i < TILE_TEXELS; i += 8) {
+            __m128i pairs = Load(i * 2);
+            Store(i,     _mm_or_si128(_mm_shuffle_epi8(pairs, ia_split_shuffle), opaque));
+            Store(i + 4, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(pairs, 8), ia_split_shuffle), opaque));
+        }
+        return true;
 
-                ret.r() = MathUtil::Clamp(ret.r() + modifier, 0, 255);
-                ret.g() = MathUtil::Clamp(ret.g() + modifier, 0, 255);
-                ret.b() = MathUtil::Clamp(ret.b() + modifier, 0, 255);
+    case Regs::TextureFormat::I8:
+        for (int i = 0; i < TILE_TEXELS; i += 16)
+            StoreExpandedBytes(Load(i), intensity_shuffle, opaque, texels + i);
+        return true;
 
-                return ret.Cast<u8>();
-            }
-        } const *etc1_tile = reinterpret_cast<const ETC1Tile*>(source_ptr);
+    case Regs::TextureFormat::A8:
+        for (int i = 0; i < TILE_TEXELS; i += 16)
+            StoreExpandedBytes(Load(i), a_shuffle, alpha, texels + i);
+        return true;
 
-        alpha >>= 4 * ((x & 3) * 4 + (y & 3));
-        return Math::MakeVec(etc1_tile->GetRGB(x & 3, y & 3),
-                             disable_alpha ? (u8)255 : Color::Convert4To8(alpha & 0xF));
+    case Regs::TextureFormat::IA4:
+    {
+        const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+        for (int i = 0; i < TILE_TEXELS; i += 16) {
+            __m128i pixels = Load(i);
+            // Expand the intensity in the high and the alpha in the low nibble to 8 bits each
+            __m128i intensity = _mm_andnot_si128(low_nibbles, pixels);
+            intensity = _mm_or_si128(intensity, _mm_srli_epi16(intensity, 4));
+            __m128i a = _mm_and_si128(pixels, low_nibbles);
+            a = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+
+            // Interleave them to (alpha, intensity) pairs like IA8
+            __m128i pairs_low = _mm_unpacklo_epi8(a, intensity);
+            __m128i pairs_high = _mm_unpackhi_epi8(a, intensity);
+            Store(i,      _mm_or_si128(_mm_shuffle_epi8(pairs_low, ia_pair_shuffle), alpha));
+            Store(i + 4,  _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(pairs_low, 8), ia_pair_shuffle), alpha));
+            Store(i + 8,  _mm_or_si128(_mm_shuffle_epi8(pairs_high, ia_pair_shuffle), alpha));
+            Store(i + 12, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(pairs_high, 8), ia_pair_shuffle), alpha));
+        }
+        return true;
+    }
+
+    case Regs::TextureFormat::I4:
+    case Regs::TextureFormat::A4:
+    {
+        const __m128i low_nibbles = _mm_set1_epi8(0x0F);
+        const bool is_alpha = (format == Regs::TextureFormat::A4);
+        for (int i = 0; i < TILE_TEXELS; i += 32) {
+            __m128i pixels = Load(i / 2);
+            // The first texel of each byte is in its low nibble
+            __m128i first = _mm_and_si128(pixels, low_nibbles);
+            __m128i second = _mm_and_si128(_mm_srli_epi16(pixels, 4), low_nibbles);
+            __m128i values_low = _mm_unpacklo_epi8(first, second);
+            __m128i values_high = _mm_unpackhi_epi8(first, second);
+            values_low = _mm_or_si128(values_low, _mm_slli_epi16(values_low, 4));
+            values_high = _mm_or_si128(values_high, _mm_slli_epi16(values_high, 4));
+
+            if (is_alpha) {
+                StoreExpandedBytes(values_low, a_shuffle, alpha, texels + i);
+                StoreExpandedBytes(values_high, a_shuffle, alpha, texels + i + 16);
+            } else {
+                StoreExpandedBytes(values_low, intensity_shuffle, opaque, texels + i);
+                StoreExpandedBytes(values_high, intensity_shuffle, opaque, texels + i + 16);
+            }
+        }
+        return true;
     }
 
     default:
-        LOG_ERROR(HW_GPU, "Unknown texture format: %x", (u32)info.format);
-        DEBUG_ASSERT(false);
-        return {};
+        return false;
+    }
+}
+#endif // ARCHITECTURE_x86_64
+
+/// Decodes the 8x8 tile at `source` to `texels` in Morton order
+static void DecodeTile(const u8* source, Regs::TextureFormat format, bool disable_alpha, Math::Vec4<u8>* texels) {
+    if (format == Regs::TextureFormat::ETC1 || format == Regs::TextureFormat::ETC1A4) {
+        DecodeETC1Tile(source, format == Regs::TextureFormat::ETC1A4, disable_alpha, texels);
+        return;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    if (DecodeTileSSE(source, format, disable_alpha, texels))
+        return;
+#endif
+
+    // Fall back to decoding one texel at a time
+    TextureInfo tile_info;
+    tile_info.physical_address = 0;
+    tile_info.width = 8;
+    tile_info.height = 8;
+    tile_info.stride = 0;
+    tile_info.format = format;
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x)
+            texels[VideoCore::MortonInterleave(x, y)] = LookupTexture(source, x, y, tile_info, disable_alpha);
+    }
+}
+
+void DecodeTexture(const u8* source, const TextureInfo& info, Math::Vec4<u8>* output, bool disable_alpha) {
+    const bool is_etc1 = (info.format == Regs::TextureFormat::ETC1 ||
+                          info.format == Regs::TextureFormat::ETC1A4);
+    const int tiles_x = info.width / 8;
+    const int tiles_y = info.height / 8;
+
+    unsigned tile_bytes = Regs::NibblesPerPixel(info.format) * TILE_TEXELS / 2;
+    if (is_etc1)
+        tile_bytes = (info.format == Regs::TextureFormat::ETC1A4) ? 64 : 32;
+
+    Math::Vec4<u8> MEMORY_ALIGNED16(texels[TILE_TEXELS]);
+    for (int tile_y = 0; tile_y < tiles_y; ++tile_y) {
+        // ETC1 textures don't use the stride, see LookupTexture
+        const u8* row_source = is_etc1 ? source + tile_y * tiles_x * tile_bytes
+                                       : source + tile_y * 8 * info.stride;
+
+        for (int tile_x = 0; tile_x < tiles_x; ++tile_x) {
+            DecodeTile(row_source + tile_x * tile_bytes, info.format, disable_alpha, texels);
+            VideoCore::UnswizzleTile(reinterpret_cast<const u8*>(texels),
+                                     reinterpret_cast<u8*>(output + tile_y * 8 * info.width + tile_x * 8),
+                                     info.width * sizeof(Math::Vec4<u8>), sizeof(Math::Vec4<u8>));
+        }
+    }
+
+    // Texture dimensions should be multiples of the tile size, but if they aren't, decode the
+    // texels outside of whole tiles separately
+    if (info.width % 8 != 0 || info.height % 8 != 0) {
+        for (int y = 0; y < info.height; ++y) {
+            for (int x = (y < tiles_y * 8) ? tiles_x * 8 : 0; x < info.width; ++x)
+                output[y * info.width + x] = LookupTexture(source, x, y, info, disable_alpha);
+        }
     }
 }
 
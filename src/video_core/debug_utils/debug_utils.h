@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <condition_variable>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "common/vector_math.h"
@@ -184,6 +186,34 @@ private:
 void DumpShader(const std::string& filename, const Regs::ShaderConfig& config,
                 const State::ShaderSetup& setup, const Regs::VSOutputAttributes* output_attributes);
 
+// Utility class to keep track of the memory ranges accessed during a draw, for the Pica recorder.
+class MemoryAccessTracker {
+    /// Combine overlapping and close ranges
+    void SimplifyRanges() {
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            // NOTE: We add 32 to the range end address to make sure "close" ranges are combined, too
+            auto it2 = std::next(it);
+            while (it2 != ranges.end() && it->first + it->second + 32 >= it2->first) {
+                it->second = std::max(it->second, it2->first + it2->second - it->first);
+                it2 = ranges.erase(it2);
+            }
+        }
+    }
+
+public:
+    /// Record a particular memory access in the list
+    void AddAccess(u32 paddr, u32 size) {
+        // Create new range or extend existing one
+        ranges[paddr] = std::max(ranges[paddr], size);
+
+        // Simplify ranges...
+        SimplifyRanges();
+    }
+
+    /// Map of accessed ranges (mapping start address to range size)
+    std::map<u32, u32> ranges;
+};
+
 
 // Utility class to log Pica commands.
 struct PicaTrace {
@@ -222,6 +252,17 @@ struct TextureInfo {
 const Math::Vec4<u8> LookupTexture(const u8* source, int s, int t, const TextureInfo& info,
                                    bool disable_alpha = false);
 
+/**
+ * Decode a whole texture to RGBA vectors. This is equivalent to calling LookupTexture for each
+ * texel, but decodes the texture a tile at a time, which is much faster.
+ * @param source Source pointer to read data from
+ * @param info TextureInfo object describing the texture setup
+ * @param output Destination for the info.width * info.height texels, the texel at coordinates (s, t) is stored at t * info.width + s
+ * @param disable_alpha See LookupTexture
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, Math::Vec4<u8>* output,
+                   bool disable_alpha = false);
+
 void DumpTexture(const Pica::Regs::TextureConfig& texture_config, u8* data);
 
 void DumpTevStageConfig(const std::array<Pica::Regs::TevStageConfig,6>& stages);
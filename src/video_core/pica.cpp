@@ -6,6 +6,8 @@
 #include <unordered_map>
 
 #include "video_core/pica.h"
+#include "video_core/texture_cache.h"
+#include "video_core/vertex_loader.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -88,6 +90,8 @@ void Init() {
 
 void Shutdown() {
     Shader::Shutdown();
+    VertexLoader::ClearCache();
+    TextureCache::InvalidateAll();
 
     memset(&g_state, 0, sizeof(State));
 }
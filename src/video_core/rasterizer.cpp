@@ -4,218 +4,350 @@
 
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
+#include <vector>
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/bit_set.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/profiler.h"
+#include "common/thread_pool.h"
 
 #include "core/memory.h"
 #include "core/hw/gpu.h"
 
 #include "video_core/pica.h"
 #include "video_core/rasterizer.h"
+#include "video_core/texture_cache.h"
 #include "video_core/utils.h"
+#include "video_core/video_core.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/tev_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
 namespace Pica {
 
 namespace Rasterizer {
 
-static void DrawPixel(int x, int y, const Math::Vec4<u8>& color) {
-    const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
+/// Encoding of the pixels of a color buffer format
+template <Regs::ColorFormat format>
+struct ColorCodec;
 
-    // Similarly to textures, the render framebuffer is laid out from bottom to top, too.
-    // NOTE: The framebuffer height register contains the actual FB height minus one.
-    y = framebuffer.height - y;
-
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
-    u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * framebuffer.width * bytes_per_pixel;
-    u8* dst_pixel = Memory::GetPhysicalPointer(addr) + dst_offset;
+template <>
+struct ColorCodec<Regs::ColorFormat::RGBA8> {
+    static const u32 bytes_per_pixel = 4;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGBA8(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGBA8(color, bytes); }
+};
 
-    switch (framebuffer.color_format) {
-    case Regs::ColorFormat::RGBA8:
-        Color::EncodeRGBA8(color, dst_pixel);
-        break;
+template <>
+struct ColorCodec<Regs::ColorFormat::RGB8> {
+    static const u32 bytes_per_pixel = 3;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB8(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB8(color, bytes); }
+};
 
-    case Regs::ColorFormat::RGB8:
-        Color::EncodeRGB8(color, dst_pixel);
-        break;
+template <>
+struct ColorCodec<Regs::ColorFormat::RGB5A1> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB5A1(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB5A1(color, bytes); }
+};
 
-    case Regs::ColorFormat::RGB5A1:
-        Color::EncodeRGB5A1(color, dst_pixel);
-        break;
+template <>
+struct ColorCodec<Regs::ColorFormat::RGB565> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGB565(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGB565(color, bytes); }
+};
 
-    case Regs::ColorFormat::RGB565:
-        Color::EncodeRGB565(color, dst_pixel);
-        break;
+template <>
+struct ColorCodec<Regs::ColorFormat::RGBA4> {
+    static const u32 bytes_per_pixel = 2;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return Color::DecodeRGBA4(bytes); }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) { Color::EncodeRGBA4(color, bytes); }
+};
 
-    case Regs::ColorFormat::RGBA4:
-        Color::EncodeRGBA4(color, dst_pixel);
-        break;
+/// Stand-in for unknown color formats, which read as zero and ignore writes
+struct InvalidColorCodec {
+    static const u32 bytes_per_pixel = 0;
+    static Math::Vec4<u8> Decode(const u8* bytes) { return { 0, 0, 0, 0 }; }
+    static void Encode(const Math::Vec4<u8>& color, u8* bytes) {}
+};
 
-    default:
-        LOG_CRITICAL(Render_Software, "Unknown framebuffer color format %x", framebuffer.color_format.Value());
-        UNIMPLEMENTED();
-    }
-}
+/// Encoding of the pixels of a depth buffer format
+template <Regs::DepthFormat format>
+struct DepthCodec;
 
-static const Math::Vec4<u8> GetPixel(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
+template <>
+struct DepthCodec<Regs::DepthFormat::D16> {
+    static const u32 bytes_per_pixel = 2;
+    static void Decode(const u8* bytes, u32& depth, u8& stencil) { depth = Color::DecodeD16(bytes); stencil = 0; }
+    static void EncodeDepth(u32 depth, u8* bytes) { Color::EncodeD16(depth, bytes); }
+    static void EncodeStencil(u8 stencil, u8* bytes) {}
+};
 
-    y = framebuffer.height - y;
+template <>
+struct DepthCodec<Regs::DepthFormat::D24> {
+    static const u32 bytes_per_pixel = 3;
+    static void Decode(const u8* bytes, u32& depth, u8& stencil) { depth = Color::DecodeD24(bytes); stencil = 0; }
+    static void EncodeDepth(u32 depth, u8* bytes) { Color::EncodeD24(depth, bytes); }
+    static void EncodeStencil(u8 stencil, u8* bytes) {}
+};
 
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
-    u32 src_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * framebuffer.width * bytes_per_pixel;
-    u8* src_pixel = Memory::GetPhysicalPointer(addr) + src_offset;
+template <>
+struct DepthCodec<Regs::DepthFormat::D24S8> {
+    static const u32 bytes_per_pixel = 4;
+    static void Decode(const u8* bytes, u32& depth, u8& stencil) {
+        Math::Vec2<u32> value = Color::DecodeD24S8(bytes);
+        depth = value.x;
+        stencil = value.y;
+    }
+    static void EncodeDepth(u32 depth, u8* bytes) { Color::EncodeD24X8(depth, bytes); }
+    static void EncodeStencil(u8 stencil, u8* bytes) { Color::EncodeX24S8(stencil, bytes); }
+};
 
-    switch (framebuffer.color_format) {
-    case Regs::ColorFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
+/// Stand-in for unknown depth formats, which read as zero and ignore writes
+struct InvalidDepthCodec {
+    static const u32 bytes_per_pixel = 0;
+    static void Decode(const u8* bytes, u32& depth, u8& stencil) { depth = 0; stencil = 0; }
+    static void EncodeDepth(u32 depth, u8* bytes) {}
+    static void EncodeStencil(u8 stencil, u8* bytes) {}
+};
 
-    case Regs::ColorFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
+struct FramebufferTile;
 
-    case Regs::ColorFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
+/**
+ * Access to the color and depth buffers of the current draw. The buffer addresses and formats are
+ * resolved once when it is set up, and pixels are then loaded and stored a whole tile at a time
+ * with the conversion for the buffer formats.
+ */
+class FramebufferAccessor {
+public:
+    /// Resolves the buffers of the current framebuffer configuration
+    void Setup();
+
+    void LoadColor(FramebufferTile& tile) const { load_color(*this, tile); }
+    void LoadDepthStencil(FramebufferTile& tile) const { load_depth_stencil(*this, tile); }
+
+    /// Writes back the pixels of the tile that were modified
+    void Store(const FramebufferTile& tile) const {
+        store_color(*this, tile);
+        store_depth_stencil(*this, tile);
+    }
 
-    case Regs::ColorFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
+private:
+    /// Returns the offset of the pixel at the given rasterizer coordinates in a buffer
+    u32 GetPixelOffset(int x, int y, u32 bytes_per_pixel) const {
+        // Similarly to textures, the render framebuffer is laid out from bottom to top, too.
+        // NOTE: The framebuffer height register contains the actual FB height minus one.
+        y = height - y;
+
+        const u32 coarse_y = y & ~7;
+        return VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
+    }
 
-    case Regs::ColorFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
+    template <typename Codec>
+    static void LoadColorTile(const FramebufferAccessor& accessor, FramebufferTile& tile);
+    template <typename Codec>
+    static void StoreColorTile(const FramebufferAccessor& accessor, const FramebufferTile& tile);
+    template <typename Codec>
+    static void LoadDepthStencilTile(const FramebufferAccessor& accessor, FramebufferTile& tile);
+    template <typename Codec>
+    static void StoreDepthStencilTile(const FramebufferAccessor& accessor, const FramebufferTile& tile);
+
+    u8* color_buffer = nullptr;
+    u8* depth_buffer = nullptr;
+    u32 width = 0;
+    int height = 0;
+
+    void (*load_color)(const FramebufferAccessor&, FramebufferTile&) = nullptr;
+    void (*store_color)(const FramebufferAccessor&, const FramebufferTile&) = nullptr;
+    void (*load_depth_stencil)(const FramebufferAccessor&, FramebufferTile&) = nullptr;
+    void (*store_depth_stencil)(const FramebufferAccessor&, const FramebufferTile&) = nullptr;
+};
 
-    default:
-        LOG_CRITICAL(Render_Software, "Unknown framebuffer color format %x", framebuffer.color_format.Value());
-        UNIMPLEMENTED();
+/**
+ * Block of 8x8 framebuffer pixels the rasterizer works on, so that testing and blending fragments
+ * only reads and modifies this copy instead of the framebuffer itself. Its pixels are indexed by
+ * their offset from the bottom left pixel in rasterizer coordinates, i.e. by dy * 8 + dx. The
+ * color and depth/stencil values are loaded on first use, and only for the pixels in `pixel_mask`.
+ */
+struct FramebufferTile {
+    static const int SIZE = 8;
+
+    /// Prepares the tile for the block at the given rasterizer coordinates
+    void Reset(const FramebufferAccessor* accessor, int x, int y, u64 pixel_mask) {
+        this->accessor = accessor;
+        this->x = x;
+        this->y = y;
+        this->pixel_mask = pixel_mask;
+        color_loaded = false;
+        depth_stencil_loaded = false;
+        color_written = 0;
+        depth_written = 0;
+        stencil_written = 0;
     }
 
-    return {0, 0, 0, 0};
-}
-
-static u32 GetDepth(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = Memory::GetPhysicalPointer(addr);
+    /// Returns the index of the pixel at the given rasterizer coordinates
+    int GetIndex(int pixel_x, int pixel_y) const {
+        return (pixel_y - y) * SIZE + (pixel_x - x);
+    }
 
-    y = framebuffer.height - y;
+    const Math::Vec4<u8>& GetColor(int index) {
+        if (!color_loaded)
+            accessor->LoadColor(*this);
+        return color[index];
+    }
 
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = Regs::BytesPerDepthPixel(framebuffer.depth_format);
-    u32 stride = framebuffer.width * bytes_per_pixel;
+    u32 GetDepth(int index) {
+        if (!depth_stencil_loaded)
+            accessor->LoadDepthStencil(*this);
+        return depth[index];
+    }
 
-    u32 src_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-    u8* src_pixel = depth_buffer + src_offset;
+    u8 GetStencil(int index) {
+        if (!depth_stencil_loaded)
+            accessor->LoadDepthStencil(*this);
+        return stencil[index];
+    }
 
-    switch (framebuffer.depth_format) {
-        case Regs::DepthFormat::D16:
-            return Color::DecodeD16(src_pixel);
-        case Regs::DepthFormat::D24:
-            return Color::DecodeD24(src_pixel);
-        case Regs::DepthFormat::D24S8:
-            return Color::DecodeD24S8(src_pixel).x;
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented depth format %u", framebuffer.depth_format);
-            UNIMPLEMENTED();
-            return 0;
+    void SetColor(int index, const Math::Vec4<u8>& value) {
+        color[index] = value;
+        color_written |= 1ull << index;
     }
-}
 
-static u8 GetStencil(int x, int y) {
-    const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = Memory::GetPhysicalPointer(addr);
+    void SetDepth(int index, u32 value) {
+        depth[index] = value;
+        depth_written |= 1ull << index;
+    }
 
-    y = framebuffer.height - y;
+    void SetStencil(int index, u8 value) {
+        stencil[index] = value;
+        stencil_written |= 1ull << index;
+    }
 
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = Pica::Regs::BytesPerDepthPixel(framebuffer.depth_format);
-    u32 stride = framebuffer.width * bytes_per_pixel;
+    const FramebufferAccessor* accessor;
+    int x, y;       ///< Rasterizer coordinates of the bottom left pixel
+    u64 pixel_mask; ///< Pixels that may be accessed, the others are never loaded or stored
 
-    u32 src_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-    u8* src_pixel = depth_buffer + src_offset;
+    bool color_loaded;
+    bool depth_stencil_loaded;
+    u64 color_written;
+    u64 depth_written;
+    u64 stencil_written;
 
-    switch (framebuffer.depth_format) {
-        case Regs::DepthFormat::D24S8:
-            return Color::DecodeD24S8(src_pixel).y;
+    Math::Vec4<u8> color[SIZE * SIZE];
+    u32 depth[SIZE * SIZE];
+    u8 stencil[SIZE * SIZE];
+};
 
-        default:
-            LOG_WARNING(HW_GPU, "GetStencil called for function which doesn't have a stencil component (format %u)", framebuffer.depth_format);
-            return 0;
+template <typename Codec>
+void FramebufferAccessor::LoadColorTile(const FramebufferAccessor& accessor, FramebufferTile& tile) {
+    for (int index : BitSet64(tile.pixel_mask)) {
+        u32 offset = accessor.GetPixelOffset(tile.x + index % FramebufferTile::SIZE, tile.y + index / FramebufferTile::SIZE,
+                                             Codec::bytes_per_pixel);
+        tile.color[index] = Codec::Decode(accessor.color_buffer + offset);
     }
+    tile.color_loaded = true;
 }
 
-static void SetDepth(int x, int y, u32 value) {
-    const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = Memory::GetPhysicalPointer(addr);
-
-    y = framebuffer.height - y;
-
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = Regs::BytesPerDepthPixel(framebuffer.depth_format);
-    u32 stride = framebuffer.width * bytes_per_pixel;
-
-    u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-    u8* dst_pixel = depth_buffer + dst_offset;
-
-    switch (framebuffer.depth_format) {
-        case Regs::DepthFormat::D16:
-            Color::EncodeD16(value, dst_pixel);
-            break;
-
-        case Regs::DepthFormat::D24:
-            Color::EncodeD24(value, dst_pixel);
-            break;
+template <typename Codec>
+void FramebufferAccessor::StoreColorTile(const FramebufferAccessor& accessor, const FramebufferTile& tile) {
+    for (int index : BitSet64(tile.color_written)) {
+        u32 offset = accessor.GetPixelOffset(tile.x + index % FramebufferTile::SIZE, tile.y + index / FramebufferTile::SIZE,
+                                             Codec::bytes_per_pixel);
+        Codec::Encode(tile.color[index], accessor.color_buffer + offset);
+    }
+}
 
-        case Regs::DepthFormat::D24S8:
-            Color::EncodeD24X8(value, dst_pixel);
-            break;
+template <typename Codec>
+void FramebufferAccessor::LoadDepthStencilTile(const FramebufferAccessor& accessor, FramebufferTile& tile) {
+    for (int index : BitSet64(tile.pixel_mask)) {
+        u32 offset = accessor.GetPixelOffset(tile.x + index % FramebufferTile::SIZE, tile.y + index / FramebufferTile::SIZE,
+                                             Codec::bytes_per_pixel);
+        Codec::Decode(accessor.depth_buffer + offset, tile.depth[index], tile.stencil[index]);
+    }
+    tile.depth_stencil_loaded = true;
+}
 
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented depth format %u", framebuffer.depth_format);
-            UNIMPLEMENTED();
-            break;
+template <typename Codec>
+void FramebufferAccessor::StoreDepthStencilTile(const FramebufferAccessor& accessor, const FramebufferTile& tile) {
+    for (int index : BitSet64(tile.depth_written | tile.stencil_written)) {
+        u32 offset = accessor.GetPixelOffset(tile.x + index % FramebufferTile::SIZE, tile.y + index / FramebufferTile::SIZE,
+                                             Codec::bytes_per_pixel);
+        u8* dst_pixel = accessor.depth_buffer + offset;
+        if (tile.depth_written & (1ull << index))
+            Codec::EncodeDepth(tile.depth[index], dst_pixel);
+        if (tile.stencil_written & (1ull << index))
+            Codec::EncodeStencil(tile.stencil[index], dst_pixel);
     }
 }
 
-static void SetStencil(int x, int y, u8 value) {
+void FramebufferAccessor::Setup() {
     const auto& framebuffer = g_state.regs.framebuffer;
-    const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
-    u8* depth_buffer = Memory::GetPhysicalPointer(addr);
+    color_buffer = Memory::GetPhysicalPointer(framebuffer.GetColorBufferPhysicalAddress());
+    depth_buffer = Memory::GetPhysicalPointer(framebuffer.GetDepthBufferPhysicalAddress());
+    width = framebuffer.width;
+    height = framebuffer.height;
 
-    y = framebuffer.height - y;
+    switch (framebuffer.color_format) {
+#define COLOR_FORMAT_CASE(format)                                             \
+    case Regs::ColorFormat::format:                                           \
+        load_color = &LoadColorTile<ColorCodec<Regs::ColorFormat::format>>;   \
+        store_color = &StoreColorTile<ColorCodec<Regs::ColorFormat::format>>; \
+        break;
 
-    const u32 coarse_y = y & ~7;
-    u32 bytes_per_pixel = Pica::Regs::BytesPerDepthPixel(framebuffer.depth_format);
-    u32 stride = framebuffer.width * bytes_per_pixel;
+    COLOR_FORMAT_CASE(RGBA8)
+    COLOR_FORMAT_CASE(RGB8)
+    COLOR_FORMAT_CASE(RGB5A1)
+    COLOR_FORMAT_CASE(RGB565)
+    COLOR_FORMAT_CASE(RGBA4)
+#undef COLOR_FORMAT_CASE
 
-    u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-    u8* dst_pixel = depth_buffer + dst_offset;
+    default:
+        LOG_CRITICAL(Render_Software, "Unknown framebuffer color format %x", framebuffer.color_format.Value());
+        UNIMPLEMENTED();
+        load_color = &LoadColorTile<InvalidColorCodec>;
+        store_color = &StoreColorTile<InvalidColorCodec>;
+        break;
+    }
 
     switch (framebuffer.depth_format) {
-        case Pica::Regs::DepthFormat::D16:
-        case Pica::Regs::DepthFormat::D24:
-            // Nothing to do
-            break;
+#define DEPTH_FORMAT_CASE(format)                                                             \
+    case Regs::DepthFormat::format:                                                           \
+        load_depth_stencil = &LoadDepthStencilTile<DepthCodec<Regs::DepthFormat::format>>;   \
+        store_depth_stencil = &StoreDepthStencilTile<DepthCodec<Regs::DepthFormat::format>>; \
+        break;
 
-        case Pica::Regs::DepthFormat::D24S8:
-            Color::EncodeX24S8(value, dst_pixel);
-            break;
+    DEPTH_FORMAT_CASE(D16)
+    DEPTH_FORMAT_CASE(D24)
+    DEPTH_FORMAT_CASE(D24S8)
+#undef DEPTH_FORMAT_CASE
 
-        default:
-            LOG_CRITICAL(HW_GPU, "Unimplemented depth format %u", framebuffer.depth_format);
-            UNIMPLEMENTED();
-            break;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unimplemented depth format %u", framebuffer.depth_format);
+        UNIMPLEMENTED();
+        load_depth_stencil = &LoadDepthStencilTile<InvalidDepthCodec>;
+        store_depth_stencil = &StoreDepthStencilTile<InvalidDepthCodec>;
+        break;
     }
 }
 
+/// Framebuffer of the current draw
+static FramebufferAccessor framebuffer_accessor;
+
 static u8 PerformStencilAction(Regs::StencilAction action, u8 old_stencil, u8 ref) {
     switch (action) {
     case Regs::StencilAction::Keep:
@@ -289,61 +421,296 @@ static int SignedArea (const Math::Vec2<Fix12P4>& vtx1,
 static Common::Profiling::TimingCategory rasterization_category("Rasterization");
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+// vertex positions in rasterizer coordinates
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+static Math::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Math::Vec3<float24>& vec) {
+    return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
+/// Rectangle of pixels in rasterizer coordinates, i.e. with the y axis pointing upwards
+struct PixelRect {
+    int min_x, min_y; ///< Inclusive
+    int max_x, max_y; ///< Exclusive
+};
+
 /**
- * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * Width and height of the screen tiles triangles are binned into. This is a multiple of the 8x8
+ * tiles of the Morton framebuffer layout, so that no two threads write to the same Morton tile.
  */
-static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
-                                    const Shader::OutputVertex& v1,
-                                    const Shader::OutputVertex& v2,
-                                    bool reversed = false)
-{
-    const auto& regs = g_state.regs;
-    Common::Profiling::ScopeTimer timer(rasterization_category);
-    MICROPROFILE_SCOPE(GPU_Rasterization);
+static const int BIN_TILE_SIZE = 32;
 
-    // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
-    static auto ScreenToRasterizerCoordinates = [](const Math::Vec3<float24>& vec) {
-        return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
-    };
+/// Triangle waiting to be rasterized, after culling and with counter-clockwise winding
+struct QueuedTriangle {
+    Shader::OutputVertex v0, v1, v2;
+};
 
-    Math::Vec3<Fix12P4> vtxpos[3]{ ScreenToRasterizerCoordinates(v0.screenpos),
-                                   ScreenToRasterizerCoordinates(v1.screenpos),
-                                   ScreenToRasterizerCoordinates(v2.screenpos) };
+/// Triangles of the current draw, rasterized by Flush()
+static std::vector<QueuedTriangle> queued_triangles;
+/// Indices of the queued triangles overlapping each screen tile, in submission order
+static std::vector<std::vector<u32>> tile_bins;
 
-    if (regs.cull_mode == Regs::CullMode::KeepAll) {
-        // Make sure we always end up with a triangle wound counter-clockwise
-        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
-        }
-    } else {
-        if (!reversed && regs.cull_mode == Regs::CullMode::KeepClockWise) {
-            // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
-        }
+/// Width and height of the screen blocks the coarse depth buffer keeps a depth range for. These
+/// are the blocks the rasterizer loads framebuffer tiles for, too.
+static const int HIZ_BLOCK_SIZE = FramebufferTile::SIZE;
 
-        // Cull away triangles which are wound clockwise.
-        if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
-            return;
+/// Depth range of a block of the depth buffer, used to reject blocks of occluded fragments at once
+struct HiZBlock {
+    u32 min_depth;
+    u32 max_depth;
+    bool valid; ///< If not set, the range is recomputed from the depth buffer before it's used
+};
+
+/// Coarse ("hierarchical") depth buffer, with the blocks indexed in rasterizer coordinates
+static std::vector<HiZBlock> hiz_blocks;
+/// Depth buffer the coarse depth buffer was set up for
+static PAddr hiz_depth_address = 0;
+static u32 hiz_width = 0;
+static u32 hiz_height = 0;
+static Regs::DepthFormat hiz_depth_format = Regs::DepthFormat::D16;
+
+/**
+ * Makes sure the coarse depth buffer matches the current depth buffer. If the depth buffer isn't
+ * made of whole blocks, no coarse depth buffer is used.
+ */
+static void SetupHiZBuffer() {
+    const auto& framebuffer = g_state.regs.framebuffer;
+    const PAddr address = framebuffer.GetDepthBufferPhysicalAddress();
+    const u32 width = framebuffer.GetWidth();
+    const u32 height = framebuffer.GetHeight();
+
+    if (address == hiz_depth_address && width == hiz_width && height == hiz_height &&
+        framebuffer.depth_format == hiz_depth_format)
+        return;
+
+    hiz_depth_address = address;
+    hiz_width = width;
+    hiz_height = height;
+    hiz_depth_format = framebuffer.depth_format;
+
+    hiz_blocks.clear();
+    if (width % HIZ_BLOCK_SIZE == 0 && height % HIZ_BLOCK_SIZE == 0)
+        hiz_blocks.assign((width / HIZ_BLOCK_SIZE) * (height / HIZ_BLOCK_SIZE), { 0, 0, false });
+}
+
+/// Returns the coarse depth block whose bottom left pixel is at the given rasterizer coordinates
+static HiZBlock& GetHiZBlock(int x, int y) {
+    return hiz_blocks[(y / HIZ_BLOCK_SIZE) * (hiz_width / HIZ_BLOCK_SIZE) + x / HIZ_BLOCK_SIZE];
+}
+
+/// Recomputes the depth range of the given coarse depth block from the depth buffer if necessary
+static void UpdateHiZBlock(HiZBlock& block, int x, int y) {
+    if (block.valid)
+        return;
+
+    FramebufferTile tile;
+    tile.Reset(&framebuffer_accessor, x, y, ~0ull);
+    framebuffer_accessor.LoadDepthStencil(tile);
+
+    block.min_depth = 0xFFFFFFFF;
+    block.max_depth = 0;
+    for (u32 depth : tile.depth) {
+        block.min_depth = std::min(block.min_depth, depth);
+        block.max_depth = std::max(block.max_depth, depth);
     }
+    block.valid = true;
+}
 
-    // TODO: Proper scissor rect test!
+#ifdef ARCHITECTURE_x86_64
+static std::unordered_map<u64, CompiledTevCombiner*> tev_combiner_map;
+static TevJit tev_jit;
+
+/// Combiner compiled for the current texture environment, nullptr if it is interpreted instead
+static CompiledTevCombiner* tev_combiner = nullptr;
+
+/// Looks up the combiner compiled for the current texture environment, compiling it if necessary
+static CompiledTevCombiner* GetCompiledTevCombiner() {
+    if (!VideoCore::g_shader_jit_enabled || !TevJit::IsSupported())
+        return nullptr;
+
+    const TevConfig config = TevConfig::FromRegs(g_state.regs);
+    u64 cache_key = Common::ComputeHash64(&config, sizeof(config));
+
+    auto iter = tev_combiner_map.find(cache_key);
+    if (iter != tev_combiner_map.end())
+        return iter->second;
+
+    // Combiners are small, so rather than tracking individual ones just start over when full
+    if (tev_jit.GetSpaceLeft() < 64 * 1024) {
+        tev_jit.Clear();
+        tev_combiner_map.clear();
+    }
+
+    // Configurations the JIT doesn't support are cached as nullptr as well
+    CompiledTevCombiner* combiner = tev_jit.Compile(config);
+    tev_combiner_map.emplace(cache_key, combiner);
+    return combiner;
+}
+#endif // ARCHITECTURE_x86_64
+
+/// Decoded contents of the enabled textures, nullptr if they are sampled from memory instead
+static const TextureCache::DecodedTexture* decoded_textures[3] = {};
+
+/// Whether the state derived from the registers needs to be set up again before the next triangle
+static bool draw_state_dirty = true;
+
+/// Sets up the state derived from the registers that is shared by all triangles until the next flush
+static void SetupDrawState() {
+#ifdef ARCHITECTURE_x86_64
+    tev_combiner = GetCompiledTevCombiner();
+#endif // ARCHITECTURE_x86_64
+
+    const auto& regs = g_state.regs;
+    const auto& framebuffer = regs.framebuffer;
+    const PAddr color_address = framebuffer.GetColorBufferPhysicalAddress();
+    const u32 color_size = framebuffer.GetWidth() * framebuffer.GetHeight() *
+                           GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
+    const PAddr depth_address = framebuffer.GetDepthBufferPhysicalAddress();
+    const u32 depth_size = framebuffer.GetWidth() * framebuffer.GetHeight() *
+                           Regs::BytesPerDepthPixel(framebuffer.depth_format);
+
+    // Decoded copies of the render targets are about to become stale
+    TextureCache::InvalidateInRange(color_address, color_size, true);
+    TextureCache::InvalidateInRange(depth_address, depth_size, true);
+
+    auto textures = regs.GetTextures();
+    DebugUtils::TextureInfo infos[3];
+    bool use_cache[3] = {};
+    size_t num_texels = 0;
+    for (int i = 0; i < 3; ++i) {
+        decoded_textures[i] = nullptr;
+
+        const auto& texture = textures[i];
+        if (!texture.enabled)
+            continue;
+
+        infos[i] = DebugUtils::TextureInfo::FromPicaRegister(texture.config, texture.format);
+        const u32 size = infos[i].stride * infos[i].height;
+
+        // Textures that are rendered to while being sampled are read from memory directly
+        if (MathUtil::IntervalsIntersect(infos[i].physical_address, size, color_address, color_size) ||
+            MathUtil::IntervalsIntersect(infos[i].physical_address, size, depth_address, depth_size))
+            continue;
+
+        use_cache[i] = true;
+        num_texels += infos[i].width * infos[i].height;
+    }
+
+    // Make room up front, so that looking up one texture can't drop another one of this draw
+    TextureCache::ReserveTexels(num_texels);
+    for (int i = 0; i < 3; ++i) {
+        if (use_cache[i])
+            decoded_textures[i] = TextureCache::GetTexture(infos[i]);
+    }
+
+    framebuffer_accessor.Setup();
+    SetupHiZBuffer();
+}
+
+/// Returns the pixels covered by the bounding box of the given triangle
+static PixelRect GetBoundingBox(const Math::Vec3<Fix12P4> vtxpos[3]) {
     u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
     u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
     u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
     u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
 
-    min_x &= Fix12P4::IntMask();
-    min_y &= Fix12P4::IntMask();
-    max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
-    max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
+    return { min_x >> 4, min_y >> 4,
+             (max_x + Fix12P4::FracMask()) >> 4, (max_y + Fix12P4::FracMask()) >> 4 };
+}
+
+/// Layout of the vertex attributes interpolated across triangles, padded to a multiple of four
+enum InterpolatedAttribute {
+    ATTRIBUTE_COLOR = 0,
+    ATTRIBUTE_TEXCOORD0 = 4,
+    ATTRIBUTE_TEXCOORD1 = 6,
+    ATTRIBUTE_TEXCOORD2 = 8,
+    ATTRIBUTE_W_INVERSE = 10,
+    NUM_INTERPOLATED_ATTRIBUTES = 12,
+};
+
+#ifdef ARCHITECTURE_x86_64
+/// Multiplies four pairs of floats like float24 does, i.e. giving 0 rather than NaN for 0 * inf
+static __m128 SanitizedMul(__m128 a, __m128 b) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 a_is_zero = _mm_and_ps(_mm_cmpeq_ps(a, zero), _mm_cmpord_ps(b, b));
+    __m128 b_is_zero = _mm_and_ps(_mm_cmpeq_ps(b, zero), _mm_cmpord_ps(a, a));
+    return _mm_andnot_ps(_mm_or_ps(a_is_zero, b_is_zero), _mm_mul_ps(a, b));
+}
+#endif
+
+/**
+ * Computes the perspective-correct values of all interpolated attributes at the pixel with the
+ * given barycentric coordinates, four attributes at a time where possible. Multiplications follow
+ * the float24 rules, so the results match interpolating each attribute with float24 operations.
+ */
+static void InterpolateAttributes(const float vertex_attributes[3][NUM_INTERPOLATED_ATTRIBUTES],
+                                  int w0, int w1, int w2,
+                                  float result[NUM_INTERPOLATED_ATTRIBUTES]) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128 baricentric_coordinates[3] = {
+        _mm_set1_ps(static_cast<float>(w0)),
+        _mm_set1_ps(static_cast<float>(w1)),
+        _mm_set1_ps(static_cast<float>(w2)),
+    };
+
+    __m128 attr_over_w[NUM_INTERPOLATED_ATTRIBUTES / 4];
+    for (int i = 0; i < NUM_INTERPOLATED_ATTRIBUTES / 4; ++i) {
+        __m128 sum = SanitizedMul(_mm_load_ps(&vertex_attributes[0][4 * i]), baricentric_coordinates[0]);
+        sum = _mm_add_ps(sum, SanitizedMul(_mm_load_ps(&vertex_attributes[1][4 * i]), baricentric_coordinates[1]));
+        sum = _mm_add_ps(sum, SanitizedMul(_mm_load_ps(&vertex_attributes[2][4 * i]), baricentric_coordinates[2]));
+        attr_over_w[i] = sum;
+        _mm_store_ps(&result[4 * i], sum);
+    }
+
+    const __m128 interpolated_w_inverse = _mm_set1_ps(1.0f / result[ATTRIBUTE_W_INVERSE]);
+    for (int i = 0; i < NUM_INTERPOLATED_ATTRIBUTES / 4; ++i)
+        _mm_store_ps(&result[4 * i], SanitizedMul(attr_over_w[i], interpolated_w_inverse));
+#else
+    const float24 baricentric_coordinates[3] = {
+        float24::FromFloat32(static_cast<float>(w0)),
+        float24::FromFloat32(static_cast<float>(w1)),
+        float24::FromFloat32(static_cast<float>(w2)),
+    };
+
+    float24 attr_over_w[NUM_INTERPOLATED_ATTRIBUTES];
+    for (int i = 0; i < NUM_INTERPOLATED_ATTRIBUTES; ++i) {
+        attr_over_w[i] = float24::FromFloat32(vertex_attributes[0][i]) * baricentric_coordinates[0] +
+                         float24::FromFloat32(vertex_attributes[1][i]) * baricentric_coordinates[1] +
+                         float24::FromFloat32(vertex_attributes[2][i]) * baricentric_coordinates[2];
+    }
+
+    float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / attr_over_w[ATTRIBUTE_W_INVERSE];
+    for (int i = 0; i < NUM_INTERPOLATED_ATTRIBUTES; ++i)
+        result[i] = (attr_over_w[i] * interpolated_w_inverse).ToFloat32();
+#endif
+}
+
+/**
+ * Rasterizes the pixels of the given counter-clockwise triangle which lie within `bounds`.
+ * Triangles overlapping several tiles may be rasterized concurrently for each of them, hence this
+ * must only access the framebuffer within `bounds`.
+ */
+static void RasterizeTriangle(const Shader::OutputVertex& v0,
+                              const Shader::OutputVertex& v1,
+                              const Shader::OutputVertex& v2,
+                              const PixelRect& bounds)
+{
+    const auto& regs = g_state.regs;
+
+    Math::Vec3<Fix12P4> vtxpos[3]{ ScreenToRasterizerCoordinates(v0.screenpos),
+                                   ScreenToRasterizerCoordinates(v1.screenpos),
+                                   ScreenToRasterizerCoordinates(v2.screenpos) };
+
+    // TODO: Proper scissor rect test!
+    PixelRect bounding_box = GetBoundingBox(vtxpos);
+    u16 min_x = std::max(bounding_box.min_x, bounds.min_x) << 4;
+    u16 min_y = std::max(bounding_box.min_y, bounds.min_y) << 4;
+    u16 max_x = std::min(bounding_box.max_x, bounds.max_x) << 4;
+    u16 max_y = std::min(bounding_box.max_y, bounds.max_y) << 4;
 
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
@@ -366,130 +733,276 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
     int bias1 = IsRightSideOrFlatBottomEdge(vtxpos[1].xy(), vtxpos[2].xy(), vtxpos[0].xy()) ? -1 : 0;
     int bias2 = IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
-    auto w_inverse = Math::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
+    // Gather the attributes to interpolate, see InterpolatedAttribute
+    float MEMORY_ALIGNED16(vertex_attributes[3][NUM_INTERPOLATED_ATTRIBUTES]);
+    const Shader::OutputVertex* vertices[3] = { &v0, &v1, &v2 };
+    for (int i = 0; i < 3; ++i) {
+        const Shader::OutputVertex& vertex = *vertices[i];
+        float* attributes = vertex_attributes[i];
+
+        for (int comp = 0; comp < 4; ++comp)
+            attributes[ATTRIBUTE_COLOR + comp] = vertex.color[comp].ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD0 + 0] = vertex.tc0.u().ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD0 + 1] = vertex.tc0.v().ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD1 + 0] = vertex.tc1.u().ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD1 + 1] = vertex.tc1.v().ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD2 + 0] = vertex.tc2.u().ToFloat32();
+        attributes[ATTRIBUTE_TEXCOORD2 + 1] = vertex.tc2.v().ToFloat32();
+        attributes[ATTRIBUTE_W_INVERSE] = vertex.pos.w.ToFloat32();
+        attributes[NUM_INTERPOLATED_ATTRIBUTES - 1] = 0.0f;
+    }
 
     auto textures = regs.GetTextures();
     auto tev_stages = regs.GetTevStages();
 
+    const auto& output_merger = regs.output_merger;
     bool stencil_action_enable = g_state.regs.output_merger.stencil_test.enable && g_state.regs.framebuffer.depth_format == Regs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.output_merger.stencil_test;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+    // Framebuffer pixels of the block being rasterized
+    FramebufferTile tile;
+
+    // Depth and stencil tests only depend on the fragment position, so unless the alpha test can
+    // discard the fragment they may be done first. Texturing and combining are skipped then for
+    // occluded fragments.
+    const bool early_depth_stencil = !output_merger.alpha_test.enable ||
+                                     output_merger.alpha_test.func == Regs::CompareFunc::Always;
+
+    // Performs the stencil and depth tests of the fragment at the given rasterizer coordinates,
+    // including the resulting stencil and depth buffer updates. Returns whether it passed both.
+    auto TestDepthStencil = [&](u16 x, u16 y, int w0, int w1, int w2) -> bool {
+        int wsum = w0 + w1 + w2;
+        int index = tile.GetIndex(x >> 4, y >> 4);
+
+        u8 old_stencil = 0;
+
+        auto UpdateStencil = [stencil_test, index, &tile, &old_stencil](Pica::Regs::StencilAction action) {
+            u8 new_stencil = PerformStencilAction(action, old_stencil, stencil_test.reference_value);
+            tile.SetStencil(index, (new_stencil & stencil_test.write_mask) | (old_stencil & ~stencil_test.write_mask));
+        };
+
+        if (stencil_action_enable) {
+            old_stencil = tile.GetStencil(index);
+            u8 dest = old_stencil & stencil_test.input_mask;
+            u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+
+            bool pass = false;
+            switch (stencil_test.func) {
+            case Regs::CompareFunc::Never:
+                pass = false;
+                break;
+
+            case Regs::CompareFunc::Always:
+                pass = true;
+                break;
+
+            case Regs::CompareFunc::Equal:
+                pass = (ref == dest);
+                break;
+
+            case Regs::CompareFunc::NotEqual:
+                pass = (ref != dest);
+                break;
+
+            case Regs::CompareFunc::LessThan:
+                pass = (ref < dest);
+                break;
+
+            case Regs::CompareFunc::LessThanOrEqual:
+                pass = (ref <= dest);
+                break;
+
+            case Regs::CompareFunc::GreaterThan:
+                pass = (ref > dest);
+                break;
+
+            case Regs::CompareFunc::GreaterThanOrEqual:
+                pass = (ref >= dest);
+                break;
+            }
+
+            if (!pass) {
+                UpdateStencil(stencil_test.action_stencil_fail);
+                return false;
+            }
+        }
+
+        // TODO: Does depth indeed only get written even if depth testing is enabled?
+        if (output_merger.depth_test_enable) {
+            unsigned num_bits = Regs::DepthBitsPerPixel(regs.framebuffer.depth_format);
+            u32 z = (u32)((v0.screenpos[2].ToFloat32() * w0 +
+                           v1.screenpos[2].ToFloat32() * w1 +
+                           v2.screenpos[2].ToFloat32() * w2) * ((1 << num_bits) - 1) / wsum);
+            u32 ref_z = tile.GetDepth(index);
+
+            bool pass = false;
+
+            switch (output_merger.depth_test_func) {
+            case Regs::CompareFunc::Never:
+                pass = false;
+                break;
+
+            case Regs::CompareFunc::Always:
+                pass = true;
+                break;
+
+            case Regs::CompareFunc::Equal:
+                pass = z == ref_z;
+                break;
+
+            case Regs::CompareFunc::NotEqual:
+                pass = z != ref_z;
+                break;
+
+            case Regs::CompareFunc::LessThan:
+                pass = z < ref_z;
+                break;
+
+            case Regs::CompareFunc::LessThanOrEqual:
+                pass = z <= ref_z;
+                break;
+
+            case Regs::CompareFunc::GreaterThan:
+                pass = z > ref_z;
+                break;
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
+            case Regs::CompareFunc::GreaterThanOrEqual:
+                pass = z >= ref_z;
+                break;
+            }
+
+            if (!pass) {
+                if (stencil_action_enable)
+                    UpdateStencil(stencil_test.action_depth_fail);
+                return false;
+            }
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
+            if (output_merger.depth_write_enable)
+                tile.SetDepth(index, z);
+        }
+
+        // The stencil depth_pass action is executed even if depth testing is disabled
+        if (stencil_action_enable)
+            UpdateStencil(stencil_test.action_depth_pass);
+
+        return true;
+    };
+
+    // Shades the pixel at the given rasterizer coordinates, given the values of the three edge
+    // functions there (i.e. its unnormalized barycentric coordinates)
+    auto ShadePixel = [&](u16 x, u16 y, int w0, int w1, int w2) {
+        if (early_depth_stencil && !TestDepthStencil(x, y, w0, w1, w2))
+            return;
+
+        // Perspective correct attribute interpolation:
+        // Attribute values cannot be calculated by simple linear interpolation since
+        // they are not linear in screen space. For example, when interpolating a
+        // texture coordinate across two vertices, something simple like
+        //     u = (u0*w0 + u1*w1)/(w0+w1)
+        // will not work. However, the attribute value divided by the
+        // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+        // in screenspace. Hence, we can linearly interpolate these two independently and
+        // calculate the interpolated attribute by dividing the results.
+        // I.e.
+        //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+        //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+        //     u = u_over_w / one_over_w
+        //
+        // The generalization to three vertices is straightforward in baricentric coordinates.
+        float MEMORY_ALIGNED16(attributes[NUM_INTERPOLATED_ATTRIBUTES]);
+        InterpolateAttributes(vertex_attributes, w0, w1, w2, attributes);
+
+        Math::Vec4<u8> primary_color{
+            (u8)(attributes[ATTRIBUTE_COLOR + 0] * 255),
+            (u8)(attributes[ATTRIBUTE_COLOR + 1] * 255),
+            (u8)(attributes[ATTRIBUTE_COLOR + 2] * 255),
+            (u8)(attributes[ATTRIBUTE_COLOR + 3] * 255)
+        };
+
+        Math::Vec2<float24> uv[3];
+        uv[0].u() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD0 + 0]);
+        uv[0].v() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD0 + 1]);
+        uv[1].u() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD1 + 0]);
+        uv[1].v() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD1 + 1]);
+        uv[2].u() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD2 + 0]);
+        uv[2].v() = float24::FromFloat32(attributes[ATTRIBUTE_TEXCOORD2 + 1]);
+
+        Math::Vec4<u8> texture_color[3]{};
+        for (int i = 0; i < 3; ++i) {
+            const auto& texture = textures[i];
+            if (!texture.enabled)
                 continue;
 
-            auto baricentric_coordinates = Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                                float24::FromFloat32(static_cast<float>(w1)),
-                                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse = float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+            DEBUG_ASSERT(0 != texture.config.address);
 
-            Math::Vec4<u8> primary_color{
-                (u8)(GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() * 255),
-                (u8)(GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() * 255)
-            };
+            int s = (int)(uv[i].u() * float24::FromFloat32(static_cast<float>(texture.config.width))).ToFloat32();
+            int t = (int)(uv[i].v() * float24::FromFloat32(static_cast<float>(texture.config.height))).ToFloat32();
+            static auto GetWrappedTexCoord = [](Regs::TextureConfig::WrapMode mode, int val, unsigned size) {
+                switch (mode) {
+                    case Regs::TextureConfig::ClampToEdge:
+                        val = std::max(val, 0);
+                        val = std::min(val, (int)size - 1);
+                        return val;
 
-            Math::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+                    case Regs::TextureConfig::ClampToBorder:
+                        return val;
 
-            Math::Vec4<u8> texture_color[3]{};
-            for (int i = 0; i < 3; ++i) {
-                const auto& texture = textures[i];
-                if (!texture.enabled)
-                    continue;
+                    case Regs::TextureConfig::Repeat:
+                        return (int)((unsigned)val % size);
 
-                DEBUG_ASSERT(0 != texture.config.address);
-
-                int s = (int)(uv[i].u() * float24::FromFloat32(static_cast<float>(texture.config.width))).ToFloat32();
-                int t = (int)(uv[i].v() * float24::FromFloat32(static_cast<float>(texture.config.height))).ToFloat32();
-                static auto GetWrappedTexCoord = [](Regs::TextureConfig::WrapMode mode, int val, unsigned size) {
-                    switch (mode) {
-                        case Regs::TextureConfig::ClampToEdge:
-                            val = std::max(val, 0);
-                            val = std::min(val, (int)size - 1);
-                            return val;
-
-                        case Regs::TextureConfig::ClampToBorder:
-                            return val;
-
-                        case Regs::TextureConfig::Repeat:
-                            return (int)((unsigned)val % size);
-
-                        case Regs::TextureConfig::MirroredRepeat:
-                        {
-                            unsigned int coord = ((unsigned)val % (2 * size));
-                            if (coord >= size)
-                                coord = 2 * size - 1 - coord;
-                            return (int)coord;
-                        }
-
-                        default:
-                            LOG_ERROR(HW_GPU, "Unknown texture coordinate wrapping mode %x", (int)mode);
-                            UNIMPLEMENTED();
-                            return 0;
+                    case Regs::TextureConfig::MirroredRepeat:
+                    {
+                        unsigned int coord = ((unsigned)val % (2 * size));
+                        if (coord >= size)
+                            coord = 2 * size - 1 - coord;
+                        return (int)coord;
                     }
-                };
 
-                if ((texture.config.wrap_s == Regs::TextureConfig::ClampToBorder && (s < 0 || s >= texture.config.width))
-                    || (texture.config.wrap_t == Regs::TextureConfig::ClampToBorder && (t < 0 || t >= texture.config.height))) {
-                    auto border_color = texture.config.border_color;
-                    texture_color[i] = { border_color.r, border_color.g, border_color.b, border_color.a };
-                } else {
-                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
-                    // NOTE: This may not be the right place for the inversion.
-                    // TODO: Check if this applies to ETC textures, too.
-                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
-                    t = texture.config.height - 1 - GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown texture coordinate wrapping mode %x", (int)mode);
+                        UNIMPLEMENTED();
+                        return 0;
+                }
+            };
 
+            if ((texture.config.wrap_s == Regs::TextureConfig::ClampToBorder && (s < 0 || s >= texture.config.width))
+                || (texture.config.wrap_t == Regs::TextureConfig::ClampToBorder && (t < 0 || t >= texture.config.height))) {
+                auto border_color = texture.config.border_color;
+                texture_color[i] = { border_color.r, border_color.g, border_color.b, border_color.a };
+            } else {
+                // Textures are laid out from bottom to top, hence we invert the t coordinate.
+                // NOTE: This may not be the right place for the inversion.
+                // TODO: Check if this applies to ETC textures, too.
+                s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
+                t = texture.config.height - 1 - GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+
+                // TODO: Apply the min and mag filters to the texture
+                const auto* decoded_texture = decoded_textures[i];
+                if (decoded_texture != nullptr) {
+                    texture_color[i] = decoded_texture->texels[t * decoded_texture->width + s];
+                } else {
                     u8* texture_data = Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress());
                     auto info = DebugUtils::TextureInfo::FromPicaRegister(texture.config, texture.format);
 
-                    // TODO: Apply the min and mag filters to the texture
                     texture_color[i] = DebugUtils::LookupTexture(texture_data, s, t, info);
 #if PICA_DUMP_TEXTURES
                     DebugUtils::DumpTexture(texture.config, texture_data);
 #endif
                 }
             }
+        }
 
+        Math::Vec4<u8> combiner_output;
+
+#ifdef ARCHITECTURE_x86_64
+        if (tev_combiner != nullptr) {
+            // The compiled combiner also performs the alpha test
+            const TevInputs inputs{ primary_color, { texture_color[0], texture_color[1], texture_color[2] } };
+            if (!tev_combiner(&inputs, &combiner_output))
+                return;
+        } else
+#endif // ARCHITECTURE_x86_64
+        {
             // Texture environment - consists of 6 stages of color and alpha combining.
             //
             // Color combiners take three input color values from some source (e.g. interpolated
@@ -497,7 +1010,6 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
             // operations on each of them (e.g. inversion) and then calculate the output color
             // with some basic arithmetic. Alpha combiners can be configured separately but work
             // analogously.
-            Math::Vec4<u8> combiner_output;
             Math::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
             Math::Vec4<u8> next_combiner_buffer = {
                 regs.tev_combiner_buffer_color.r, regs.tev_combiner_buffer_color.g,
@@ -761,7 +1273,6 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
                 }
             }
 
-            const auto& output_merger = regs.output_merger;
             // TODO: Does alpha testing happen before or after stencil?
             if (output_merger.alpha_test.enable) {
                 bool pass = false;
@@ -801,346 +1312,579 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
                 }
 
                 if (!pass)
-                    continue;
+                    return;
             }
+        }
 
-            u8 old_stencil = 0;
+        if (!early_depth_stencil && !TestDepthStencil(x, y, w0, w1, w2))
+            return;
 
-            auto UpdateStencil = [stencil_test, x, y, &old_stencil](Pica::Regs::StencilAction action) {
-                u8 new_stencil = PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) | (old_stencil & ~stencil_test.write_mask));
-            };
+        const int index = tile.GetIndex(x >> 4, y >> 4);
+        auto dest = tile.GetColor(index);
+        Math::Vec4<u8> blend_output = combiner_output;
 
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+        if (output_merger.alphablend_enable) {
+            auto params = output_merger.alpha_blending;
 
-                bool pass = false;
-                switch (stencil_test.func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
+            auto LookupFactorRGB = [&](Regs::BlendFactor factor) -> Math::Vec3<u8> {
+                switch (factor) {
+                case Regs::BlendFactor::Zero :
+                    return Math::Vec3<u8>(0, 0, 0);
 
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
+                case Regs::BlendFactor::One :
+                    return Math::Vec3<u8>(255, 255, 255);
 
-                case Regs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
+                case Regs::BlendFactor::SourceColor:
+                    return combiner_output.rgb();
 
-                case Regs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
+                case Regs::BlendFactor::OneMinusSourceColor:
+                    return Math::Vec3<u8>(255 - combiner_output.r(), 255 - combiner_output.g(), 255 - combiner_output.b());
 
-                case Regs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
+                case Regs::BlendFactor::DestColor:
+                    return dest.rgb();
 
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
+                case Regs::BlendFactor::OneMinusDestColor:
+                    return Math::Vec3<u8>(255 - dest.r(), 255 - dest.g(), 255 - dest.b());
 
-                case Regs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
+                case Regs::BlendFactor::SourceAlpha:
+                    return Math::Vec3<u8>(combiner_output.a(), combiner_output.a(), combiner_output.a());
 
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
+                case Regs::BlendFactor::OneMinusSourceAlpha:
+                    return Math::Vec3<u8>(255 - combiner_output.a(), 255 - combiner_output.a(), 255 - combiner_output.a());
+
+                case Regs::BlendFactor::DestAlpha:
+                    return Math::Vec3<u8>(dest.a(), dest.a(), dest.a());
+
+                case Regs::BlendFactor::OneMinusDestAlpha:
+                    return Math::Vec3<u8>(255 - dest.a(), 255 - dest.a(), 255 - dest.a());
+
+                case Regs::BlendFactor::ConstantColor:
+                    return Math::Vec3<u8>(output_merger.blend_const.r, output_merger.blend_const.g, output_merger.blend_const.b);
+
+                case Regs::BlendFactor::OneMinusConstantColor:
+                    return Math::Vec3<u8>(255 - output_merger.blend_const.r, 255 - output_merger.blend_const.g, 255 - output_merger.blend_const.b);
+
+                case Regs::BlendFactor::ConstantAlpha:
+                    return Math::Vec3<u8>(output_merger.blend_const.a, output_merger.blend_const.a, output_merger.blend_const.a);
+
+                case Regs::BlendFactor::OneMinusConstantAlpha:
+                    return Math::Vec3<u8>(255 - output_merger.blend_const.a, 255 - output_merger.blend_const.a, 255 - output_merger.blend_const.a);
+
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown color blend factor %x", factor);
+                    UNIMPLEMENTED();
                     break;
                 }
 
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
-                }
-            }
+                return {};
+            };
 
-            // TODO: Does depth indeed only get written even if depth testing is enabled?
-            if (output_merger.depth_test_enable) {
-                unsigned num_bits = Regs::DepthBitsPerPixel(regs.framebuffer.depth_format);
-                u32 z = (u32)((v0.screenpos[2].ToFloat32() * w0 +
-                               v1.screenpos[2].ToFloat32() * w1 +
-                               v2.screenpos[2].ToFloat32() * w2) * ((1 << num_bits) - 1) / wsum);
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
+            auto LookupFactorA = [&](Regs::BlendFactor factor) -> u8 {
+                switch (factor) {
+                case Regs::BlendFactor::Zero:
+                    return 0;
 
-                bool pass = false;
+                case Regs::BlendFactor::One:
+                    return 255;
 
-                switch (output_merger.depth_test_func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
+                case Regs::BlendFactor::SourceAlpha:
+                    return combiner_output.a();
 
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
+                case Regs::BlendFactor::OneMinusSourceAlpha:
+                    return 255 - combiner_output.a();
 
-                case Regs::CompareFunc::Equal:
-                    pass = z == ref_z;
+                case Regs::BlendFactor::DestAlpha:
+                    return dest.a();
+
+                case Regs::BlendFactor::OneMinusDestAlpha:
+                    return 255 - dest.a();
+
+                case Regs::BlendFactor::ConstantAlpha:
+                    return output_merger.blend_const.a;
+
+                case Regs::BlendFactor::OneMinusConstantAlpha:
+                    return 255 - output_merger.blend_const.a;
+
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown alpha blend factor %x", factor);
+                    UNIMPLEMENTED();
                     break;
+                }
 
-                case Regs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
+                return {};
+            };
+
+            static auto EvaluateBlendEquation = [](const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
+                                                   const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
+                                                   Regs::BlendEquation equation) {
+                Math::Vec4<int> result;
+
+                auto src_result = (src  *  srcfactor).Cast<int>();
+                auto dst_result = (dest * destfactor).Cast<int>();
+
+                switch (equation) {
+                case Regs::BlendEquation::Add:
+                    result = (src_result + dst_result) / 255;
                     break;
 
-                case Regs::CompareFunc::LessThan:
-                    pass = z < ref_z;
+                case Regs::BlendEquation::Subtract:
+                    result = (src_result - dst_result) / 255;
                     break;
 
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
+                case Regs::BlendEquation::ReverseSubtract:
+                    result = (dst_result - src_result) / 255;
                     break;
 
-                case Regs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
+                // TODO: How do these two actually work?
+                //       OpenGL doesn't include the blend factors in the min/max computations,
+                //       but is this what the 3DS actually does?
+                case Regs::BlendEquation::Min:
+                    result.r() = std::min(src.r(), dest.r());
+                    result.g() = std::min(src.g(), dest.g());
+                    result.b() = std::min(src.b(), dest.b());
+                    result.a() = std::min(src.a(), dest.a());
                     break;
 
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
+                case Regs::BlendEquation::Max:
+                    result.r() = std::max(src.r(), dest.r());
+                    result.g() = std::max(src.g(), dest.g());
+                    result.b() = std::max(src.b(), dest.b());
+                    result.a() = std::max(src.a(), dest.a());
                     break;
-                }
 
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
+                default:
+                    LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
+                    UNIMPLEMENTED();
                 }
 
-                if (output_merger.depth_write_enable)
-                    SetDepth(x >> 4, y >> 4, z);
-            }
+                return Math::Vec4<u8>(MathUtil::Clamp(result.r(), 0, 255),
+                                MathUtil::Clamp(result.g(), 0, 255),
+                                MathUtil::Clamp(result.b(), 0, 255),
+                                MathUtil::Clamp(result.a(), 0, 255));
+            };
 
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
+            auto srcfactor = Math::MakeVec(LookupFactorRGB(params.factor_source_rgb),
+                                           LookupFactorA(params.factor_source_a));
+            auto dstfactor = Math::MakeVec(LookupFactorRGB(params.factor_dest_rgb),
+                                           LookupFactorA(params.factor_dest_a));
 
-            auto dest = GetPixel(x >> 4, y >> 4);
-            Math::Vec4<u8> blend_output = combiner_output;
+            blend_output     = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_rgb);
+            blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_a).a();
+        } else {
+            static auto LogicOp = [](u8 src, u8 dest, Regs::LogicOp op) -> u8 {
+                switch (op) {
+                case Regs::LogicOp::Clear:
+                    return 0;
 
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
+                case Regs::LogicOp::And:
+                    return src & dest;
 
-                auto LookupFactorRGB = [&](Regs::BlendFactor factor) -> Math::Vec3<u8> {
-                    switch (factor) {
-                    case Regs::BlendFactor::Zero :
-                        return Math::Vec3<u8>(0, 0, 0);
+                case Regs::LogicOp::AndReverse:
+                    return src & ~dest;
 
-                    case Regs::BlendFactor::One :
-                        return Math::Vec3<u8>(255, 255, 255);
+                case Regs::LogicOp::Copy:
+                    return src;
 
-                    case Regs::BlendFactor::SourceColor:
-                        return combiner_output.rgb();
+                case Regs::LogicOp::Set:
+                    return 255;
 
-                    case Regs::BlendFactor::OneMinusSourceColor:
-                        return Math::Vec3<u8>(255 - combiner_output.r(), 255 - combiner_output.g(), 255 - combiner_output.b());
+                case Regs::LogicOp::CopyInverted:
+                    return ~src;
 
-                    case Regs::BlendFactor::DestColor:
-                        return dest.rgb();
+                case Regs::LogicOp::NoOp:
+                    return dest;
 
-                    case Regs::BlendFactor::OneMinusDestColor:
-                        return Math::Vec3<u8>(255 - dest.r(), 255 - dest.g(), 255 - dest.b());
+                case Regs::LogicOp::Invert:
+                    return ~dest;
 
-                    case Regs::BlendFactor::SourceAlpha:
-                        return Math::Vec3<u8>(combiner_output.a(), combiner_output.a(), combiner_output.a());
+                case Regs::LogicOp::Nand:
+                    return ~(src & dest);
 
-                    case Regs::BlendFactor::OneMinusSourceAlpha:
-                        return Math::Vec3<u8>(255 - combiner_output.a(), 255 - combiner_output.a(), 255 - combiner_output.a());
+                case Regs::LogicOp::Or:
+                    return src | dest;
 
-                    case Regs::BlendFactor::DestAlpha:
-                        return Math::Vec3<u8>(dest.a(), dest.a(), dest.a());
+                case Regs::LogicOp::Nor:
+                    return ~(src | dest);
 
-                    case Regs::BlendFactor::OneMinusDestAlpha:
-                        return Math::Vec3<u8>(255 - dest.a(), 255 - dest.a(), 255 - dest.a());
+                case Regs::LogicOp::Xor:
+                    return src ^ dest;
 
-                    case Regs::BlendFactor::ConstantColor:
-                        return Math::Vec3<u8>(output_merger.blend_const.r, output_merger.blend_const.g, output_merger.blend_const.b);
+                case Regs::LogicOp::Equiv:
+                    return ~(src ^ dest);
 
-                    case Regs::BlendFactor::OneMinusConstantColor:
-                        return Math::Vec3<u8>(255 - output_merger.blend_const.r, 255 - output_merger.blend_const.g, 255 - output_merger.blend_const.b);
+                case Regs::LogicOp::AndInverted:
+                    return ~src & dest;
 
-                    case Regs::BlendFactor::ConstantAlpha:
-                        return Math::Vec3<u8>(output_merger.blend_const.a, output_merger.blend_const.a, output_merger.blend_const.a);
+                case Regs::LogicOp::OrReverse:
+                    return src | ~dest;
 
-                    case Regs::BlendFactor::OneMinusConstantAlpha:
-                        return Math::Vec3<u8>(255 - output_merger.blend_const.a, 255 - output_merger.blend_const.a, 255 - output_merger.blend_const.a);
+                case Regs::LogicOp::OrInverted:
+                    return ~src | dest;
+                }
+            };
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown color blend factor %x", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
+            blend_output = Math::MakeVec(
+                LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
+                LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
+                LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
+                LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+        }
 
-                    return {};
-                };
+        const Math::Vec4<u8> result = {
+            output_merger.red_enable   ? blend_output.r() : dest.r(),
+            output_merger.green_enable ? blend_output.g() : dest.g(),
+            output_merger.blue_enable  ? blend_output.b() : dest.b(),
+            output_merger.alpha_enable ? blend_output.a() : dest.a()
+        };
 
-                auto LookupFactorA = [&](Regs::BlendFactor factor) -> u8 {
-                    switch (factor) {
-                    case Regs::BlendFactor::Zero:
-                        return 0;
+        tile.SetColor(index, result);
+    };
+
+    // Edge functions w0, w1 and w2, with edge i running from edge_start[i] to edge_end[i]. These
+    // are linear in x and y, so they're only evaluated directly once per 8x8 block and then
+    // stepped by step_x/step_y per pixel.
+    const Math::Vec2<Fix12P4> edge_start[3] = { vtxpos[1].xy(), vtxpos[2].xy(), vtxpos[0].xy() };
+    const Math::Vec2<Fix12P4> edge_end[3] = { vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy() };
+    const int bias[3] = { bias0, bias1, bias2 };
+    int step_x[3], step_y[3];
+    for (int i = 0; i < 3; ++i) {
+        step_x[i] = ((int)edge_start[i].y - (int)edge_end[i].y) * 0x10;
+        step_y[i] = ((int)edge_end[i].x - (int)edge_start[i].x) * 0x10;
+    }
 
-                    case Regs::BlendFactor::One:
-                        return 255;
+    auto EvaluateEdgeFunctions = [&](u16 x, u16 y, int w[3]) {
+        for (int i = 0; i < 3; ++i)
+            w[i] = bias[i] + SignedArea(edge_start[i], edge_end[i], {x, y});
+    };
 
-                    case Regs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
+#ifdef ARCHITECTURE_x86_64
+    const __m128i lane_steps[3] = {
+        _mm_setr_epi32(0, step_x[0], 2 * step_x[0], 3 * step_x[0]),
+        _mm_setr_epi32(0, step_x[1], 2 * step_x[1], 3 * step_x[1]),
+        _mm_setr_epi32(0, step_x[2], 2 * step_x[2], 3 * step_x[2]),
+    };
+#endif
 
-                    case Regs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
+    // Returns a bit mask of which of the four pixels starting at the one with the given edge
+    // function values are covered by the triangle
+    auto GetCoverageMask = [&](const int w[3]) -> unsigned {
+#ifdef ARCHITECTURE_x86_64
+        __m128i w0 = _mm_add_epi32(_mm_set1_epi32(w[0]), lane_steps[0]);
+        __m128i w1 = _mm_add_epi32(_mm_set1_epi32(w[1]), lane_steps[1]);
+        __m128i w2 = _mm_add_epi32(_mm_set1_epi32(w[2]), lane_steps[2]);
+        // A pixel is outside if the sign bit of any of its edge functions is set
+        __m128i outside = _mm_or_si128(_mm_or_si128(w0, w1), w2);
+        return ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if ((w[0] + i * step_x[0]) >= 0 && (w[1] + i * step_x[1]) >= 0 && (w[2] + i * step_x[2]) >= 0)
+                mask |= 1 << i;
+        }
+        return mask;
+#endif
+    };
 
-                    case Regs::BlendFactor::DestAlpha:
-                        return dest.a();
+    // Whole blocks can be rejected using the coarse depth buffer when all of their fragments fail
+    // the depth test without side effects, i.e. without stencil updates. The depth of the fragments
+    // is bounded by its values at the block corners and by the vertex depths, plus some slack for
+    // the rounding of the per-pixel computation.
+    const bool hiz_available = !hiz_blocks.empty();
+    const bool depth_writes = output_merger.depth_test_enable && output_merger.depth_write_enable;
+    bool hiz_enable = hiz_available && early_depth_stencil && output_merger.depth_test_enable &&
+                      (!stencil_action_enable ||
+                       (stencil_test.action_stencil_fail == Regs::StencilAction::Keep &&
+                        stencil_test.action_depth_fail == Regs::StencilAction::Keep));
+    switch (output_merger.depth_test_func) {
+    case Regs::CompareFunc::LessThan:
+    case Regs::CompareFunc::LessThanOrEqual:
+    case Regs::CompareFunc::GreaterThan:
+    case Regs::CompareFunc::GreaterThanOrEqual:
+        break;
 
-                    case Regs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
+    default:
+        hiz_enable = false;
+        break;
+    }
 
-                    case Regs::BlendFactor::ConstantAlpha:
-                        return output_merger.blend_const.a;
+    const double depth_scale = (1 << Regs::DepthBitsPerPixel(regs.framebuffer.depth_format)) - 1;
+    const double vertex_depth[3] = { v0.screenpos[2].ToFloat32() * depth_scale,
+                                     v1.screenpos[2].ToFloat32() * depth_scale,
+                                     v2.screenpos[2].ToFloat32() * depth_scale };
+    const double min_vertex_depth = std::min({ vertex_depth[0], vertex_depth[1], vertex_depth[2] });
+    const double max_vertex_depth = std::max({ vertex_depth[0], vertex_depth[1], vertex_depth[2] });
+    const double depth_slack = 16.0;
+
+    // Returns whether all fragments in a block fail the depth test, given the edge functions at the
+    // four corners of the block
+    auto IsBlockOccluded = [&](const HiZBlock& block, const int corner_w[4][3]) {
+        double min_depth = max_vertex_depth;
+        double max_depth = min_vertex_depth;
+        for (int corner = 0; corner < 4; ++corner) {
+            const int* w = corner_w[corner];
+            double depth = (vertex_depth[0] * w[0] + vertex_depth[1] * w[1] + vertex_depth[2] * w[2]) /
+                           (w[0] + w[1] + w[2]);
+            min_depth = std::min(min_depth, depth);
+            max_depth = std::max(max_depth, depth);
+        }
+        min_depth = std::max(min_depth, min_vertex_depth) - depth_slack;
+        max_depth = std::min(max_depth, max_vertex_depth) + depth_slack;
 
-                    case Regs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - output_merger.blend_const.a;
+        switch (output_merger.depth_test_func) {
+        case Regs::CompareFunc::LessThan:
+            return min_depth >= block.max_depth;
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown alpha blend factor %x", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
+        case Regs::CompareFunc::LessThanOrEqual:
+            return min_depth > block.max_depth;
 
-                    return {};
-                };
+        case Regs::CompareFunc::GreaterThan:
+            return max_depth <= block.min_depth;
 
-                static auto EvaluateBlendEquation = [](const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
-                                                       const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
-                                                       Regs::BlendEquation equation) {
-                    Math::Vec4<int> result;
-
-                    auto src_result = (src  *  srcfactor).Cast<int>();
-                    auto dst_result = (dest * destfactor).Cast<int>();
-
-                    switch (equation) {
-                    case Regs::BlendEquation::Add:
-                        result = (src_result + dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::Subtract:
-                        result = (src_result - dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::ReverseSubtract:
-                        result = (dst_result - src_result) / 255;
-                        break;
-
-                    // TODO: How do these two actually work?
-                    //       OpenGL doesn't include the blend factors in the min/max computations,
-                    //       but is this what the 3DS actually does?
-                    case Regs::BlendEquation::Min:
-                        result.r() = std::min(src.r(), dest.r());
-                        result.g() = std::min(src.g(), dest.g());
-                        result.b() = std::min(src.b(), dest.b());
-                        result.a() = std::min(src.a(), dest.a());
-                        break;
-
-                    case Regs::BlendEquation::Max:
-                        result.r() = std::max(src.r(), dest.r());
-                        result.g() = std::max(src.g(), dest.g());
-                        result.b() = std::max(src.b(), dest.b());
-                        result.a() = std::max(src.a(), dest.a());
-                        break;
+        case Regs::CompareFunc::GreaterThanOrEqual:
+            return max_depth < block.min_depth;
 
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
-                        UNIMPLEMENTED();
-                    }
+        default:
+            return false;
+        }
+    };
 
-                    return Math::Vec4<u8>(MathUtil::Clamp(result.r(), 0, 255),
-                                    MathUtil::Clamp(result.g(), 0, 255),
-                                    MathUtil::Clamp(result.b(), 0, 255),
-                                    MathUtil::Clamp(result.a(), 0, 255));
-                };
+    // Enter rasterization loop, walking the bounding box in blocks of 8x8 pixels. The blocks are
+    // aligned to those of the coarse depth buffer.
+    const int first_block_x = (min_x >> 4) & ~(HIZ_BLOCK_SIZE - 1);
+    const int first_block_y = (min_y >> 4) & ~(HIZ_BLOCK_SIZE - 1);
+    for (int block_y = first_block_y; block_y < (max_y >> 4); block_y += HIZ_BLOCK_SIZE) {
+        for (int block_x = first_block_x; block_x < (max_x >> 4); block_x += HIZ_BLOCK_SIZE) {
+            // Centers of the first and last pixels of the block within the bounding box
+            u16 first_x = std::max<int>(block_x << 4, min_x) + 8;
+            u16 first_y = std::max<int>(block_y << 4, min_y) + 8;
+            u16 last_x = std::min<int>((block_x + HIZ_BLOCK_SIZE) << 4, max_x) - 8;
+            u16 last_y = std::min<int>((block_y + HIZ_BLOCK_SIZE) << 4, max_y) - 8;
+            int steps_x = (last_x - first_x) >> 4;
+            int steps_y = (last_y - first_y) >> 4;
+
+            int w_row[3];
+            EvaluateEdgeFunctions(first_x, first_y, w_row);
+
+            // Skip the block if all of its corners are outside of the same edge. Since the edge
+            // functions are linear, no pixel inside the block can be covered then.
+            int corner_w[4][3];
+            bool outside = false;
+            for (int i = 0; i < 3; ++i) {
+                corner_w[0][i] = w_row[i];
+                corner_w[1][i] = w_row[i] + steps_x * step_x[i];
+                corner_w[2][i] = w_row[i] + steps_y * step_y[i];
+                corner_w[3][i] = corner_w[1][i] + steps_y * step_y[i];
+                if (corner_w[0][i] < 0 && corner_w[1][i] < 0 && corner_w[2][i] < 0 && corner_w[3][i] < 0)
+                    outside = true;
+            }
+            if (outside)
+                continue;
 
-                auto srcfactor = Math::MakeVec(LookupFactorRGB(params.factor_source_rgb),
-                                               LookupFactorA(params.factor_source_a));
-                auto dstfactor = Math::MakeVec(LookupFactorRGB(params.factor_dest_rgb),
-                                               LookupFactorA(params.factor_dest_a));
+            HiZBlock* hiz_block = hiz_available ? &GetHiZBlock(block_x, block_y) : nullptr;
+            if (hiz_enable) {
+                UpdateHiZBlock(*hiz_block, block_x, block_y);
+                if (IsBlockOccluded(*hiz_block, corner_w))
+                    continue;
+            }
 
-                blend_output     = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor, params.blend_equation_a).a();
-            } else {
-                static auto LogicOp = [](u8 src, u8 dest, Regs::LogicOp op) -> u8 {
-                    switch (op) {
-                    case Regs::LogicOp::Clear:
-                        return 0;
+            // Any depth write makes the coarse depth range out of date
+            if (hiz_block != nullptr && depth_writes)
+                hiz_block->valid = false;
+
+            // Find the covered pixels first, so that only those are loaded from the framebuffer
+            const int first_index = (((first_y >> 4) - block_y) * HIZ_BLOCK_SIZE) + ((first_x >> 4) - block_x);
+            u64 coverage = 0;
+            int w[3] = { w_row[0], w_row[1], w_row[2] };
+            for (int row = 0; row <= steps_y; ++row) {
+                int w_pixel[3] = { w[0], w[1], w[2] };
+                for (int column = 0; column <= steps_x; column += 4) {
+                    unsigned num_pixels = std::min(4, steps_x - column + 1);
+                    u64 mask = GetCoverageMask(w_pixel) & ((1 << num_pixels) - 1);
+                    coverage |= mask << (first_index + row * HIZ_BLOCK_SIZE + column);
+
+                    for (int i = 0; i < 3; ++i)
+                        w_pixel[i] += 4 * step_x[i];
+                }
 
-                    case Regs::LogicOp::And:
-                        return src & dest;
+                for (int i = 0; i < 3; ++i)
+                    w[i] += step_y[i];
+            }
+            if (coverage == 0)
+                continue;
 
-                    case Regs::LogicOp::AndReverse:
-                        return src & ~dest;
+            tile.Reset(&framebuffer_accessor, block_x, block_y, coverage);
+            for (int index : BitSet64(coverage)) {
+                int column = index % HIZ_BLOCK_SIZE - first_index % HIZ_BLOCK_SIZE;
+                int row = index / HIZ_BLOCK_SIZE - first_index / HIZ_BLOCK_SIZE;
+                ShadePixel(first_x + column * 0x10, first_y + row * 0x10,
+                           w_row[0] + column * step_x[0] + row * step_y[0],
+                           w_row[1] + column * step_x[1] + row * step_y[1],
+                           w_row[2] + column * step_x[2] + row * step_y[2]);
+            }
+            framebuffer_accessor.Store(tile);
+        }
+    }
+}
 
-                    case Regs::LogicOp::Copy:
-                        return src;
+/// Returns the pixels of the current color/depth buffers, in rasterizer coordinates
+static PixelRect GetFramebufferRect() {
+    const auto& framebuffer = g_state.regs.framebuffer;
+    return { 0, 0, static_cast<int>(framebuffer.GetWidth()), static_cast<int>(framebuffer.GetHeight()) };
+}
 
-                    case Regs::LogicOp::Set:
-                        return 255;
+/**
+ * Returns the pixels of the given screen tile in rasterizer coordinates. Tiles are laid out like
+ * the framebuffer in memory, i.e. from the top of the screen to the bottom, so that they line up
+ * with the Morton tiles.
+ */
+static PixelRect GetTileRect(int tile_x, int tile_y) {
+    // NOTE: The framebuffer height register contains the actual FB height minus one.
+    const int height = g_state.regs.framebuffer.height;
+    const int fb_width = static_cast<int>(g_state.regs.framebuffer.GetWidth());
 
-                    case Regs::LogicOp::CopyInverted:
-                        return ~src;
+    return { tile_x * BIN_TILE_SIZE,
+             std::max(0, height + 1 - (tile_y + 1) * BIN_TILE_SIZE),
+             std::min(fb_width, (tile_x + 1) * BIN_TILE_SIZE),
+             height + 1 - tile_y * BIN_TILE_SIZE };
+}
 
-                    case Regs::LogicOp::NoOp:
-                        return dest;
+/**
+ * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
+ * culling via recursion.
+ */
+static void ProcessTriangleInternal(const Shader::OutputVertex& v0,
+                                    const Shader::OutputVertex& v1,
+                                    const Shader::OutputVertex& v2,
+                                    bool reversed = false)
+{
+    const auto& regs = g_state.regs;
 
-                    case Regs::LogicOp::Invert:
-                        return ~dest;
+    Math::Vec3<Fix12P4> vtxpos[3]{ ScreenToRasterizerCoordinates(v0.screenpos),
+                                   ScreenToRasterizerCoordinates(v1.screenpos),
+                                   ScreenToRasterizerCoordinates(v2.screenpos) };
 
-                    case Regs::LogicOp::Nand:
-                        return ~(src & dest);
+    if (regs.cull_mode == Regs::CullMode::KeepAll) {
+        // Make sure we always end up with a triangle wound counter-clockwise
+        if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
+            ProcessTriangleInternal(v0, v2, v1, true);
+            return;
+        }
+    } else {
+        if (!reversed && regs.cull_mode == Regs::CullMode::KeepClockWise) {
+            // Reverse vertex order and use the CCW code path.
+            ProcessTriangleInternal(v0, v2, v1, true);
+            return;
+        }
 
-                    case Regs::LogicOp::Or:
-                        return src | dest;
+        // Cull away triangles which are wound clockwise.
+        if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
+            return;
+    }
 
-                    case Regs::LogicOp::Nor:
-                        return ~(src | dest);
+    // Done here rather than in RasterizeTriangle since that may run on several threads at once
+    if (draw_state_dirty) {
+        SetupDrawState();
+        draw_state_dirty = false;
+    }
 
-                    case Regs::LogicOp::Xor:
-                        return src ^ dest;
+    if (VideoCore::GetWorkerThreads() == nullptr) {
+        Common::Profiling::ScopeTimer timer(rasterization_category);
+        MICROPROFILE_SCOPE(GPU_Rasterization);
 
-                    case Regs::LogicOp::Equiv:
-                        return ~(src ^ dest);
+        RasterizeTriangle(v0, v1, v2, GetFramebufferRect());
+        return;
+    }
 
-                    case Regs::LogicOp::AndInverted:
-                        return ~src & dest;
+    queued_triangles.push_back({ v0, v1, v2 });
+}
 
-                    case Regs::LogicOp::OrReverse:
-                        return src | ~dest;
+void ProcessTriangle(const Shader::OutputVertex& v0,
+                     const Shader::OutputVertex& v1,
+                     const Shader::OutputVertex& v2) {
+    ProcessTriangleInternal(v0, v1, v2);
+}
 
-                    case Regs::LogicOp::OrInverted:
-                        return ~src | dest;
-                    }
-                };
+void Flush() {
+    // This is called whenever a register is written, so the draw state has to be set up again
+    // for the next triangle. The queued triangles were all submitted with the current one.
+    draw_state_dirty = true;
 
-                blend_output = Math::MakeVec(
-                    LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                    LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                    LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                    LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
-            }
+    if (queued_triangles.empty())
+        return;
 
-            const Math::Vec4<u8> result = {
-                output_merger.red_enable   ? blend_output.r() : dest.r(),
-                output_merger.green_enable ? blend_output.g() : dest.g(),
-                output_merger.blue_enable  ? blend_output.b() : dest.b(),
-                output_merger.alpha_enable ? blend_output.a() : dest.a()
-            };
+    Common::Profiling::ScopeTimer timer(rasterization_category);
+    MICROPROFILE_SCOPE(GPU_Rasterization);
 
-            DrawPixel(x >> 4, y >> 4, result);
+    const auto& framebuffer = g_state.regs.framebuffer;
+    const int height = framebuffer.height;
+    const int num_tiles_x = (static_cast<int>(framebuffer.GetWidth()) + BIN_TILE_SIZE - 1) / BIN_TILE_SIZE;
+    const int num_tiles_y = (static_cast<int>(framebuffer.GetHeight()) + BIN_TILE_SIZE - 1) / BIN_TILE_SIZE;
+
+    // Bin the triangles into all tiles overlapped by their bounding box. Pixels outside the
+    // framebuffer are dropped.
+    tile_bins.resize(num_tiles_x * num_tiles_y);
+    for (u32 index = 0; index < queued_triangles.size(); ++index) {
+        const QueuedTriangle& triangle = queued_triangles[index];
+        Math::Vec3<Fix12P4> vtxpos[3]{ ScreenToRasterizerCoordinates(triangle.v0.screenpos),
+                                       ScreenToRasterizerCoordinates(triangle.v1.screenpos),
+                                       ScreenToRasterizerCoordinates(triangle.v2.screenpos) };
+        PixelRect bounding_box = GetBoundingBox(vtxpos);
+        if (bounding_box.min_x >= bounding_box.max_x || bounding_box.min_y >= bounding_box.max_y)
+            continue;
+
+        // Framebuffer rows are counted from the top of the screen
+        int min_row = height - (bounding_box.max_y - 1);
+        int max_row = height - bounding_box.min_y;
+
+        int min_tile_x = bounding_box.min_x / BIN_TILE_SIZE;
+        int max_tile_x = std::min((bounding_box.max_x - 1) / BIN_TILE_SIZE, num_tiles_x - 1);
+        int min_tile_y = std::max(min_row, 0) / BIN_TILE_SIZE;
+        int max_tile_y = std::min(max_row / BIN_TILE_SIZE, num_tiles_y - 1);
+        if (max_row < 0)
+            continue;
+
+        for (int tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y) {
+            for (int tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x)
+                tile_bins[tile_y * num_tiles_x + tile_x].push_back(index);
         }
     }
+
+    std::vector<unsigned> active_tiles;
+    for (unsigned tile = 0; tile < tile_bins.size(); ++tile) {
+        if (!tile_bins[tile].empty())
+            active_tiles.push_back(tile);
+    }
+
+    // Each tile is rasterized by a single thread in primitive order, so that depth testing and
+    // blending give the same results as rasterizing the triangles one after another.
+    VideoCore::GetWorkerThreads()->ParallelFor(static_cast<unsigned>(active_tiles.size()), [&](unsigned task) {
+        unsigned tile = active_tiles[task];
+        PixelRect tile_rect = GetTileRect(tile % num_tiles_x, tile / num_tiles_x);
+        for (u32 index : tile_bins[tile]) {
+            const QueuedTriangle& triangle = queued_triangles[index];
+            RasterizeTriangle(triangle.v0, triangle.v1, triangle.v2, tile_rect);
+        }
+    });
+
+    for (auto& bin : tile_bins)
+        bin.clear();
+    queued_triangles.clear();
 }
 
-void ProcessTriangle(const Shader::OutputVertex& v0,
-                     const Shader::OutputVertex& v1,
-                     const Shader::OutputVertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+void InvalidateRegion(PAddr addr, u32 size) {
+    // Decoded textures may be dropped, so they have to be looked up again
+    TextureCache::InvalidateInRange(addr, size);
+    draw_state_dirty = true;
+
+    if (hiz_blocks.empty())
+        return;
+
+    // The depth buffer was written by something other than the rasterizer
+    const u32 depth_buffer_size = hiz_width * hiz_height * Regs::BytesPerDepthPixel(hiz_depth_format);
+    if (addr < hiz_depth_address + depth_buffer_size && hiz_depth_address < addr + size) {
+        for (auto& block : hiz_blocks)
+            block.valid = false;
+    }
 }
 
 } // namespace Rasterizer
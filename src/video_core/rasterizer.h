@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "common/common_types.h"
+
 namespace Pica {
 
 namespace Shader {
@@ -16,6 +18,12 @@ void ProcessTriangle(const Shader::OutputVertex& v0,
                      const Shader::OutputVertex& v1,
                      const Shader::OutputVertex& v2);
 
+/// Rasterizes all triangles queued by ProcessTriangle, must be called before any register changes
+void Flush();
+
+/// Notifies the rasterizer that the given memory region was written by something else, e.g. a memory fill
+void InvalidateRegion(PAddr addr, u32 size);
+
 } // namespace Rasterizer
 
 } // namespace Pica
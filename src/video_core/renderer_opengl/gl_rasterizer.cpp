@@ -719,16 +719,10 @@ void RasterizerOpenGL::ReloadColorBuffer() {
     std::unique_ptr<u8[]> temp_fb_color_buffer(new u8[fb_color_texture.width * fb_color_texture.height * bytes_per_pixel]);
 
     // Directly copy pixels. Internal OpenGL color formats are consistent so no conversion is necessary.
-    for (int y = 0; y < fb_color_texture.height; ++y) {
-        for (int x = 0; x < fb_color_texture.width; ++x) {
-            const u32 coarse_y = y & ~7;
-            u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * fb_color_texture.width * bytes_per_pixel;
-            u32 gl_pixel_index = (x + (fb_color_texture.height - 1 - y) * fb_color_texture.width) * bytes_per_pixel;
-
-            u8* pixel = color_buffer + dst_offset;
-            memcpy(&temp_fb_color_buffer[gl_pixel_index], pixel, bytes_per_pixel);
-        }
-    }
+    // OpenGL stores the rows bottom-up, so start at the last row and go backwards.
+    const int gl_stride = fb_color_texture.width * bytes_per_pixel;
+    VideoCore::TiledToLinear(color_buffer, &temp_fb_color_buffer[(fb_color_texture.height - 1) * gl_stride], -gl_stride,
+                             fb_color_texture.width, fb_color_texture.height, bytes_per_pixel);
 
     state.texture_units[0].texture_2d = fb_color_texture.texture.handle;
     state.Apply();
@@ -832,16 +826,10 @@ void RasterizerOpenGL::CommitColorBuffer() {
             state.Apply();
 
             // Directly copy pixels. Internal OpenGL color formats are consistent so no conversion is necessary.
-            for (int y = 0; y < fb_color_texture.height; ++y) {
-                for (int x = 0; x < fb_color_texture.width; ++x) {
-                    const u32 coarse_y = y & ~7;
-                    u32 dst_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * fb_color_texture.width * bytes_per_pixel;
-                    u32 gl_pixel_index = x * bytes_per_pixel + (fb_color_texture.height - 1 - y) * fb_color_texture.width * bytes_per_pixel;
-
-                    u8* pixel = color_buffer + dst_offset;
-                    memcpy(pixel, &temp_gl_color_buffer[gl_pixel_index], bytes_per_pixel);
-                }
-            }
+            // OpenGL stores the rows bottom-up, so start at the last row and go backwards.
+            const int gl_stride = fb_color_texture.width * bytes_per_pixel;
+            VideoCore::LinearToTiled(&temp_gl_color_buffer[(fb_color_texture.height - 1) * gl_stride], -gl_stride, color_buffer,
+                                     fb_color_texture.width, fb_color_texture.height, bytes_per_pixel);
         }
     }
 }
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "common/hash.h"
 #include "common/make_unique.h"
 #include "common/math_util.h"
@@ -45,11 +47,12 @@ void RasterizerCacheOpenGL::LoadAndBindTexture(OpenGLState &state, unsigned text
         new_texture->hash = Common::ComputeHash64(texture_src_data, new_texture->size);
 
         std::unique_ptr<Math::Vec4<u8>[]> temp_texture_buffer_rgba(new Math::Vec4<u8>[info.width * info.height]);
+        Pica::DebugUtils::DecodeTexture(texture_src_data, info, temp_texture_buffer_rgba.get());
 
-        for (int y = 0; y < info.height; ++y) {
-            for (int x = 0; x < info.width; ++x) {
-                temp_texture_buffer_rgba[x + info.width * y] = Pica::DebugUtils::LookupTexture(texture_src_data, x, info.height - 1 - y, info);
-            }
+        // The rows are uploaded in the opposite order they are decoded in
+        for (int y = 0; y < info.height / 2; ++y) {
+            Math::Vec4<u8>* row = &temp_texture_buffer_rgba[info.width * y];
+            std::swap_ranges(row, row + info.width, &temp_texture_buffer_rgba[info.width * (info.height - 1 - y)]);
         }
 
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, info.width, info.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, temp_texture_buffer_rgba.get());
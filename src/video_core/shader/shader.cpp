@@ -2,15 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/range/algorithm/fill.hpp>
 
+#include "common/file_util.h"
 #include "common/hash.h"
+#include "common/linear_disk_cache.h"
+#include "common/logging/log.h"
 #include "common/make_unique.h"
 #include "common/microprofile.h"
 #include "common/profiler.h"
+#include "common/string_util.h"
+
+#include "core/hle/kernel/process.h"
 
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/pica.h"
@@ -20,6 +30,7 @@
 #include "shader_interpreter.h"
 
 #ifdef ARCHITECTURE_x86_64
+#include "shader_jit_batch_x64.h"
 #include "shader_jit_x64.h"
 #endif // ARCHITECTURE_x86_64
 
@@ -28,38 +39,289 @@ namespace Pica {
 namespace Shader {
 
 #ifdef ARCHITECTURE_x86_64
-static std::unordered_map<u64, CompiledShader*> shader_map;
 static JitCompiler jit;
 static CompiledShader* jit_shader;
+
+static BatchJitCompiler batch_jit;
+static CompiledBatchShader* jit_batch_shader;
+
+/// Number of u32 words of a program source: the main offset, the program code and the swizzle data
+static const u32 PROGRAM_SOURCE_SIZE = 1 +
+    std::tuple_size<decltype(g_state.vs.program_code)>::value +
+    std::tuple_size<decltype(g_state.vs.swizzle_data)>::value;
+
+/**
+ * Upper bound of the code size of a single program, for each of the compilers. A new program is
+ * only compiled if this much code space is left, otherwise the code space is flushed first.
+ */
+static const size_t MAX_PROGRAM_CODE_SIZE = 1024 * 1024;
+
+struct CachedProgram {
+    CompiledShader* shader;
+    // nullptr if the program can't be batched, so that it's only compiled once
+    CompiledBatchShader* batch_shader;
+    /// Bytes of code generated for the program by both compilers
+    size_t code_size;
+    /// Value of program_use_counter when the program was last set up, for LRU eviction
+    u64 last_use;
+    /// Source of the program, kept to recompile it after flushing the code space
+    std::vector<u32> source;
+};
+
+/// Programs that are currently compiled, keyed by a hash of their source
+static std::unordered_map<u64, CachedProgram> program_cache;
+static u64 program_use_counter = 0;
+static JitStatistics jit_statistics;
+
+/// Returns the source of the currently configured vertex shader program
+static std::vector<u32> GetProgramSource() {
+    std::vector<u32> source;
+    source.reserve(PROGRAM_SOURCE_SIZE);
+    source.push_back(g_state.regs.vs.main_offset);
+    source.insert(source.end(), g_state.vs.program_code.begin(), g_state.vs.program_code.end());
+    source.insert(source.end(), g_state.vs.swizzle_data.begin(), g_state.vs.swizzle_data.end());
+    return source;
+}
+
+/// Configures the given program source as the current vertex shader program
+static void SetProgramSource(const u32* source) {
+    auto& code = g_state.vs.program_code;
+    auto& swizzle = g_state.vs.swizzle_data;
+
+    g_state.regs.vs.main_offset.Assign(source[0]);
+    std::copy(source + 1, source + 1 + code.size(), code.begin());
+    std::copy(source + 1 + code.size(), source + PROGRAM_SOURCE_SIZE, swizzle.begin());
+}
+
+/// Compiles the currently configured vertex shader program and stores it under the given key
+static CachedProgram& CompileProgram(u64 cache_key, std::vector<u32> source) {
+    const u8* jit_start = jit.GetCodePtr();
+    const u8* batch_jit_start = batch_jit.GetCodePtr();
+
+    CachedProgram program;
+    program.shader = jit.Compile();
+    program.batch_shader = batch_jit.Compile();
+    program.code_size = (jit.GetCodePtr() - jit_start) + (batch_jit.GetCodePtr() - batch_jit_start);
+    program.last_use = program_use_counter;
+    program.source = std::move(source);
+
+    jit_statistics.code_bytes += program.code_size;
+    jit_statistics.programs_compiled++;
+
+    auto result = program_cache.emplace(cache_key, std::move(program));
+    jit_statistics.programs_resident = static_cast<u32>(program_cache.size());
+    return result.first->second;
+}
+
+/**
+ * Makes room for compiling another program if either code space is running low. The code spaces
+ * are cleared, and the most recently used programs are recompiled until half of the space is
+ * filled again; all other programs are evicted and will be recompiled when they are used again.
+ */
+static void EnsureCodeSpace() {
+    if (jit.GetSpaceLeft() >= MAX_PROGRAM_CODE_SIZE && batch_jit.GetSpaceLeft() >= MAX_PROGRAM_CODE_SIZE)
+        return;
+
+    std::vector<std::pair<u64, CachedProgram>> programs(std::make_move_iterator(program_cache.begin()),
+                                                        std::make_move_iterator(program_cache.end()));
+    std::sort(programs.begin(), programs.end(), [](const std::pair<u64, CachedProgram>& a, const std::pair<u64, CachedProgram>& b) {
+        return a.second.last_use > b.second.last_use;
+    });
+
+    program_cache.clear();
+    jit.Clear();
+    batch_jit.Clear();
+    jit_statistics.code_bytes = 0;
+
+    const size_t jit_retain_limit = jit.GetSpaceLeft() / 2;
+    const size_t batch_jit_retain_limit = batch_jit.GetSpaceLeft() / 2;
+
+    // Recompiling changes the current shader state, so keep the program that's actually in use
+    const std::vector<u32> current_source = GetProgramSource();
+
+    for (auto& entry : programs) {
+        if (jit.GetSpaceLeft() <= jit_retain_limit || batch_jit.GetSpaceLeft() <= batch_jit_retain_limit) {
+            jit_statistics.evictions++;
+            continue;
+        }
+
+        SetProgramSource(entry.second.source.data());
+        CompileProgram(entry.first, std::move(entry.second.source)).last_use = entry.second.last_use;
+    }
+
+    SetProgramSource(current_source.data());
+    jit_statistics.programs_resident = static_cast<u32>(program_cache.size());
+    jit_statistics.flushes++;
+
+    LOG_INFO(HW_GPU, "Flushed shader JIT code space, %u programs kept, %llu evicted in total",
+             jit_statistics.programs_resident, jit_statistics.evictions);
+}
+
+/**
+ * On-disk cache of the shader programs used by the current title, so that they can be compiled
+ * ahead of their first use on the next run. The generated code itself embeds absolute addresses
+ * of emulator state, so the program sources are stored instead and recompiled when loading.
+ *
+ * Each entry is keyed by the same hash as program_cache and holds the program source. The file
+ * header already records the emulator revision, which invalidates the cache whenever the compilers
+ * may have changed.
+ */
+static LinearDiskCache<u64, u32> program_disk_cache;
+static bool program_disk_cache_open = false;
+static u64 program_disk_cache_title_id = 0;
+
+class ProgramCacheReader : public LinearDiskCacheReader<u64, u32> {
+public:
+    void Read(const u64& key, const u32* value, u32 value_size) override {
+        if (value_size != PROGRAM_SOURCE_SIZE || program_cache.count(key) != 0)
+            return;
+
+        EnsureCodeSpace();
+        SetProgramSource(value);
+        CompileProgram(key, std::vector<u32>(value, value + value_size));
+    }
+};
+
+/// Makes sure the program cache of the running title is open, precompiling the programs in it
+static void OpenProgramDiskCache() {
+    if (Kernel::g_current_process == nullptr)
+        return;
+
+    u64 title_id = Kernel::g_current_process->codeset->program_id;
+    if (program_disk_cache_open && program_disk_cache_title_id == title_id)
+        return;
+
+    const std::string& dir = FileUtil::GetUserPath(D_SHADERCACHE_IDX);
+    if (!FileUtil::CreateFullPath(dir))
+        return;
+
+    std::string filename = Common::StringFromFormat("%s%016llX.vs.cache", dir.c_str(), title_id);
+
+    // Loading compiles into the current shader state, so keep the program that's actually in use
+    const std::vector<u32> current_source = GetProgramSource();
+
+    ProgramCacheReader reader;
+    u32 num_programs = program_disk_cache.OpenAndRead(filename.c_str(), reader);
+
+    SetProgramSource(current_source.data());
+
+    LOG_INFO(HW_GPU, "Loaded %u vertex shader programs from %s", num_programs, filename.c_str());
+
+    program_disk_cache_open = true;
+    program_disk_cache_title_id = title_id;
+}
+
+/// Appends the given program to the on-disk cache
+static void AppendToProgramDiskCache(u64 cache_key, const std::vector<u32>& source) {
+    if (!program_disk_cache_open)
+        return;
+
+    program_disk_cache.Append(cache_key, source.data(), static_cast<u32>(source.size()));
+    program_disk_cache.Sync();
+}
 #endif // ARCHITECTURE_x86_64
 
+/// Identifies the current vertex shader program, including its operand descriptors and entry point
+static u64 GetProgramHash() {
+    return Common::ComputeHash64(&g_state.vs.program_code, sizeof(g_state.vs.program_code)) ^
+        Common::ComputeHash64(&g_state.vs.swizzle_data, sizeof(g_state.vs.swizzle_data)) ^
+        g_state.regs.vs.main_offset;
+}
+
 void Setup(UnitState<false>& state) {
+    u64 cache_key = GetProgramHash();
+
+    // Decoding is cached as well, so keep the interpreter ready even when the JIT is used in case
+    // it gets disabled at runtime
+    SetupInterpreter(cache_key);
+
 #ifdef ARCHITECTURE_x86_64
     if (VideoCore::g_shader_jit_enabled) {
-        u64 cache_key = (Common::ComputeHash64(&g_state.vs.program_code, sizeof(g_state.vs.program_code)) ^
-            Common::ComputeHash64(&g_state.vs.swizzle_data, sizeof(g_state.vs.swizzle_data)) ^
-            g_state.regs.vs.main_offset);
+        OpenProgramDiskCache();
 
-        auto iter = shader_map.find(cache_key);
-        if (iter != shader_map.end()) {
-            jit_shader = iter->second;
+        auto iter = program_cache.find(cache_key);
+        CachedProgram* program;
+        if (iter != program_cache.end()) {
+            program = &iter->second;
         } else {
-            jit_shader = jit.Compile();
-            shader_map.emplace(cache_key, jit_shader);
+            EnsureCodeSpace();
+            program = &CompileProgram(cache_key, GetProgramSource());
+            AppendToProgramDiskCache(cache_key, program->source);
         }
+
+        program->last_use = ++program_use_counter;
+        jit_shader = program->shader;
+        jit_batch_shader = program->batch_shader;
     }
 #endif // ARCHITECTURE_x86_64
 }
 
 void Shutdown() {
+    ShutdownInterpreter();
+
 #ifdef ARCHITECTURE_x86_64
-    shader_map.clear();
+    program_disk_cache.Close();
+    program_disk_cache_open = false;
+
+    program_cache.clear();
+    jit.Clear();
+    batch_jit.Clear();
+    jit_statistics = {};
+#endif // ARCHITECTURE_x86_64
+}
+
+const JitStatistics& GetJitStatistics() {
+#ifdef ARCHITECTURE_x86_64
+    return jit_statistics;
+#else
+    static const JitStatistics no_statistics = {};
+    return no_statistics;
 #endif // ARCHITECTURE_x86_64
 }
 
 static Common::Profiling::TimingCategory shader_category("Vertex Shader");
 MICROPROFILE_DEFINE(GPU_VertexShader, "GPU", "Vertex Shader", MP_RGB(50, 50, 240));
 
+/// Maps the output registers of the vertex shader to the attributes of the output vertex
+static OutputVertex ConvertOutput(const Math::Vec4<float24>* output_registers) {
+    OutputVertex ret;
+    // TODO(neobrain): Under some circumstances, up to 16 attributes may be output. We need to
+    // figure out what those circumstances are and enable the remaining outputs then.
+    for (int i = 0; i < 7; ++i) {
+        const auto& output_register_map = g_state.regs.vs_output_attributes[i]; // TODO: Don't hardcode VS here
+
+        u32 semantics[4] = {
+            output_register_map.map_x, output_register_map.map_y,
+            output_register_map.map_z, output_register_map.map_w
+        };
+
+        for (int comp = 0; comp < 4; ++comp) {
+            float24* out = ((float24*)&ret) + semantics[comp];
+            if (semantics[comp] != Regs::VSOutputAttributes::INVALID) {
+                *out = output_registers[i][comp];
+            } else {
+                // Zero output so that attributes which aren't output won't have denormals in them,
+                // which would slow us down later.
+                memset(out, 0, sizeof(*out));
+            }
+        }
+    }
+
+    // The hardware takes the absolute and saturates vertex colors like this, *before* doing interpolation
+    for (int i = 0; i < 4; ++i) {
+        ret.color[i] = float24::FromFloat32(
+            std::fmin(std::fabs(ret.color[i].ToFloat32()), 1.0f));
+    }
+
+    LOG_TRACE(Render_Software, "Output vertex: pos (%.2f, %.2f, %.2f, %.2f), quat (%.2f, %.2f, %.2f, %.2f), col(%.2f, %.2f, %.2f, %.2f), tc0(%.2f, %.2f)",
+        ret.pos.x.ToFloat32(), ret.pos.y.ToFloat32(), ret.pos.z.ToFloat32(), ret.pos.w.ToFloat32(),
+        ret.quat.x.ToFloat32(), ret.quat.y.ToFloat32(), ret.quat.z.ToFloat32(), ret.quat.w.ToFloat32(),
+        ret.color.x.ToFloat32(), ret.color.y.ToFloat32(), ret.color.z.ToFloat32(), ret.color.w.ToFloat32(),
+        ret.tc0.u().ToFloat32(), ret.tc0.v().ToFloat32());
+
+    return ret;
+}
+
 OutputVertex Run(UnitState<false>& state, const InputVertex& input, int num_attributes) {
     auto& config = g_state.regs.vs;
 
@@ -104,43 +366,57 @@ OutputVertex Run(UnitState<false>& state, const InputVertex& input, int num_attr
     RunInterpreter(state);
 #endif // ARCHITECTURE_x86_64
 
-    // Setup output data
-    OutputVertex ret;
-    // TODO(neobrain): Under some circumstances, up to 16 attributes may be output. We need to
-    // figure out what those circumstances are and enable the remaining outputs then.
-    for (int i = 0; i < 7; ++i) {
-        const auto& output_register_map = g_state.regs.vs_output_attributes[i]; // TODO: Don't hardcode VS here
+    return ConvertOutput(state.registers.output);
+}
 
-        u32 semantics[4] = {
-            output_register_map.map_x, output_register_map.map_y,
-            output_register_map.map_z, output_register_map.map_w
+void RunBatch(UnitState<false>& state, const InputVertex* inputs, OutputVertex* outputs, int count, int num_attributes) {
+    ASSERT(count <= BATCH_SIZE);
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled && jit_batch_shader != nullptr) {
+        auto& config = g_state.regs.vs;
+
+        Common::Profiling::ScopeTimer timer(shader_category);
+        MICROPROFILE_SCOPE(GPU_VertexShader);
+
+        const auto& attribute_register_map = config.input_register_map;
+        const u32 input_registers[16] = {
+            static_cast<u32>(attribute_register_map.attribute0_register), static_cast<u32>(attribute_register_map.attribute1_register),
+            static_cast<u32>(attribute_register_map.attribute2_register), static_cast<u32>(attribute_register_map.attribute3_register),
+            static_cast<u32>(attribute_register_map.attribute4_register), static_cast<u32>(attribute_register_map.attribute5_register),
+            static_cast<u32>(attribute_register_map.attribute6_register), static_cast<u32>(attribute_register_map.attribute7_register),
+            static_cast<u32>(attribute_register_map.attribute8_register), static_cast<u32>(attribute_register_map.attribute9_register),
+            static_cast<u32>(attribute_register_map.attribute10_register), static_cast<u32>(attribute_register_map.attribute11_register),
+            static_cast<u32>(attribute_register_map.attribute12_register), static_cast<u32>(attribute_register_map.attribute13_register),
+            static_cast<u32>(attribute_register_map.attribute14_register), static_cast<u32>(attribute_register_map.attribute15_register),
         };
 
-        for (int comp = 0; comp < 4; ++comp) {
-            float24* out = ((float24*)&ret) + semantics[comp];
-            if (semantics[comp] != Regs::VSOutputAttributes::INVALID) {
-                *out = state.registers.output[i][comp];
-            } else {
-                // Zero output so that attributes which aren't output won't have denormals in them,
-                // which would slow us down later.
-                memset(out, 0, sizeof(*out));
+        // Transpose the input vertices into the batch register layout. Unused lanes keep stale
+        // values, their results are simply not read back.
+        auto& batch = state.batch_registers;
+        for (int attr = 0; attr < num_attributes; ++attr) {
+            for (int comp = 0; comp < 4; ++comp) {
+                for (int lane = 0; lane < count; ++lane)
+                    batch.input[input_registers[attr]][comp][lane] = inputs[lane].attr[attr][comp].ToFloat32();
             }
         }
-    }
 
-    // The hardware takes the absolute and saturates vertex colors like this, *before* doing interpolation
-    for (int i = 0; i < 4; ++i) {
-        ret.color[i] = float24::FromFloat32(
-            std::fmin(std::fabs(ret.color[i].ToFloat32()), 1.0f));
-    }
+        jit_batch_shader(&batch);
 
-    LOG_TRACE(Render_Software, "Output vertex: pos (%.2f, %.2f, %.2f, %.2f), quat (%.2f, %.2f, %.2f, %.2f), col(%.2f, %.2f, %.2f, %.2f), tc0(%.2f, %.2f)",
-        ret.pos.x.ToFloat32(), ret.pos.y.ToFloat32(), ret.pos.z.ToFloat32(), ret.pos.w.ToFloat32(),
-        ret.quat.x.ToFloat32(), ret.quat.y.ToFloat32(), ret.quat.z.ToFloat32(), ret.quat.w.ToFloat32(),
-        ret.color.x.ToFloat32(), ret.color.y.ToFloat32(), ret.color.z.ToFloat32(), ret.color.w.ToFloat32(),
-        ret.tc0.u().ToFloat32(), ret.tc0.v().ToFloat32());
+        for (int lane = 0; lane < count; ++lane) {
+            Math::Vec4<float24> output_registers[16];
+            for (int reg = 0; reg < 16; ++reg) {
+                for (int comp = 0; comp < 4; ++comp)
+                    output_registers[reg][comp] = float24::FromFloat32(batch.output[reg][comp][lane]);
+            }
+            outputs[lane] = ConvertOutput(output_registers);
+        }
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
 
-    return ret;
+    for (int lane = 0; lane < count; ++lane)
+        outputs[lane] = Run(state, inputs[lane], num_attributes);
 }
 
 DebugData<true> ProduceDebugInfo(const InputVertex& input, int num_attributes, const Regs::ShaderConfig& config, const State::ShaderSetup& setup) {
@@ -175,7 +451,9 @@ DebugData<true> ProduceDebugInfo(const InputVertex& input, int num_attributes, c
     state.conditional_code[0] = false;
     state.conditional_code[1] = false;
 
-    RunInterpreter(state);
+    // Decode the program separately, the decoded programs used for emulation belong to the GPU thread
+    auto program = DecodeProgram(setup);
+    RunInterpreter(setup, *program, state);
     return state.debug;
 }
 
@@ -24,6 +24,9 @@ namespace Pica {
 
 namespace Shader {
 
+/// Number of vertices processed together by RunBatch
+const int BATCH_SIZE = 4;
+
 struct InputVertex {
     Math::Vec4<float24> attr[16];
 };
@@ -264,6 +267,19 @@ struct UnitState {
     } registers;
     static_assert(std::is_pod<Registers>::value, "Structure is not POD");
 
+    /**
+     * Registers of a batch of vertices processed by the batched shader JIT. They are stored as a
+     * structure of arrays, so that each SSE register holds the same component of all vertices.
+     */
+    struct BatchRegisters {
+        float MEMORY_ALIGNED16(input[16][4][BATCH_SIZE]);
+        float MEMORY_ALIGNED16(output[16][4][BATCH_SIZE]);
+        float MEMORY_ALIGNED16(temporary[16][4][BATCH_SIZE]);
+        // Used to pass values to functions called from the compiled code
+        float MEMORY_ALIGNED16(scratch[BATCH_SIZE]);
+    } batch_registers;
+    static_assert(std::is_pod<BatchRegisters>::value, "Structure is not POD");
+
     u32 program_counter;
     bool conditional_code[2];
 
@@ -316,6 +332,34 @@ struct UnitState {
             return 0;
         }
     }
+
+    static size_t BatchInputOffset(const SourceRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return offsetof(UnitState::BatchRegisters, input) + reg.GetIndex() * sizeof(BatchRegisters::input[0]);
+
+        case RegisterType::Temporary:
+            return offsetof(UnitState::BatchRegisters, temporary) + reg.GetIndex() * sizeof(BatchRegisters::temporary[0]);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
+
+    static size_t BatchOutputOffset(const DestRegister& reg) {
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Output:
+            return offsetof(UnitState::BatchRegisters, output) + reg.GetIndex() * sizeof(BatchRegisters::output[0]);
+
+        case RegisterType::Temporary:
+            return offsetof(UnitState::BatchRegisters, temporary) + reg.GetIndex() * sizeof(BatchRegisters::temporary[0]);
+
+        default:
+            UNREACHABLE();
+            return 0;
+        }
+    }
 };
 
 /**
@@ -328,6 +372,23 @@ void Setup(UnitState<false>& state);
 /// Performs any cleanup when the emulator is shutdown
 void Shutdown();
 
+/// Metrics of the shader JIT code cache
+struct JitStatistics {
+    /// Bytes of code currently generated for resident programs
+    u64 code_bytes;
+    /// Number of programs currently compiled
+    u32 programs_resident;
+    /// Number of programs compiled, including recompilations
+    u64 programs_compiled;
+    /// Number of programs dropped to make room in the code space
+    u64 evictions;
+    /// Number of times the code space was flushed
+    u64 flushes;
+};
+
+/// Returns the metrics of the shader JIT code cache since the last shutdown
+const JitStatistics& GetJitStatistics();
+
 /**
  * Runs the currently setup shader
  * @param state Shader unit state, must be setup per shader and per shader unit
@@ -337,6 +398,17 @@ void Shutdown();
  */
 OutputVertex Run(UnitState<false>& state, const InputVertex& input, int num_attributes);
 
+/**
+ * Runs the currently setup shader on a batch of vertices. Uses the batched shader JIT if the shader
+ * could be compiled for it, and otherwise runs the vertices one at a time.
+ * @param state Shader unit state, must be setup per shader and per shader unit
+ * @param inputs Input vertices into the shader
+ * @param outputs Output vertices, after having been processed by the vertex shader
+ * @param count Number of vertices in the batch, at most BATCH_SIZE
+ * @param num_attributes The number of vertex shader attributes
+ */
+void RunBatch(UnitState<false>& state, const InputVertex* inputs, OutputVertex* outputs, int count, int num_attributes);
+
 /**
  * Produce debug information based on the given shader and input vertex
  * @param input Input vertex into the shader
@@ -2,16 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <common/file_util.h>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
 
 #include <nihstro/shader_bytecode.h>
 
+#include "common/logging/log.h"
+
 #include "video_core/pica.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
 
 using nihstro::OpCode;
 using nihstro::Instruction;
+using nihstro::DestRegister;
 using nihstro::RegisterType;
 using nihstro::SourceRegister;
 using nihstro::SwizzlePattern;
@@ -20,15 +26,270 @@ namespace Pica {
 
 namespace Shader {
 
+namespace {
+
+/// Operations of decoded instructions. Arithmetic operations come first, see IsArithmetic.
+enum class Op : u8 {
+    ADD, DP3, DP4, DPH, MUL, SGE, SLT, FLR, MAX, MIN, RCP, RSQ, MOVA, MOV, CMP, EX2, LG2,
+    UnhandledArithmetic,
+
+    MAD,
+    UnhandledMultiplyAdd,
+
+    NOP, END, JMPC, JMPU, CALL, CALLC, CALLU, IFU, IFC, LOOP,
+    Unhandled,
+};
+
+/**
+ * Instruction with its operand descriptor resolved, so that the interpreter loop doesn't need to
+ * look up opcode information or unpack swizzle bitfields for every executed instruction.
+ */
+struct DecodedInstruction {
+    Op op;
+    /// Number of source operands to load
+    u8 num_srcs;
+    SourceRegister src[3];
+    /// Component selected from the source register for each source and component
+    u8 selector[3][4];
+    bool negate[3];
+    DestRegister dest;
+    /// Bit i is set if component i of the destination is written
+    u8 dest_mask;
+    /// Address register added to the source `offset_src` (0 for none)
+    u8 address_register_index;
+    u8 offset_src;
+    u8 operand_desc_id;
+    /// Original instruction, for flow control parameters and comparison operations
+    Instruction instr;
+};
+
+} // anonymous namespace
+
+struct DecodedProgram {
+    std::array<DecodedInstruction, std::tuple_size<decltype(State::ShaderSetup::program_code)>::value> instructions;
+};
+
+namespace {
+
+static bool IsArithmetic(Op op) {
+    return op <= Op::UnhandledArithmetic;
+}
+
+static void DecodeSwizzle(DecodedInstruction& decoded, const SwizzlePattern& swizzle) {
+    for (int i = 0; i < 4; ++i) {
+        decoded.selector[0][i] = static_cast<u8>(swizzle.GetSelectorSrc1(i));
+        decoded.selector[1][i] = static_cast<u8>(swizzle.GetSelectorSrc2(i));
+        decoded.selector[2][i] = static_cast<u8>(swizzle.GetSelectorSrc3(i));
+        if (swizzle.DestComponentEnabled(i))
+            decoded.dest_mask |= 1 << i;
+    }
+
+    decoded.negate[0] = swizzle.negate_src1 != 0;
+    decoded.negate[1] = swizzle.negate_src2 != 0;
+    decoded.negate[2] = swizzle.negate_src3 != 0;
+}
+
+static Op DecodeArithmeticOp(OpCode::Id opcode, u8& num_srcs) {
+    num_srcs = 2;
+    switch (opcode) {
+    case OpCode::Id::ADD: return Op::ADD;
+    case OpCode::Id::DP3: return Op::DP3;
+    case OpCode::Id::DP4: return Op::DP4;
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI: return Op::DPH;
+    case OpCode::Id::MUL: return Op::MUL;
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI: return Op::SGE;
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI: return Op::SLT;
+    case OpCode::Id::MAX: return Op::MAX;
+    case OpCode::Id::MIN: return Op::MIN;
+    case OpCode::Id::CMP: return Op::CMP;
+    default: break;
+    }
+
+    num_srcs = 1;
+    switch (opcode) {
+    case OpCode::Id::FLR: return Op::FLR;
+    case OpCode::Id::RCP: return Op::RCP;
+    case OpCode::Id::RSQ: return Op::RSQ;
+    case OpCode::Id::MOVA: return Op::MOVA;
+    case OpCode::Id::MOV: return Op::MOV;
+    case OpCode::Id::EX2: return Op::EX2;
+    case OpCode::Id::LG2: return Op::LG2;
+    default: break;
+    }
+
+    num_srcs = 0;
+    return Op::UnhandledArithmetic;
+}
+
+static Op DecodeFlowControlOp(OpCode::Id opcode) {
+    switch (opcode) {
+    case OpCode::Id::NOP: return Op::NOP;
+    case OpCode::Id::END: return Op::END;
+    case OpCode::Id::JMPC: return Op::JMPC;
+    case OpCode::Id::JMPU: return Op::JMPU;
+    case OpCode::Id::CALL: return Op::CALL;
+    case OpCode::Id::CALLC: return Op::CALLC;
+    case OpCode::Id::CALLU: return Op::CALLU;
+    case OpCode::Id::IFU: return Op::IFU;
+    case OpCode::Id::IFC: return Op::IFC;
+    case OpCode::Id::LOOP: return Op::LOOP;
+    default: return Op::Unhandled;
+    }
+}
+
+/// Decodes the given instruction into `decoded`, which is expected to be zero-initialized
+static void DecodeInstruction(Instruction instr, const State::ShaderSetup& setup, DecodedInstruction& decoded) {
+    const auto& swizzle_data = setup.swizzle_data;
+
+    decoded.instr.hex = instr.hex;
+
+    switch (instr.opcode.Value().GetInfo().type) {
+    case OpCode::Type::Arithmetic:
+    {
+        const bool is_inverted = (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+        decoded.op = DecodeArithmeticOp(instr.opcode.Value().EffectiveOpCode(), decoded.num_srcs);
+        decoded.src[0] = instr.common.GetSrc1(is_inverted);
+        decoded.src[1] = instr.common.GetSrc2(is_inverted);
+        decoded.dest = instr.common.dest.Value();
+        decoded.address_register_index = static_cast<u8>(instr.common.address_register_index);
+        decoded.offset_src = is_inverted ? 1 : 0;
+        decoded.operand_desc_id = static_cast<u8>(instr.common.operand_desc_id);
+        DecodeSwizzle(decoded, { swizzle_data[instr.common.operand_desc_id] });
+        break;
+    }
+
+    case OpCode::Type::MultiplyAdd:
+    {
+        const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+        if (opcode != OpCode::Id::MAD && opcode != OpCode::Id::MADI) {
+            decoded.op = Op::UnhandledMultiplyAdd;
+            break;
+        }
+
+        const bool is_inverted = (opcode == OpCode::Id::MADI);
+
+        decoded.op = Op::MAD;
+        decoded.num_srcs = 3;
+        decoded.src[0] = instr.mad.GetSrc1(is_inverted);
+        decoded.src[1] = instr.mad.GetSrc2(is_inverted);
+        decoded.src[2] = instr.mad.GetSrc3(is_inverted);
+        decoded.dest = instr.mad.dest.Value();
+        decoded.operand_desc_id = static_cast<u8>(instr.mad.operand_desc_id);
+        DecodeSwizzle(decoded, { swizzle_data[instr.mad.operand_desc_id] });
+        break;
+    }
+
+    default:
+        decoded.op = DecodeFlowControlOp(instr.opcode.Value());
+        break;
+    }
+}
+
+/// Decodes the program of `setup` into `program`, which is expected to be zero-initialized
+static void DecodeProgram(const State::ShaderSetup& setup, DecodedProgram& program) {
+    for (size_t i = 0; i < setup.program_code.size(); ++i)
+        DecodeInstruction({ setup.program_code[i] }, setup, program.instructions[i]);
+}
+
+/// Programs decoded so far, keyed by program hash
+static std::unordered_map<u64, std::unique_ptr<DecodedProgram>> decoded_programs;
+/// Program run by RunInterpreter, set up by SetupInterpreter
+static const DecodedProgram* current_program = nullptr;
+
+/// Upper bound for the number of decoded programs kept around (each takes about 40KiB)
+static const size_t MAX_DECODED_PROGRAMS = 64;
+
+} // anonymous namespace
+
+void SetupInterpreter(u64 program_hash) {
+    auto iter = decoded_programs.find(program_hash);
+    if (iter != decoded_programs.end()) {
+        current_program = iter->second.get();
+        return;
+    }
+
+    if (decoded_programs.size() >= MAX_DECODED_PROGRAMS)
+        decoded_programs.clear();
+
+    std::unique_ptr<DecodedProgram> program(new DecodedProgram());
+    DecodeProgram(g_state.vs, *program);
+
+    current_program = program.get();
+    decoded_programs.emplace(program_hash, std::move(program));
+}
+
+void ShutdownInterpreter() {
+    decoded_programs.clear();
+    current_program = nullptr;
+}
+
+std::shared_ptr<const DecodedProgram> DecodeProgram(const State::ShaderSetup& setup) {
+    std::shared_ptr<DecodedProgram> program(new DecodedProgram());
+    DecodeProgram(setup, *program);
+    return program;
+}
+
 template<bool Debug>
 void RunInterpreter(UnitState<Debug>& state) {
-    const auto& uniforms = g_state.vs.uniforms;
-    const auto& swizzle_data = g_state.vs.swizzle_data;
-    const auto& program_code = g_state.vs.program_code;
+    ASSERT_MSG(current_program != nullptr, "Interpreter not set up");
+    RunInterpreter(g_state.vs, *current_program, state);
+}
+
+template<bool Debug>
+void RunInterpreter(const State::ShaderSetup& setup, const DecodedProgram& decoded_program, UnitState<Debug>& state) {
+    const auto& uniforms = setup.uniforms;
+    const auto& program = decoded_program.instructions;
 
     // Placeholder for invalid inputs
     static float24 dummy_vec4_float24[4];
 
+    auto LookupSourceRegister = [&](const SourceRegister& source_reg) -> const float24* {
+        switch (source_reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return &state.registers.input[source_reg.GetIndex()].x;
+
+        case RegisterType::Temporary:
+            return &state.registers.temporary[source_reg.GetIndex()].x;
+
+        case RegisterType::FloatUniform:
+            return &uniforms.f[source_reg.GetIndex()].x;
+
+        default:
+            return dummy_vec4_float24;
+        }
+    };
+
+    auto call = [&](u32 offset, u32 num_instructions, u32 return_offset, u8 repeat_count, u8 loop_increment) {
+        state.program_counter = offset - 1; // -1 to make sure when incrementing the PC we end up at the correct offset
+        ASSERT(state.call_stack.size() < state.call_stack.capacity());
+        state.call_stack.push_back({ offset + num_instructions, return_offset, repeat_count, loop_increment, offset });
+    };
+
+    auto evaluate_condition = [&](const Instruction& instr) {
+        bool results[2] = { instr.flow_control.refx == state.conditional_code[0],
+                            instr.flow_control.refy == state.conditional_code[1] };
+
+        switch (instr.flow_control.op) {
+        case Instruction::FlowControlType::Or:
+            return results[0] || results[1];
+
+        case Instruction::FlowControlType::And:
+            return results[0] && results[1];
+
+        case Instruction::FlowControlType::JustX:
+            return results[0];
+
+        case Instruction::FlowControlType::JustY:
+            return results[1];
+        }
+
+        return false;
+    };
+
     unsigned iteration = 0;
     bool exit_loop = false;
     while (!exit_loop) {
@@ -49,569 +310,397 @@ void RunInterpreter(UnitState<Debug>& state) {
             }
         }
 
-        const Instruction instr = { program_code[state.program_counter] };
-        const SwizzlePattern swizzle = { swizzle_data[instr.common.operand_desc_id] };
+        const DecodedInstruction& instr = program[state.program_counter];
 
-        static auto call = [](UnitState<Debug>& state, u32 offset, u32 num_instructions,
-                              u32 return_offset, u8 repeat_count, u8 loop_increment) {
-            state.program_counter = offset - 1; // -1 to make sure when incrementing the PC we end up at the correct offset
-            ASSERT(state.call_stack.size() < state.call_stack.capacity());
-            state.call_stack.push_back({ offset + num_instructions, return_offset, repeat_count, loop_increment, offset });
-        };
         Record<DebugDataRecord::CUR_INSTR>(state.debug, iteration, state.program_counter);
         if (iteration > 0)
             Record<DebugDataRecord::NEXT_INSTR>(state.debug, iteration - 1, state.program_counter);
 
         state.debug.max_offset = std::max<u32>(state.debug.max_offset, 1 + state.program_counter);
 
-        auto LookupSourceRegister = [&](const SourceRegister& source_reg) -> const float24* {
-            switch (source_reg.GetRegisterType()) {
-            case RegisterType::Input:
-                return &state.registers.input[source_reg.GetIndex()].x;
-
-            case RegisterType::Temporary:
-                return &state.registers.temporary[source_reg.GetIndex()].x;
-
-            case RegisterType::FloatUniform:
-                return &uniforms.f[source_reg.GetIndex()].x;
-
-            default:
-                return dummy_vec4_float24;
+        // Load the swizzled and negated source operands
+        float24 src[3][4];
+        auto LoadSource = [&](int n) {
+            const float24* src_;
+            if (n == instr.offset_src && instr.address_register_index != 0)
+                src_ = LookupSourceRegister(instr.src[n] + state.address_registers[instr.address_register_index - 1]);
+            else
+                src_ = LookupSourceRegister(instr.src[n]);
+
+            src[n][0] = src_[instr.selector[n][0]];
+            src[n][1] = src_[instr.selector[n][1]];
+            src[n][2] = src_[instr.selector[n][2]];
+            src[n][3] = src_[instr.selector[n][3]];
+
+            if (instr.negate[n]) {
+                for (int i = 0; i < 4; ++i)
+                    src[n][i] = src[n][i] * float24::FromFloat32(-1);
             }
         };
 
-        switch (instr.opcode.Value().GetInfo().type) {
-        case OpCode::Type::Arithmetic:
-        {
-            const bool is_inverted = (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
-
-            const int address_offset = (instr.common.address_register_index == 0)
-                                       ? 0 : state.address_registers[instr.common.address_register_index - 1];
-
-            const float24* src1_ = LookupSourceRegister(instr.common.GetSrc1(is_inverted) + (!is_inverted * address_offset));
-            const float24* src2_ = LookupSourceRegister(instr.common.GetSrc2(is_inverted) + ( is_inverted * address_offset));
-
-            const bool negate_src1 = ((bool)swizzle.negate_src1 != false);
-            const bool negate_src2 = ((bool)swizzle.negate_src2 != false);
-
-            float24 src1[4] = {
-                src1_[(int)swizzle.GetSelectorSrc1(0)],
-                src1_[(int)swizzle.GetSelectorSrc1(1)],
-                src1_[(int)swizzle.GetSelectorSrc1(2)],
-                src1_[(int)swizzle.GetSelectorSrc1(3)],
-            };
-            if (negate_src1) {
-                src1[0] = src1[0] * float24::FromFloat32(-1);
-                src1[1] = src1[1] * float24::FromFloat32(-1);
-                src1[2] = src1[2] * float24::FromFloat32(-1);
-                src1[3] = src1[3] * float24::FromFloat32(-1);
-            }
-            float24 src2[4] = {
-                src2_[(int)swizzle.GetSelectorSrc2(0)],
-                src2_[(int)swizzle.GetSelectorSrc2(1)],
-                src2_[(int)swizzle.GetSelectorSrc2(2)],
-                src2_[(int)swizzle.GetSelectorSrc2(3)],
-            };
-            if (negate_src2) {
-                src2[0] = src2[0] * float24::FromFloat32(-1);
-                src2[1] = src2[1] * float24::FromFloat32(-1);
-                src2[2] = src2[2] * float24::FromFloat32(-1);
-                src2[3] = src2[3] * float24::FromFloat32(-1);
-            }
+        switch (instr.num_srcs) {
+        case 3: LoadSource(2); // fallthrough
+        case 2: LoadSource(1); // fallthrough
+        case 1: LoadSource(0);
+        }
 
-            float24* dest = (instr.common.dest.Value() < 0x10) ? &state.registers.output[instr.common.dest.Value().GetIndex()][0]
-                        : (instr.common.dest.Value() < 0x20) ? &state.registers.temporary[instr.common.dest.Value().GetIndex()][0]
-                        : dummy_vec4_float24;
+        float24* src1 = src[0];
+        float24* src2 = src[1];
+        float24* src3 = src[2];
 
-            state.debug.max_opdesc_id = std::max<u32>(state.debug.max_opdesc_id, 1+instr.common.operand_desc_id);
+        float24* dest = (instr.dest < 0x10) ? &state.registers.output[instr.dest.GetIndex()][0]
+                      : (instr.dest < 0x20) ? &state.registers.temporary[instr.dest.GetIndex()][0]
+                      : dummy_vec4_float24;
 
-            switch (instr.opcode.Value().EffectiveOpCode()) {
-            case OpCode::Id::ADD:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
+        if (IsArithmetic(instr.op))
+            state.debug.max_opdesc_id = std::max<u32>(state.debug.max_opdesc_id, 1 + instr.operand_desc_id);
 
+        switch (instr.op) {
+        case Op::ADD:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = src1[i] + src2[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
-            case OpCode::Id::MUL:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        case Op::MUL:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = src1[i] * src2[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
-            case OpCode::Id::FLR:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        case Op::FLR:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = float24::FromFloat32(std::floor(src1[i].ToFloat32()));
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-
-            case OpCode::Id::MAX:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
-                    // NOTE: Exact form required to match NaN semantics to hardware:
-                    //   max(0, NaN) -> NaN
-                    //   max(NaN, 0) -> 0
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
+
+        case Op::MAX:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                // NOTE: Exact form required to match NaN semantics to hardware:
+                //   max(0, NaN) -> NaN
+                //   max(NaN, 0) -> 0
+                if (instr.dest_mask & (1 << i))
                     dest[i] = (src1[i] > src2[i]) ? src1[i] : src2[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-
-            case OpCode::Id::MIN:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
-                    // NOTE: Exact form required to match NaN semantics to hardware:
-                    //   min(0, NaN) -> NaN
-                    //   min(NaN, 0) -> 0
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
+
+        case Op::MIN:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                // NOTE: Exact form required to match NaN semantics to hardware:
+                //   min(0, NaN) -> NaN
+                //   min(NaN, 0) -> 0
+                if (instr.dest_mask & (1 << i))
                     dest[i] = (src1[i] < src2[i]) ? src1[i] : src2[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-
-            case OpCode::Id::DP3:
-            case OpCode::Id::DP4:
-            case OpCode::Id::DPH:
-            case OpCode::Id::DPHI:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-
-                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
-                if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
-                    src1[3] = float24::FromFloat32(1.0f);
-
-                float24 dot = float24::FromFloat32(0.f);
-                int num_components = (opcode == OpCode::Id::DP3) ? 3 : 4;
-                for (int i = 0; i < num_components; ++i)
-                    dot = dot + src1[i] * src2[i];
-
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
+        case Op::DP3:
+        case Op::DP4:
+        case Op::DPH:
+        {
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+
+            if (instr.op == Op::DPH)
+                src1[3] = float24::FromFloat32(1.0f);
+
+            float24 dot = float24::FromFloat32(0.f);
+            int num_components = (instr.op == Op::DP3) ? 3 : 4;
+            for (int i = 0; i < num_components; ++i)
+                dot = dot + src1[i] * src2[i];
+
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = dot;
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
+        }
 
-            // Reciprocal
-            case OpCode::Id::RCP:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                float24 rcp_res = float24::FromFloat32(1.0f / src1[0].ToFloat32());
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        // Reciprocal
+        case Op::RCP:
+        {
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            float24 rcp_res = float24::FromFloat32(1.0f / src1[0].ToFloat32());
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = rcp_res;
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
+        }
 
-            // Reciprocal Square Root
-            case OpCode::Id::RSQ:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                float24 rsq_res = float24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32()));
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        // Reciprocal Square Root
+        case Op::RSQ:
+        {
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            float24 rsq_res = float24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32()));
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = rsq_res;
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
+        }
 
-            case OpCode::Id::MOVA:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                for (int i = 0; i < 2; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
-                    // TODO: Figure out how the rounding is done on hardware
+        case Op::MOVA:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            for (int i = 0; i < 2; ++i) {
+                // TODO: Figure out how the rounding is done on hardware
+                if (instr.dest_mask & (1 << i))
                     state.address_registers[i] = static_cast<s32>(src1[i].ToFloat32());
-                }
-                Record<DebugDataRecord::ADDR_REG_OUT>(state.debug, iteration, state.address_registers);
-                break;
             }
+            Record<DebugDataRecord::ADDR_REG_OUT>(state.debug, iteration, state.address_registers);
+            break;
 
-            case OpCode::Id::MOV:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        case Op::MOV:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = src1[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
             }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
-            case OpCode::Id::SGE:
-            case OpCode::Id::SGEI:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
+        case Op::SGE:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = (src1[i] >= src2[i]) ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-
-            case OpCode::Id::SLT:
-            case OpCode::Id::SLTI:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
+        case Op::SLT:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
                     dest[i] = (src1[i] < src2[i]) ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-
-            case OpCode::Id::CMP:
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                for (int i = 0; i < 2; ++i) {
-                    // TODO: Can you restrict to one compare via dest masking?
-
-                    auto compare_op = instr.common.compare_op;
-                    auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
-
-                    switch (op) {
-                        case Instruction::Common::CompareOpType::Equal:
-                            state.conditional_code[i] = (src1[i] == src2[i]);
-                            break;
-
-                        case Instruction::Common::CompareOpType::NotEqual:
-                            state.conditional_code[i] = (src1[i] != src2[i]);
-                            break;
-
-                        case Instruction::Common::CompareOpType::LessThan:
-                            state.conditional_code[i] = (src1[i] <  src2[i]);
-                            break;
-
-                        case Instruction::Common::CompareOpType::LessEqual:
-                            state.conditional_code[i] = (src1[i] <= src2[i]);
-                            break;
-
-                        case Instruction::Common::CompareOpType::GreaterThan:
-                            state.conditional_code[i] = (src1[i] >  src2[i]);
-                            break;
-
-                        case Instruction::Common::CompareOpType::GreaterEqual:
-                            state.conditional_code[i] = (src1[i] >= src2[i]);
-                            break;
-
-                        default:
-                            LOG_ERROR(HW_GPU, "Unknown compare mode %x", static_cast<int>(op));
-                            break;
-                    }
-                }
-                Record<DebugDataRecord::CMP_RESULT>(state.debug, iteration, state.conditional_code);
-                break;
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
-            case OpCode::Id::EX2:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+        case Op::CMP:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            for (int i = 0; i < 2; ++i) {
+                // TODO: Can you restrict to one compare via dest masking?
 
-                // EX2 only takes first component exp2 and writes it to all dest components
-                float24 ex2_res = float24::FromFloat32(std::exp2(src1[0].ToFloat32()));
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
+                auto compare_op = instr.instr.common.compare_op;
+                auto op = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
 
-                    dest[i] = ex2_res;
-                }
+                switch (op) {
+                    case Instruction::Common::CompareOpType::Equal:
+                        state.conditional_code[i] = (src1[i] == src2[i]);
+                        break;
 
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
-            }
+                    case Instruction::Common::CompareOpType::NotEqual:
+                        state.conditional_code[i] = (src1[i] != src2[i]);
+                        break;
 
-            case OpCode::Id::LG2:
-            {
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+                    case Instruction::Common::CompareOpType::LessThan:
+                        state.conditional_code[i] = (src1[i] <  src2[i]);
+                        break;
 
-                // LG2 only takes the first component log2 and writes it to all dest components
-                float24 lg2_res = float24::FromFloat32(std::log2(src1[0].ToFloat32()));
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
+                    case Instruction::Common::CompareOpType::LessEqual:
+                        state.conditional_code[i] = (src1[i] <= src2[i]);
+                        break;
 
-                    dest[i] = lg2_res;
-                }
+                    case Instruction::Common::CompareOpType::GreaterThan:
+                        state.conditional_code[i] = (src1[i] >  src2[i]);
+                        break;
+
+                    case Instruction::Common::CompareOpType::GreaterEqual:
+                        state.conditional_code[i] = (src1[i] >= src2[i]);
+                        break;
 
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-                break;
+                    default:
+                        LOG_ERROR(HW_GPU, "Unknown compare mode %x", static_cast<int>(op));
+                        break;
+                }
             }
+            Record<DebugDataRecord::CMP_RESULT>(state.debug, iteration, state.conditional_code);
+            break;
 
-            default:
-                LOG_ERROR(HW_GPU, "Unhandled arithmetic instruction: 0x%02x (%s): 0x%08x",
-                          (int)instr.opcode.Value().EffectiveOpCode(), instr.opcode.Value().GetInfo().name, instr.hex);
-                DEBUG_ASSERT(false);
-                break;
+        case Op::EX2:
+        {
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+
+            // EX2 only takes first component exp2 and writes it to all dest components
+            float24 ex2_res = float24::FromFloat32(std::exp2(src1[0].ToFloat32()));
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
+                    dest[i] = ex2_res;
             }
 
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
             break;
         }
 
-        case OpCode::Type::MultiplyAdd:
+        case Op::LG2:
         {
-            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
-                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
-                const SwizzlePattern& swizzle = *(SwizzlePattern*)&swizzle_data[instr.mad.operand_desc_id];
-
-                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
-
-                const float24* src1_ = LookupSourceRegister(instr.mad.GetSrc1(is_inverted));
-                const float24* src2_ = LookupSourceRegister(instr.mad.GetSrc2(is_inverted));
-                const float24* src3_ = LookupSourceRegister(instr.mad.GetSrc3(is_inverted));
-
-                const bool negate_src1 = ((bool)swizzle.negate_src1 != false);
-                const bool negate_src2 = ((bool)swizzle.negate_src2 != false);
-                const bool negate_src3 = ((bool)swizzle.negate_src3 != false);
-
-                float24 src1[4] = {
-                    src1_[(int)swizzle.GetSelectorSrc1(0)],
-                    src1_[(int)swizzle.GetSelectorSrc1(1)],
-                    src1_[(int)swizzle.GetSelectorSrc1(2)],
-                    src1_[(int)swizzle.GetSelectorSrc1(3)],
-                };
-                if (negate_src1) {
-                    src1[0] = src1[0] * float24::FromFloat32(-1);
-                    src1[1] = src1[1] * float24::FromFloat32(-1);
-                    src1[2] = src1[2] * float24::FromFloat32(-1);
-                    src1[3] = src1[3] * float24::FromFloat32(-1);
-                }
-                float24 src2[4] = {
-                    src2_[(int)swizzle.GetSelectorSrc2(0)],
-                    src2_[(int)swizzle.GetSelectorSrc2(1)],
-                    src2_[(int)swizzle.GetSelectorSrc2(2)],
-                    src2_[(int)swizzle.GetSelectorSrc2(3)],
-                };
-                if (negate_src2) {
-                    src2[0] = src2[0] * float24::FromFloat32(-1);
-                    src2[1] = src2[1] * float24::FromFloat32(-1);
-                    src2[2] = src2[2] * float24::FromFloat32(-1);
-                    src2[3] = src2[3] * float24::FromFloat32(-1);
-                }
-                float24 src3[4] = {
-                    src3_[(int)swizzle.GetSelectorSrc3(0)],
-                    src3_[(int)swizzle.GetSelectorSrc3(1)],
-                    src3_[(int)swizzle.GetSelectorSrc3(2)],
-                    src3_[(int)swizzle.GetSelectorSrc3(3)],
-                };
-                if (negate_src3) {
-                    src3[0] = src3[0] * float24::FromFloat32(-1);
-                    src3[1] = src3[1] * float24::FromFloat32(-1);
-                    src3[2] = src3[2] * float24::FromFloat32(-1);
-                    src3[3] = src3[3] * float24::FromFloat32(-1);
-                }
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
 
-                float24* dest = (instr.mad.dest.Value() < 0x10) ? &state.registers.output[instr.mad.dest.Value().GetIndex()][0]
-                            : (instr.mad.dest.Value() < 0x20) ? &state.registers.temporary[instr.mad.dest.Value().GetIndex()][0]
-                            : dummy_vec4_float24;
-
-                Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
-                Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
-                Record<DebugDataRecord::SRC3>(state.debug, iteration, src3);
-                Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
-                for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
-                        continue;
-
-                    dest[i] = src1[i] * src2[i] + src3[i];
-                }
-                Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
-            } else {
-                LOG_ERROR(HW_GPU, "Unhandled multiply-add instruction: 0x%02x (%s): 0x%08x",
-                          (int)instr.opcode.Value().EffectiveOpCode(), instr.opcode.Value().GetInfo().name, instr.hex);
+            // LG2 only takes the first component log2 and writes it to all dest components
+            float24 lg2_res = float24::FromFloat32(std::log2(src1[0].ToFloat32()));
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
+                    dest[i] = lg2_res;
             }
+
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
             break;
         }
 
-        default:
-        {
-            static auto evaluate_condition = [](const UnitState<Debug>& state, bool refx, bool refy, Instruction::FlowControlType flow_control) {
-                bool results[2] = { refx == state.conditional_code[0],
-                                    refy == state.conditional_code[1] };
+        case Op::UnhandledArithmetic:
+            LOG_ERROR(HW_GPU, "Unhandled arithmetic instruction: 0x%02x (%s): 0x%08x",
+                      (int)instr.instr.opcode.Value().EffectiveOpCode(), instr.instr.opcode.Value().GetInfo().name, instr.instr.hex);
+            DEBUG_ASSERT(false);
+            break;
 
-                switch (flow_control.op) {
-                case flow_control.Or:
-                    return results[0] || results[1];
+        case Op::MAD:
+            Record<DebugDataRecord::SRC1>(state.debug, iteration, src1);
+            Record<DebugDataRecord::SRC2>(state.debug, iteration, src2);
+            Record<DebugDataRecord::SRC3>(state.debug, iteration, src3);
+            Record<DebugDataRecord::DEST_IN>(state.debug, iteration, dest);
+            for (int i = 0; i < 4; ++i) {
+                if (instr.dest_mask & (1 << i))
+                    dest[i] = src1[i] * src2[i] + src3[i];
+            }
+            Record<DebugDataRecord::DEST_OUT>(state.debug, iteration, dest);
+            break;
 
-                case flow_control.And:
-                    return results[0] && results[1];
+        case Op::UnhandledMultiplyAdd:
+            LOG_ERROR(HW_GPU, "Unhandled multiply-add instruction: 0x%02x (%s): 0x%08x",
+                      (int)instr.instr.opcode.Value().EffectiveOpCode(), instr.instr.opcode.Value().GetInfo().name, instr.instr.hex);
+            break;
 
-                case flow_control.JustX:
-                    return results[0];
+        case Op::NOP:
+            break;
 
-                case flow_control.JustY:
-                    return results[1];
-                }
-            };
+        case Op::END:
+            exit_loop = true;
+            break;
 
-            // Handle each instruction on its own
-            switch (instr.opcode.Value()) {
-            case OpCode::Id::END:
-                exit_loop = true;
-                break;
+        case Op::JMPC:
+            Record<DebugDataRecord::COND_CMP_IN>(state.debug, iteration, state.conditional_code);
+            if (evaluate_condition(instr.instr)) {
+                state.program_counter = instr.instr.flow_control.dest_offset - 1;
+            }
+            break;
 
-            case OpCode::Id::JMPC:
-                Record<DebugDataRecord::COND_CMP_IN>(state.debug, iteration, state.conditional_code);
-                if (evaluate_condition(state, instr.flow_control.refx, instr.flow_control.refy, instr.flow_control)) {
-                    state.program_counter = instr.flow_control.dest_offset - 1;
-                }
-                break;
+        case Op::JMPU:
+            Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.instr.flow_control.bool_uniform_id]);
+            if (uniforms.b[instr.instr.flow_control.bool_uniform_id]) {
+                state.program_counter = instr.instr.flow_control.dest_offset - 1;
+            }
+            break;
 
-            case OpCode::Id::JMPU:
-                Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
-                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
-                    state.program_counter = instr.flow_control.dest_offset - 1;
-                }
-                break;
+        case Op::CALL:
+            call(instr.instr.flow_control.dest_offset,
+                 instr.instr.flow_control.num_instructions,
+                 state.program_counter + 1, 0, 0);
+            break;
 
-            case OpCode::Id::CALL:
-                call(state,
-                     instr.flow_control.dest_offset,
-                     instr.flow_control.num_instructions,
+        case Op::CALLU:
+            Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.instr.flow_control.bool_uniform_id]);
+            if (uniforms.b[instr.instr.flow_control.bool_uniform_id]) {
+                call(instr.instr.flow_control.dest_offset,
+                     instr.instr.flow_control.num_instructions,
                      state.program_counter + 1, 0, 0);
-                break;
-
-            case OpCode::Id::CALLU:
-                Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
-                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
-                    call(state,
-                        instr.flow_control.dest_offset,
-                        instr.flow_control.num_instructions,
-                        state.program_counter + 1, 0, 0);
-                }
-                break;
+            }
+            break;
 
-            case OpCode::Id::CALLC:
-                Record<DebugDataRecord::COND_CMP_IN>(state.debug, iteration, state.conditional_code);
-                if (evaluate_condition(state, instr.flow_control.refx, instr.flow_control.refy, instr.flow_control)) {
-                    call(state,
-                        instr.flow_control.dest_offset,
-                        instr.flow_control.num_instructions,
-                        state.program_counter + 1, 0, 0);
-                }
-                break;
-
-            case OpCode::Id::NOP:
-                break;
-
-            case OpCode::Id::IFU:
-                Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
-                if (uniforms.b[instr.flow_control.bool_uniform_id]) {
-                    call(state,
-                         state.program_counter + 1,
-                         instr.flow_control.dest_offset - state.program_counter - 1,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0);
-                } else {
-                    call(state,
-                         instr.flow_control.dest_offset,
-                         instr.flow_control.num_instructions,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0);
-                }
+        case Op::CALLC:
+            Record<DebugDataRecord::COND_CMP_IN>(state.debug, iteration, state.conditional_code);
+            if (evaluate_condition(instr.instr)) {
+                call(instr.instr.flow_control.dest_offset,
+                     instr.instr.flow_control.num_instructions,
+                     state.program_counter + 1, 0, 0);
+            }
+            break;
 
-                break;
+        case Op::IFU:
+        case Op::IFC:
+        {
+            const auto& flow_control = instr.instr.flow_control;
 
-            case OpCode::Id::IFC:
-            {
+            bool condition;
+            if (instr.op == Op::IFU) {
+                Record<DebugDataRecord::COND_BOOL_IN>(state.debug, iteration, uniforms.b[flow_control.bool_uniform_id]);
+                condition = uniforms.b[flow_control.bool_uniform_id];
+            } else {
                 // TODO: Do we need to consider swizzlers here?
-
                 Record<DebugDataRecord::COND_CMP_IN>(state.debug, iteration, state.conditional_code);
-                if (evaluate_condition(state, instr.flow_control.refx, instr.flow_control.refy, instr.flow_control)) {
-                    call(state,
-                         state.program_counter + 1,
-                         instr.flow_control.dest_offset - state.program_counter - 1,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0);
-                } else {
-                    call(state,
-                         instr.flow_control.dest_offset,
-                         instr.flow_control.num_instructions,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0, 0);
-                }
-
-                break;
+                condition = evaluate_condition(instr.instr);
             }
 
-            case OpCode::Id::LOOP:
-            {
-                Math::Vec4<u8> loop_param(uniforms.i[instr.flow_control.int_uniform_id].x,
-                                          uniforms.i[instr.flow_control.int_uniform_id].y,
-                                          uniforms.i[instr.flow_control.int_uniform_id].z,
-                                          uniforms.i[instr.flow_control.int_uniform_id].w);
-                state.address_registers[2] = loop_param.y;
-
-                Record<DebugDataRecord::LOOP_INT_IN>(state.debug, iteration, loop_param);
-                call(state,
-                     state.program_counter + 1,
-                     instr.flow_control.dest_offset - state.program_counter + 1,
-                     instr.flow_control.dest_offset + 1,
-                     loop_param.x,
-                     loop_param.z);
-                break;
-            }
-
-            default:
-                LOG_ERROR(HW_GPU, "Unhandled instruction: 0x%02x (%s): 0x%08x",
-                          (int)instr.opcode.Value().EffectiveOpCode(), instr.opcode.Value().GetInfo().name, instr.hex);
-                break;
+            if (condition) {
+                call(state.program_counter + 1,
+                     flow_control.dest_offset - state.program_counter - 1,
+                     flow_control.dest_offset + flow_control.num_instructions, 0, 0);
+            } else {
+                call(flow_control.dest_offset,
+                     flow_control.num_instructions,
+                     flow_control.dest_offset + flow_control.num_instructions, 0, 0);
             }
+            break;
+        }
 
+        case Op::LOOP:
+        {
+            const auto& flow_control = instr.instr.flow_control;
+            Math::Vec4<u8> loop_param(uniforms.i[flow_control.int_uniform_id].x,
+                                      uniforms.i[flow_control.int_uniform_id].y,
+                                      uniforms.i[flow_control.int_uniform_id].z,
+                                      uniforms.i[flow_control.int_uniform_id].w);
+            state.address_registers[2] = loop_param.y;
+
+            Record<DebugDataRecord::LOOP_INT_IN>(state.debug, iteration, loop_param);
+            call(state.program_counter + 1,
+                 flow_control.dest_offset - state.program_counter + 1,
+                 flow_control.dest_offset + 1,
+                 loop_param.x,
+                 loop_param.z);
             break;
         }
+
+        case Op::Unhandled:
+            LOG_ERROR(HW_GPU, "Unhandled instruction: 0x%02x (%s): 0x%08x",
+                      (int)instr.instr.opcode.Value().EffectiveOpCode(), instr.instr.opcode.Value().GetInfo().name, instr.instr.hex);
+            break;
         }
 
         ++state.program_counter;
@@ -622,6 +711,8 @@ void RunInterpreter(UnitState<Debug>& state) {
 // Explicit instantiation
 template void RunInterpreter(UnitState<false>& state);
 template void RunInterpreter(UnitState<true>& state);
+template void RunInterpreter(const State::ShaderSetup& setup, const DecodedProgram& program, UnitState<false>& state);
+template void RunInterpreter(const State::ShaderSetup& setup, const DecodedProgram& program, UnitState<true>& state);
 
 } // namespace
 
@@ -4,15 +4,42 @@
 
 #pragma once
 
+#include <memory>
+
+#include "common/common_types.h"
+
 #include "video_core/shader/shader.h"
 
 namespace Pica {
 
 namespace Shader {
 
+/**
+ * Decodes the current vertex shader program for the interpreter, unless a program with the given
+ * hash has been decoded before. Must be called before RunInterpreter whenever the program changes.
+ */
+void SetupInterpreter(u64 program_hash);
+
+/// Releases all decoded programs
+void ShutdownInterpreter();
+
+/// Shader program decoded for the interpreter
+struct DecodedProgram;
+
+/**
+ * Decodes the program of the given shader setup on its own, without touching the programs decoded
+ * by SetupInterpreter, e.g. for the debugger running on another thread.
+ */
+std::shared_ptr<const DecodedProgram> DecodeProgram(const State::ShaderSetup& setup);
+
+/// Runs the program set up by SetupInterpreter with the current vertex shader uniforms
 template<bool Debug>
 void RunInterpreter(UnitState<Debug>& state);
 
+/// Runs the given program with the uniforms of the given shader setup
+template<bool Debug>
+void RunInterpreter(const State::ShaderSetup& setup, const DecodedProgram& program, UnitState<Debug>& state);
+
 } // namespace
 
 } // namespace
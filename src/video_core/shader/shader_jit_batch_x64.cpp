@@ -0,0 +1,643 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cmath>
+#include <cstddef>
+
+#include <smmintrin.h>
+
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "shader.h"
+#include "shader_jit_batch_x64.h"
+
+namespace Pica {
+
+namespace Shader {
+
+using namespace Gen;
+
+typedef void (BatchJitCompiler::*BatchJitFunction)(Instruction instr);
+
+const BatchJitFunction batch_instr_table[64] = {
+    &BatchJitCompiler::Compile_ADD,         // add
+    &BatchJitCompiler::Compile_DP3,         // dp3
+    &BatchJitCompiler::Compile_DP4,         // dp4
+    &BatchJitCompiler::Compile_DPH,         // dph
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_EX2,         // ex2
+    &BatchJitCompiler::Compile_LG2,         // lg2
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_MUL,         // mul
+    &BatchJitCompiler::Compile_SGE,         // sge
+    &BatchJitCompiler::Compile_SLT,         // slt
+    &BatchJitCompiler::Compile_FLR,         // flr
+    &BatchJitCompiler::Compile_MAX,         // max
+    &BatchJitCompiler::Compile_MIN,         // min
+    &BatchJitCompiler::Compile_RCP,         // rcp
+    &BatchJitCompiler::Compile_RSQ,         // rsq
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_Divergent,   // mova
+    &BatchJitCompiler::Compile_MOV,         // mov
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_DPH,         // dphi
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_SGE,         // sgei
+    &BatchJitCompiler::Compile_SLT,         // slti
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    nullptr,                                // unknown
+    &BatchJitCompiler::Compile_NOP,         // nop
+    &BatchJitCompiler::Compile_END,         // end
+    nullptr,                                // break
+    &BatchJitCompiler::Compile_CALL,        // call
+    &BatchJitCompiler::Compile_Divergent,   // callc
+    &BatchJitCompiler::Compile_CALLU,       // callu
+    &BatchJitCompiler::Compile_IFU,         // ifu
+    &BatchJitCompiler::Compile_Divergent,   // ifc
+    &BatchJitCompiler::Compile_LOOP,        // loop
+    nullptr,                                // emit
+    nullptr,                                // sete
+    &BatchJitCompiler::Compile_Divergent,   // jmpc
+    &BatchJitCompiler::Compile_JMPU,        // jmpu
+    &BatchJitCompiler::Compile_NOP,         // cmp
+    &BatchJitCompiler::Compile_NOP,         // cmp
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // madi
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+    &BatchJitCompiler::Compile_MAD,         // mad
+};
+
+// CMP is compiled as a no-op: its results are only consumed by the conditional flow control
+// instructions, which already make a program unsuitable for batching.
+
+// The following is used to alias some commonly used registers. XMM0-XMM3 can be used as scratch
+// registers within a compiler function. The other registers have designated purposes, as
+// documented below:
+
+/// Pointer to the uniform memory
+static const X64Reg UNIFORMS = R9;
+/// VS loop count register
+static const X64Reg LOOPCOUNT_REG = R12;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+static const X64Reg LOOPCOUNT = RSI;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration
+static const X64Reg LOOPINC = RDI;
+/// Pointer to the BatchRegisters instance for the current VS unit
+static const X64Reg REGISTERS = R15;
+/// SIMD scratch register
+static const X64Reg SCRATCH = XMM0;
+/// Loaded with a component of the first source register, otherwise can be used as a scratch register
+static const X64Reg SRC1 = XMM1;
+/// Loaded with a component of the second source register, otherwise can be used as a scratch register
+static const X64Reg SRC2 = XMM2;
+/// Loaded with a component of the third source register, otherwise can be used as a scratch register
+static const X64Reg SRC3 = XMM3;
+/// Per-component results of an instruction, written to the destination register by Compile_StoreDest
+static const X64Reg RESULT[4] = { XMM4, XMM5, XMM6, XMM7 };
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+static const X64Reg ONE = XMM14;
+/// Constant vector of [-0.f, -0.f, -0.f, -0.f], used to efficiently negate a vector with XOR
+static const X64Reg NEGBIT = XMM15;
+
+// State registers that must not be modified by external functions calls
+static const BitSet32 persistent_regs = {
+    UNIFORMS, REGISTERS, // Pointers to register blocks
+    LOOPCOUNT_REG, LOOPCOUNT, LOOPINC, // Cached registers
+    ONE+16, NEGBIT+16, // Constants
+};
+
+/// Distance between two components of a register in the batch register file
+static const int COMPONENT_STRIDE = BATCH_SIZE * sizeof(float);
+
+static bool IsMAD(Instruction instr) {
+    return instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+           instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+}
+
+static SwizzlePattern GetSwizzle(Instruction instr) {
+    unsigned operand_desc_id = IsMAD(instr) ? instr.mad.operand_desc_id : instr.common.operand_desc_id;
+    return { g_state.vs.swizzle_data[operand_desc_id] };
+}
+
+static void Exp2Batch(float* values) {
+    for (int i = 0; i < BATCH_SIZE; ++i)
+        values[i] = std::exp2(values[i]);
+}
+
+static void Log2Batch(float* values) {
+    for (int i = 0; i < BATCH_SIZE; ++i)
+        values[i] = std::log2(values[i]);
+}
+
+void BatchJitCompiler::Compile_LoadSrc(Instruction instr, unsigned src_num, SourceRegister src_reg, unsigned component, X64Reg dest) {
+    bool relative = false;
+
+    if (!IsMAD(instr)) {
+        const bool is_inverted = (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        unsigned offset_src = is_inverted ? 2 : 1;
+
+        if (src_num == offset_src && instr.common.address_register_index != 0) {
+            // Only the loop counter is guaranteed to be the same for all vertices of the batch, and
+            // relative addressing of the other register files may cross into a different file.
+            if (instr.common.address_register_index == 3 && src_reg.GetRegisterType() == RegisterType::FloatUniform) {
+                relative = true;
+            } else {
+                batchable = false;
+            }
+        }
+    }
+
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    unsigned selector;
+    switch (src_num) {
+    case 1: selector = static_cast<unsigned>(swiz.GetSelectorSrc1(component)); break;
+    case 2: selector = static_cast<unsigned>(swiz.GetSelectorSrc2(component)); break;
+    default: selector = static_cast<unsigned>(swiz.GetSelectorSrc3(component)); break;
+    }
+
+    if (src_reg.GetRegisterType() == RegisterType::FloatUniform) {
+        // Uniforms are shared by all vertices, so broadcast the component to all lanes
+        int disp = static_cast<int>(src_reg.GetIndex() * sizeof(float24) * 4 + selector * sizeof(float24));
+
+        if (relative) {
+            MOV(64, R(RAX), R(LOOPCOUNT_REG));
+            SHL(64, R(RAX), Imm8(4));
+            MOVSS(dest, MComplex(UNIFORMS, RAX, SCALE_1, disp));
+        } else {
+            MOVSS(dest, MDisp(UNIFORMS, disp));
+        }
+        SHUFPS(dest, R(dest), _MM_SHUFFLE(0, 0, 0, 0));
+    } else {
+        size_t src_offset = UnitState<false>::BatchInputOffset(src_reg) + selector * COMPONENT_STRIDE;
+        MOVAPS(dest, MDisp(REGISTERS, static_cast<int>(src_offset)));
+    }
+
+    // If the source register should be negated, flip the negative bit using XOR
+    const bool negate[] = { swiz.negate_src1 != 0, swiz.negate_src2 != 0, swiz.negate_src3 != 0 };
+    if (negate[src_num - 1]) {
+        XORPS(dest, R(NEGBIT));
+    }
+}
+
+void BatchJitCompiler::Compile_StoreDest(Instruction instr) {
+    DestRegister dest = IsMAD(instr) ? instr.mad.dest.Value() : instr.common.dest.Value();
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    size_t dest_offset = UnitState<false>::BatchOutputOffset(dest);
+
+    // Write masks are resolved at compile time: only enabled components are stored at all
+    for (int i = 0; i < 4; ++i) {
+        if (swiz.DestComponentEnabled(i))
+            MOVAPS(MDisp(REGISTERS, static_cast<int>(dest_offset + i * COMPONENT_STRIDE)), RESULT[i]);
+    }
+}
+
+void BatchJitCompiler::Compile_StoreDestBroadcast(Instruction instr, X64Reg src) {
+    DestRegister dest = IsMAD(instr) ? instr.mad.dest.Value() : instr.common.dest.Value();
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    size_t dest_offset = UnitState<false>::BatchOutputOffset(dest);
+
+    for (int i = 0; i < 4; ++i) {
+        if (swiz.DestComponentEnabled(i))
+            MOVAPS(MDisp(REGISTERS, static_cast<int>(dest_offset + i * COMPONENT_STRIDE)), src);
+    }
+}
+
+void BatchJitCompiler::Compile_ComponentwiseOp(Instruction instr, SourceRegister src1, SourceRegister src2,
+                                               void (XEmitter::*op)(X64Reg, const OpArg&)) {
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, src1, i, RESULT[i]);
+        Compile_LoadSrc(instr, 2, src2, i, SRC2);
+        (this->*op)(RESULT[i], R(SRC2));
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_Dot(Instruction instr, SourceRegister src1, SourceRegister src2, unsigned num_components,
+                                   X64Reg dest, bool src1_w_one) {
+    for (unsigned i = 0; i < num_components; ++i) {
+        if (i == 3 && src1_w_one)
+            MOVAPS(RESULT[i], R(ONE));
+        else
+            Compile_LoadSrc(instr, 1, src1, i, RESULT[i]);
+        Compile_LoadSrc(instr, 2, src2, i, SRC2);
+        Compile_SanitizedMul(RESULT[i], SRC2, SCRATCH);
+    }
+
+    // Sum the products in the same order as the scalar JIT does: DP3 adds them up one after
+    // another, DP4 and DPH add the sums of x and z and of y and w like Compile_HorizontalSum
+    if (num_components == 3) {
+        ADDPS(RESULT[0], R(RESULT[1]));
+        ADDPS(RESULT[0], R(RESULT[2]));
+    } else {
+        ADDPS(RESULT[0], R(RESULT[2]));
+        ADDPS(RESULT[1], R(RESULT[3]));
+        ADDPS(RESULT[0], R(RESULT[1]));
+    }
+
+    if (dest != RESULT[0])
+        MOVAPS(dest, R(RESULT[0]));
+}
+
+void BatchJitCompiler::Compile_CallScalarFunction(Instruction instr, void (*function)(float* values)) {
+    const int scratch_disp = static_cast<int>(offsetof(UnitState<false>::BatchRegisters, scratch));
+
+    Compile_LoadSrc(instr, 1, instr.common.src1, 0, SRC1);
+    MOVAPS(MDisp(REGISTERS, scratch_disp), SRC1);
+
+    ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+    LEA(64, ABI_PARAM1, MDisp(REGISTERS, scratch_disp));
+    ABI_CallFunction(reinterpret_cast<const void*>(function));
+    ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
+
+    MOVAPS(SRC1, MDisp(REGISTERS, scratch_disp));
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_SanitizedMul(X64Reg src1, X64Reg src2, X64Reg scratch) {
+    MOVAPS(scratch, R(src1));
+    CMPPS(scratch, R(src2), CMP_ORD);
+
+    MULPS(src1, R(src2));
+
+    MOVAPS(src2, R(src1));
+    CMPPS(src2, R(src2), CMP_UNORD);
+
+    XORPS(scratch, R(src2));
+    ANDPS(src1, R(scratch));
+}
+
+void BatchJitCompiler::Compile_UniformCondition(Instruction instr) {
+    int offset = offsetof(decltype(g_state.vs.uniforms), b) + (instr.flow_control.bool_uniform_id * sizeof(bool));
+    CMP(sizeof(bool) * 8, MDisp(UNIFORMS, offset), Imm8(0));
+}
+
+BitSet32 BatchJitCompiler::PersistentCallerSavedRegs() {
+    return persistent_regs & ABI_ALL_CALLER_SAVED;
+}
+
+void BatchJitCompiler::Compile_ADD(Instruction instr) {
+    Compile_ComponentwiseOp(instr, instr.common.src1, instr.common.src2, &XEmitter::ADDPS);
+}
+
+void BatchJitCompiler::Compile_DP3(Instruction instr) {
+    Compile_Dot(instr, instr.common.src1, instr.common.src2, 3, SRC1);
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_DP4(Instruction instr) {
+    Compile_Dot(instr, instr.common.src1, instr.common.src2, 4, SRC1);
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_DPH(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI;
+    SourceRegister src1 = instr.common.GetSrc1(is_inverted);
+    SourceRegister src2 = instr.common.GetSrc2(is_inverted);
+
+    // The 4th component of src1 is replaced with 1.0
+    Compile_Dot(instr, src1, src2, 4, SRC1, true);
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_EX2(Instruction instr) {
+    Compile_CallScalarFunction(instr, Exp2Batch);
+}
+
+void BatchJitCompiler::Compile_LG2(Instruction instr) {
+    Compile_CallScalarFunction(instr, Log2Batch);
+}
+
+void BatchJitCompiler::Compile_MUL(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, instr.common.src1, i, RESULT[i]);
+        Compile_LoadSrc(instr, 2, instr.common.src2, i, SRC2);
+        Compile_SanitizedMul(RESULT[i], SRC2, SCRATCH);
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_SGE(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI;
+    SourceRegister src1 = instr.common.GetSrc1(is_inverted);
+    SourceRegister src2 = instr.common.GetSrc2(is_inverted);
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, src1, i, SRC1);
+        Compile_LoadSrc(instr, 2, src2, i, RESULT[i]);
+        CMPPS(RESULT[i], R(SRC1), CMP_LE);
+        ANDPS(RESULT[i], R(ONE));
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_SLT(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI;
+    SourceRegister src1 = instr.common.GetSrc1(is_inverted);
+    SourceRegister src2 = instr.common.GetSrc2(is_inverted);
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, src1, i, RESULT[i]);
+        Compile_LoadSrc(instr, 2, src2, i, SRC2);
+        CMPPS(RESULT[i], R(SRC2), CMP_LT);
+        ANDPS(RESULT[i], R(ONE));
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_FLR(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, instr.common.src1, i, RESULT[i]);
+
+        if (Common::GetCPUCaps().sse4_1) {
+            ROUNDFLOORPS(RESULT[i], R(RESULT[i]));
+        } else {
+            CVTPS2DQ(RESULT[i], R(RESULT[i]));
+            CVTDQ2PS(RESULT[i], R(RESULT[i]));
+        }
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_MAX(Instruction instr) {
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    Compile_ComponentwiseOp(instr, instr.common.src1, instr.common.src2, &XEmitter::MAXPS);
+}
+
+void BatchJitCompiler::Compile_MIN(Instruction instr) {
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    Compile_ComponentwiseOp(instr, instr.common.src1, instr.common.src2, &XEmitter::MINPS);
+}
+
+void BatchJitCompiler::Compile_MOV(Instruction instr) {
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (swiz.DestComponentEnabled(i))
+            Compile_LoadSrc(instr, 1, instr.common.src1, i, RESULT[i]);
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_RCP(Instruction instr) {
+    Compile_LoadSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    // TODO(bunnei): RCPPS is a pretty rough approximation, this might cause problems if Pica
+    // performs this operation more accurately. This should be checked on hardware.
+    RCPPS(SRC1, R(SRC1));
+
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_RSQ(Instruction instr) {
+    Compile_LoadSrc(instr, 1, instr.common.src1, 0, SRC1);
+
+    // TODO(bunnei): RSQRTPS is a pretty rough approximation, this might cause problems if Pica
+    // performs this operation more accurately. This should be checked on hardware.
+    RSQRTPS(SRC1, R(SRC1));
+
+    Compile_StoreDestBroadcast(instr, SRC1);
+}
+
+void BatchJitCompiler::Compile_NOP(Instruction instr) {
+}
+
+void BatchJitCompiler::Compile_END(Instruction instr) {
+    ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+    RET();
+}
+
+void BatchJitCompiler::Compile_CALL(Instruction instr) {
+    unsigned offset = instr.flow_control.dest_offset;
+    while (offset < (instr.flow_control.dest_offset + instr.flow_control.num_instructions)) {
+        Compile_NextInstr(&offset);
+    }
+}
+
+void BatchJitCompiler::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    FixupBranch b = J_CC(CC_Z, true);
+    Compile_CALL(instr);
+    SetJumpTarget(b);
+}
+
+void BatchJitCompiler::Compile_MAD(Instruction instr) {
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+    SourceRegister src2 = instr.mad.GetSrc2(is_inverted);
+    SourceRegister src3 = instr.mad.GetSrc3(is_inverted);
+    SwizzlePattern swiz = GetSwizzle(instr);
+
+    for (int i = 0; i < 4; ++i) {
+        if (!swiz.DestComponentEnabled(i))
+            continue;
+
+        Compile_LoadSrc(instr, 1, instr.mad.src1, i, RESULT[i]);
+        Compile_LoadSrc(instr, 2, src2, i, SRC2);
+        Compile_LoadSrc(instr, 3, src3, i, SRC3);
+
+        Compile_SanitizedMul(RESULT[i], SRC2, SCRATCH);
+        ADDPS(RESULT[i], R(SRC3));
+    }
+
+    Compile_StoreDest(instr);
+}
+
+void BatchJitCompiler::Compile_IFU(Instruction instr) {
+    ASSERT_MSG(instr.flow_control.dest_offset > *offset_ptr, "Backwards if-statements not supported");
+
+    // Evaluate the "IF" condition
+    Compile_UniformCondition(instr);
+    FixupBranch b = J_CC(CC_Z, true);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset - 1);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        SetJumpTarget(b);
+        return;
+    }
+
+    FixupBranch b2 = J(true);
+
+    SetJumpTarget(b);
+
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions - 1);
+
+    SetJumpTarget(b2);
+}
+
+void BatchJitCompiler::Compile_LOOP(Instruction instr) {
+    ASSERT_MSG(instr.flow_control.dest_offset > *offset_ptr, "Backwards loops not supported");
+    ASSERT_MSG(!looping, "Nested loops not supported");
+
+    looping = true;
+
+    int offset = offsetof(decltype(g_state.vs.uniforms), i) + (instr.flow_control.int_uniform_id * sizeof(Math::Vec4<u8>));
+    MOV(32, R(LOOPCOUNT), MDisp(UNIFORMS, offset));
+    MOV(32, R(LOOPCOUNT_REG), R(LOOPCOUNT));
+    SHR(32, R(LOOPCOUNT_REG), Imm8(8));
+    AND(32, R(LOOPCOUNT_REG), Imm32(0xff)); // Y-component is the start
+    MOV(32, R(LOOPINC), R(LOOPCOUNT));
+    SHR(32, R(LOOPINC), Imm8(16));
+    MOVZX(32, 8, LOOPINC, R(LOOPINC)); // Z-component is the incrementer
+    MOVZX(32, 8, LOOPCOUNT, R(LOOPCOUNT)); // X-component is iteration count
+    ADD(32, R(LOOPCOUNT), Imm8(1)); // Iteration count is X-component + 1
+
+    auto loop_start = GetCodePtr();
+
+    Compile_Block(instr.flow_control.dest_offset);
+
+    ADD(32, R(LOOPCOUNT_REG), R(LOOPINC)); // Increment LOOPCOUNT_REG by Z-component
+    SUB(32, R(LOOPCOUNT), Imm8(1)); // Increment loop count by 1
+    J_CC(CC_NZ, loop_start); // Loop if not equal
+
+    looping = false;
+}
+
+void BatchJitCompiler::Compile_JMPU(Instruction instr) {
+    ASSERT_MSG(instr.flow_control.dest_offset > *offset_ptr, "Backwards jumps not supported");
+
+    Compile_UniformCondition(instr);
+    FixupBranch b = J_CC(CC_NZ, true);
+
+    Compile_Block(instr.flow_control.dest_offset);
+
+    SetJumpTarget(b);
+}
+
+void BatchJitCompiler::Compile_Divergent(Instruction instr) {
+    // Control flow or addressing may differ between the vertices of a batch
+    batchable = false;
+}
+
+void BatchJitCompiler::Compile_Block(unsigned stop) {
+    // Save current offset pointer
+    unsigned* prev_offset_ptr = offset_ptr;
+    unsigned offset = *prev_offset_ptr;
+
+    while (offset <= stop)
+        Compile_NextInstr(&offset);
+
+    // Restore current offset pointer
+    offset_ptr = prev_offset_ptr;
+    *offset_ptr = offset;
+}
+
+void BatchJitCompiler::Compile_NextInstr(unsigned* offset) {
+    offset_ptr = offset;
+
+    Instruction instr = *(Instruction*)&g_state.vs.program_code[(*offset_ptr)++];
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = batch_instr_table[static_cast<unsigned>(opcode)];
+
+    // Unhandled instructions are skipped, like in the scalar JIT which already reports them
+    if (instr_func)
+        ((*this).*instr_func)(instr);
+}
+
+CompiledBatchShader* BatchJitCompiler::Compile() {
+    const u8* start = GetCodePtr();
+    unsigned offset = g_state.regs.vs.main_offset;
+
+    // The stack pointer is 8 modulo 16 at the entry of a procedure
+    ABI_PushRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
+
+    MOV(PTRBITS, R(REGISTERS), R(ABI_PARAM1));
+    MOV(PTRBITS, R(UNIFORMS), ImmPtr(&g_state.vs.uniforms));
+
+    // Zero loop register
+    XOR(64, R(LOOPCOUNT_REG), R(LOOPCOUNT_REG));
+
+    // Used to set a register to one
+    static const __m128 one = { 1.f, 1.f, 1.f, 1.f };
+    MOV(PTRBITS, R(RAX), ImmPtr(&one));
+    MOVAPS(ONE, MatR(RAX));
+
+    // Used to negate registers
+    static const __m128 neg = { -0.f, -0.f, -0.f, -0.f };
+    MOV(PTRBITS, R(RAX), ImmPtr(&neg));
+    MOVAPS(NEGBIT, MatR(RAX));
+
+    looping = false;
+    batchable = true;
+
+    while (offset < g_state.vs.program_code.size()) {
+        Compile_NextInstr(&offset);
+    }
+
+    if (!batchable) {
+        // Discard the generated code, the program has to be run one vertex at a time
+        SetCodePtr(const_cast<u8*>(start));
+        return nullptr;
+    }
+
+    return (CompiledBatchShader*)start;
+}
+
+BatchJitCompiler::BatchJitCompiler() {
+    AllocCodeSpace(1024 * 1024 * 4);
+}
+
+void BatchJitCompiler::Clear() {
+    ClearCodeSpace();
+}
+
+} // namespace Shader
+
+} // namespace Pica
@@ -0,0 +1,123 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <nihstro/shader_bytecode.h>
+
+#include "common/x64/emitter.h"
+
+#include "video_core/pica.h"
+#include "video_core/shader/shader.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SwizzlePattern;
+
+namespace Pica {
+
+namespace Shader {
+
+using CompiledBatchShader = void(void* batch_registers);
+
+/**
+ * This class implements the batched shader JIT compiler. It recompiles a Pica shader program into
+ * x86_64 code which processes BATCH_SIZE vertices per invocation. Registers are kept as a structure
+ * of arrays (see UnitState::BatchRegisters), so that every SSE lane works on a different vertex and
+ * swizzles and write masks are resolved at compile time.
+ *
+ * Only programs whose control flow is the same for all vertices can be compiled this way, i.e.
+ * programs that don't use conditional flow control or the MOVA address registers. For all other
+ * programs Compile() returns nullptr and the vertices have to be processed one at a time.
+ */
+class BatchJitCompiler : public Gen::XCodeBlock {
+public:
+    BatchJitCompiler();
+
+    CompiledBatchShader* Compile();
+
+    void Clear();
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_EX2(Instruction instr);
+    void Compile_LG2(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IFU(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMPU(Instruction instr);
+    void Compile_MAD(Instruction instr);
+    void Compile_Divergent(Instruction instr);
+
+private:
+    void Compile_Block(unsigned stop);
+    void Compile_NextInstr(unsigned* offset);
+
+    /**
+     * Loads one component of a swizzled source register for all vertices of the batch
+     * @param instr VS instruction, used for determining how to load the source register
+     * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+     * @param src_reg SourceRegister object corresponding to the source register to load
+     * @param component Destination component the source is loaded for
+     * @param dest XMM register to load the component into
+     */
+    void Compile_LoadSrc(Instruction instr, unsigned src_num, SourceRegister src_reg, unsigned component, Gen::X64Reg dest);
+
+    /// Stores the per-component results in RESULT_X..RESULT_W to the enabled destination components
+    void Compile_StoreDest(Instruction instr);
+
+    /// Stores the given result to all enabled destination components
+    void Compile_StoreDestBroadcast(Instruction instr, Gen::X64Reg src);
+
+    /// Compiles a per-component operation `dest = op(src1, src2)` on the enabled components
+    void Compile_ComponentwiseOp(Instruction instr, SourceRegister src1, SourceRegister src2,
+                                 void (Gen::XEmitter::*op)(Gen::X64Reg, const Gen::OpArg&));
+
+    /**
+     * Computes the sum of the sanitized products of the first `num_components` components into `dest`
+     * @param src1_w_one Whether the w component of src1 is replaced with 1.0, as DPH does
+     */
+    void Compile_Dot(Instruction instr, SourceRegister src1, SourceRegister src2, unsigned num_components,
+                     Gen::X64Reg dest, bool src1_w_one = false);
+
+    /// Compiles a call to a function transforming the x component of src1 for all vertices in place
+    void Compile_CallScalarFunction(Instruction instr, void (*function)(float* values));
+
+    /**
+     * Compiles a `MUL src1, src2` operation, properly handling the PICA semantics when multiplying
+     * zero by inf. Clobbers `src2` and `scratch`.
+     */
+    void Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch);
+
+    void Compile_UniformCondition(Instruction instr);
+
+    BitSet32 PersistentCallerSavedRegs();
+
+    /// Pointer to the variable that stores the current Pica code offset. Used to handle nested code blocks.
+    unsigned* offset_ptr = nullptr;
+
+    /// Set to true if currently in a loop, used to check for the existence of nested loops
+    bool looping = false;
+
+    /// Cleared when the program turns out to need per-vertex control flow or addressing
+    bool batchable = true;
+};
+
+} // Shader
+
+} // Pica
@@ -8,6 +8,8 @@
 #include "common/x64/cpu_detect.h"
 #include "common/x64/emitter.h"
 
+#include "core/settings.h"
+
 #include "shader.h"
 #include "shader_jit_x64.h"
 
@@ -117,6 +119,10 @@ static const X64Reg SRC2 = XMM2;
 static const X64Reg SRC3 = XMM3;
 /// Additional scratch register
 static const X64Reg SCRATCH2 = XMM4;
+/// Registers used to cache temporaries between instructions, see JitCompiler::CachedTemporary
+static const X64Reg CACHED_TEMPORARY_REGS[] = {
+    XMM5, XMM6, XMM7, XMM8, XMM9, XMM10, XMM11, XMM12, XMM13
+};
 /// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
 static const X64Reg ONE = XMM14;
 /// Constant vector of [-0.f, -0.f, -0.f, -0.f], used to efficiently negate a vector with XOR
@@ -157,6 +163,11 @@ void JitCompiler::Compile_SwizzleSrc(Instruction instr, unsigned src_num, Source
     int src_offset_disp = (int)src_offset;
     ASSERT_MSG(src_offset == src_offset_disp, "Source register offset too large for int type");
 
+    const bool is_temporary = src_reg.GetRegisterType() == RegisterType::Temporary;
+
+    // Location of the unswizzled source, loaded and swizzled into `dest` below
+    OpArg src;
+
     unsigned operand_desc_id;
     if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
         instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
@@ -165,8 +176,11 @@ void JitCompiler::Compile_SwizzleSrc(Instruction instr, unsigned src_num, Source
 
         operand_desc_id = instr.mad.operand_desc_id;
 
-        // Load the source
-        MOVAPS(dest, MDisp(src_ptr, src_offset_disp));
+        if (is_temporary) {
+            src = R(Compile_GetCachedTemporary(src_reg.GetIndex(), true));
+        } else {
+            src = MDisp(src_ptr, src_offset_disp);
+        }
     } else {
         operand_desc_id = instr.common.operand_desc_id;
 
@@ -174,23 +188,28 @@ void JitCompiler::Compile_SwizzleSrc(Instruction instr, unsigned src_num, Source
         unsigned offset_src = is_inverted ? 2 : 1;
 
         if (src_num == offset_src && instr.common.address_register_index != 0) {
+            // The offset register may select any register in the file, so it has to be up to date
+            if (src_ptr == REGISTERS)
+                Compile_StoreCachedTemporaries();
+
             switch (instr.common.address_register_index) {
             case 1: // address offset 1
-                MOVAPS(dest, MComplex(src_ptr, ADDROFFS_REG_0, SCALE_1, src_offset_disp));
+                src = MComplex(src_ptr, ADDROFFS_REG_0, SCALE_1, src_offset_disp);
                 break;
             case 2: // address offset 2
-                MOVAPS(dest, MComplex(src_ptr, ADDROFFS_REG_1, SCALE_1, src_offset_disp));
+                src = MComplex(src_ptr, ADDROFFS_REG_1, SCALE_1, src_offset_disp);
                 break;
             case 3: // address offset 3
-                MOVAPS(dest, MComplex(src_ptr, LOOPCOUNT_REG, SCALE_1, src_offset_disp));
+                src = MComplex(src_ptr, LOOPCOUNT_REG, SCALE_1, src_offset_disp);
                 break;
             default:
                 UNREACHABLE();
                 break;
             }
+        } else if (is_temporary) {
+            src = R(Compile_GetCachedTemporary(src_reg.GetIndex(), true));
         } else {
-            // Load the source
-            MOVAPS(dest, MDisp(src_ptr, src_offset_disp));
+            src = MDisp(src_ptr, src_offset_disp);
         }
     }
 
@@ -202,8 +221,15 @@ void JitCompiler::Compile_SwizzleSrc(Instruction instr, unsigned src_num, Source
         // Selector component order needs to be reversed for the SHUFPS instruction
         sel = ((sel & 0xc0) >> 6) | ((sel & 3) << 6) | ((sel & 0xc) << 2) | ((sel & 0x30) >> 2);
 
-        // Shuffle inputs for swizzle
-        SHUFPS(dest, R(dest), sel);
+        if (Common::GetCPUCaps().avx) {
+            // Load and shuffle in a single instruction
+            VPERMILPS(dest, src, sel);
+        } else {
+            MOVAPS(dest, src);
+            SHUFPS(dest, R(dest), sel);
+        }
+    } else {
+        MOVAPS(dest, src);
     }
 
     // If the source register should be negated, flip the negative bit using XOR
@@ -213,7 +239,7 @@ void JitCompiler::Compile_SwizzleSrc(Instruction instr, unsigned src_num, Source
     }
 }
 
-void JitCompiler::Compile_DestEnable(Instruction instr,X64Reg src) {
+void JitCompiler::Compile_DestEnable(Instruction instr, X64Reg src, bool result_finite) {
     DestRegister dest;
     unsigned operand_desc_id;
     if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
@@ -230,17 +256,52 @@ void JitCompiler::Compile_DestEnable(Instruction instr,X64Reg src) {
     int dest_offset_disp = (int)UnitState<false>::OutputOffset(dest);
     ASSERT_MSG(dest_offset_disp == UnitState<false>::OutputOffset(dest), "Destinaton offset too large for int type");
 
+    // Temporaries are only written to their cache register, they're stored to memory when flushed
+    const bool is_temporary = dest.GetRegisterType() == RegisterType::Temporary;
+    X64Reg cached = INVALID_REG;
+    if (is_temporary) {
+        const unsigned index = dest.GetIndex();
+        const bool full_write = (swiz.dest_mask == NO_DEST_REG_MASK);
+        cached = Compile_GetCachedTemporary(index, !full_write);
+        finite_temporaries[index] = result_finite && (full_write || finite_temporaries[index]);
+
+        for (auto& entry : cached_temporaries) {
+            if (entry.index == static_cast<int>(index))
+                entry.dirty = true;
+        }
+    }
+
     // If all components are enabled, write the result to the destination register
     if (swiz.dest_mask == NO_DEST_REG_MASK) {
-        // Store dest back to memory
-        MOVAPS(MDisp(REGISTERS, dest_offset_disp), src);
+        if (is_temporary) {
+            MOVAPS(cached, R(src));
+        } else {
+            // Store dest back to memory
+            MOVAPS(MDisp(REGISTERS, dest_offset_disp), src);
+        }
 
     } else {
         // Not all components are enabled, so mask the result when storing to the destination register...
-        MOVAPS(SCRATCH, MDisp(REGISTERS, dest_offset_disp));
+        u8 mask = ((swiz.dest_mask & 1) << 3) | ((swiz.dest_mask & 8) >> 3) | ((swiz.dest_mask & 2) << 1) | ((swiz.dest_mask & 4) >> 1);
+
+        if (Common::GetCPUCaps().avx) {
+            // The three-operand blend reads the old value directly, without copying it first
+            if (is_temporary) {
+                VBLENDPS(cached, cached, R(src), mask);
+            } else {
+                VBLENDPS(SCRATCH, src, MDisp(REGISTERS, dest_offset_disp), ~mask & 0xf);
+                MOVAPS(MDisp(REGISTERS, dest_offset_disp), SCRATCH);
+            }
+            return;
+        }
+
+        if (is_temporary) {
+            MOVAPS(SCRATCH, R(cached));
+        } else {
+            MOVAPS(SCRATCH, MDisp(REGISTERS, dest_offset_disp));
+        }
 
         if (Common::GetCPUCaps().sse4_1) {
-            u8 mask = ((swiz.dest_mask & 1) << 3) | ((swiz.dest_mask & 8) >> 3) | ((swiz.dest_mask & 2) << 1) | ((swiz.dest_mask & 4) >> 1);
             BLENDPS(SCRATCH, R(src), mask);
         } else {
             MOVAPS(SCRATCH2, R(src));
@@ -255,24 +316,124 @@ void JitCompiler::Compile_DestEnable(Instruction instr,X64Reg src) {
             SHUFPS(SCRATCH, R(SCRATCH2), sel);
         }
 
-        // Store dest back to memory
-        MOVAPS(MDisp(REGISTERS, dest_offset_disp), SCRATCH);
+        if (is_temporary) {
+            MOVAPS(cached, R(SCRATCH));
+        } else {
+            // Store dest back to memory
+            MOVAPS(MDisp(REGISTERS, dest_offset_disp), SCRATCH);
+        }
+    }
+}
+
+/// Returns the location of the given temporary register in the register file
+static OpArg TemporaryAddress(unsigned index) {
+    return MDisp(REGISTERS, static_cast<int>(offsetof(UnitState<false>::Registers, temporary) +
+                                             index * sizeof(Math::Vec4<float24>)));
+}
+
+bool JitCompiler::IsKnownFinite(Instruction instr, SourceRegister src_reg) const {
+    if (src_reg.GetRegisterType() != RegisterType::Temporary)
+        return false;
+
+    // Relative addressing may select a different register than the one being tracked
+    const bool is_mad = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+                        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+    if (!is_mad && instr.common.address_register_index != 0)
+        return false;
+
+    return finite_temporaries[src_reg.GetIndex()];
+}
+
+X64Reg JitCompiler::Compile_GetCachedTemporary(unsigned index, bool load) {
+    CachedTemporary* victim = &cached_temporaries[0];
+    for (auto& entry : cached_temporaries) {
+        if (entry.index == static_cast<int>(index)) {
+            entry.last_use = ++temporary_use_counter;
+            return CACHED_TEMPORARY_REGS[&entry - cached_temporaries.data()];
+        }
+
+        // Prefer unused registers, then the least recently used one
+        if (victim->index != -1 && (entry.index == -1 || entry.last_use < victim->last_use))
+            victim = &entry;
+    }
+
+    X64Reg reg = CACHED_TEMPORARY_REGS[victim - cached_temporaries.data()];
+    if (victim->index != -1 && victim->dirty) {
+        MOVAPS(TemporaryAddress(victim->index), reg);
+    }
+
+    if (load) {
+        MOVAPS(reg, TemporaryAddress(index));
+    }
+
+    victim->index = index;
+    victim->dirty = false;
+    victim->last_use = ++temporary_use_counter;
+    return reg;
+}
+
+void JitCompiler::Compile_StoreCachedTemporaries() {
+    for (auto& entry : cached_temporaries) {
+        if (entry.index == -1 || !entry.dirty)
+            continue;
+
+        X64Reg reg = CACHED_TEMPORARY_REGS[&entry - cached_temporaries.data()];
+        MOVAPS(TemporaryAddress(entry.index), reg);
+        entry.dirty = false;
+    }
+}
+
+void JitCompiler::Compile_FlushCachedTemporaries() {
+    Compile_StoreCachedTemporaries();
+    InvalidateCachedTemporaries();
+}
+
+void JitCompiler::InvalidateCachedTemporaries() {
+    for (auto& entry : cached_temporaries) {
+        entry.index = -1;
+        entry.dirty = false;
     }
+
+    // Different paths may have written different values
+    finite_temporaries.reset();
 }
 
 void JitCompiler::Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch) {
-    MOVAPS(scratch, R(src1));
-    CMPPS(scratch, R(src2), CMP_ORD);
+    if (Common::GetCPUCaps().avx) {
+        VCMPPS(scratch, src1, R(src2), CMP_ORD);
+        MULPS(src1, R(src2));
+        VCMPPS(src2, src1, R(src1), CMP_UNORD);
+    } else {
+        MOVAPS(scratch, R(src1));
+        CMPPS(scratch, R(src2), CMP_ORD);
 
-    MULPS(src1, R(src2));
+        MULPS(src1, R(src2));
 
-    MOVAPS(src2, R(src1));
-    CMPPS(src2, R(src2), CMP_UNORD);
+        MOVAPS(src2, R(src1));
+        CMPPS(src2, R(src2), CMP_UNORD);
+    }
 
     XORPS(scratch, R(src2));
     ANDPS(src1, R(scratch));
 }
 
+void JitCompiler::Compile_HorizontalSum(Gen::X64Reg src, Gen::X64Reg scratch) {
+    if (Common::GetCPUCaps().avx) {
+        VPERMILPS(scratch, R(src), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
+        ADDPS(src, R(scratch));
+        VPERMILPS(scratch, R(src), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
+        ADDPS(src, R(scratch));
+    } else {
+        MOVAPS(scratch, R(src));
+        SHUFPS(src, R(src), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
+        ADDPS(src, R(scratch));
+
+        MOVAPS(scratch, R(src));
+        SHUFPS(src, R(src), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
+        ADDPS(src, R(scratch));
+    }
+}
+
 void JitCompiler::Compile_EvaluateCondition(Instruction instr) {
     // Note: NXOR is used below to check for equality
     switch (instr.flow_control.op) {
@@ -324,13 +485,22 @@ void JitCompiler::Compile_DP3(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
 
-    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    if (IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2)) {
+        MULPS(SRC1, R(SRC2));
+    } else {
+        Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    }
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC2, R(SRC2), _MM_SHUFFLE(1, 1, 1, 1));
+    if (Common::GetCPUCaps().avx) {
+        VPERMILPS(SRC2, R(SRC1), _MM_SHUFFLE(1, 1, 1, 1));
+        VPERMILPS(SRC3, R(SRC1), _MM_SHUFFLE(2, 2, 2, 2));
+    } else {
+        MOVAPS(SRC2, R(SRC1));
+        SHUFPS(SRC2, R(SRC2), _MM_SHUFFLE(1, 1, 1, 1));
 
-    MOVAPS(SRC3, R(SRC1));
-    SHUFPS(SRC3, R(SRC3), _MM_SHUFFLE(2, 2, 2, 2));
+        MOVAPS(SRC3, R(SRC1));
+        SHUFPS(SRC3, R(SRC3), _MM_SHUFFLE(2, 2, 2, 2));
+    }
 
     SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 0, 0, 0));
     ADDPS(SRC1, R(SRC2));
@@ -343,26 +513,27 @@ void JitCompiler::Compile_DP4(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
 
-    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
-
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
-    ADDPS(SRC1, R(SRC2));
+    if (IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2)) {
+        MULPS(SRC1, R(SRC2));
+    } else {
+        Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    }
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
-    ADDPS(SRC1, R(SRC2));
+    Compile_HorizontalSum(SRC1, SRC2);
 
     Compile_DestEnable(instr, SRC1);
 }
 
 void JitCompiler::Compile_DPH(Instruction instr) {
+    bool finite;
     if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
         Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
         Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+        finite = IsKnownFinite(instr, instr.common.src1i) && IsKnownFinite(instr, instr.common.src2i);
     } else {
         Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
         Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+        finite = IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2);
     }
 
     if (Common::GetCPUCaps().sse4_1) {
@@ -375,15 +546,13 @@ void JitCompiler::Compile_DPH(Instruction instr) {
         UNPCKLPD(SRC1, R(SCRATCH)); // XYZW, Z1__ -> XYZ1
     }
 
-    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
-
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(2, 3, 0, 1)); // XYZW -> ZWXY
-    ADDPS(SRC1, R(SRC2));
+    if (finite) {
+        MULPS(SRC1, R(SRC2));
+    } else {
+        Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    }
 
-    MOVAPS(SRC2, R(SRC1));
-    SHUFPS(SRC1, R(SRC1), _MM_SHUFFLE(0, 1, 2, 3)); // XYZW -> WZYX
-    ADDPS(SRC1, R(SRC2));
+    Compile_HorizontalSum(SRC1, SRC2);
 
     Compile_DestEnable(instr, SRC1);
 }
@@ -392,6 +561,9 @@ void JitCompiler::Compile_EX2(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
     MOVSS(XMM0, R(SRC1));
 
+    // The call clobbers all cache registers
+    Compile_FlushCachedTemporaries();
+
     ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
     ABI_CallFunction(reinterpret_cast<const void*>(exp2f));
     ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
@@ -405,6 +577,9 @@ void JitCompiler::Compile_LG2(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
     MOVSS(XMM0, R(SRC1));
 
+    // The call clobbers all cache registers
+    Compile_FlushCachedTemporaries();
+
     ABI_PushRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
     ABI_CallFunction(reinterpret_cast<const void*>(log2f));
     ABI_PopRegistersAndAdjustStack(PersistentCallerSavedRegs(), 0);
@@ -417,7 +592,13 @@ void JitCompiler::Compile_LG2(Instruction instr) {
 void JitCompiler::Compile_MUL(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
-    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    // Without infinities, the product can't be NaN unless an input already is
+    if (IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2)) {
+        MULPS(SRC1, R(SRC2));
+    } else {
+        Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    }
     Compile_DestEnable(instr, SRC1);
 }
 
@@ -433,7 +614,7 @@ void JitCompiler::Compile_SGE(Instruction instr) {
     CMPPS(SRC2, R(SRC1), CMP_LE);
     ANDPS(SRC2, R(ONE));
 
-    Compile_DestEnable(instr, SRC2);
+    Compile_DestEnable(instr, SRC2, true);
 }
 
 void JitCompiler::Compile_SLT(Instruction instr) {
@@ -448,7 +629,7 @@ void JitCompiler::Compile_SLT(Instruction instr) {
     CMPPS(SRC1, R(SRC2), CMP_LT);
     ANDPS(SRC1, R(ONE));
 
-    Compile_DestEnable(instr, SRC1);
+    Compile_DestEnable(instr, SRC1, true);
 }
 
 void JitCompiler::Compile_FLR(Instruction instr) {
@@ -469,7 +650,7 @@ void JitCompiler::Compile_MAX(Instruction instr) {
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
     // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
     MAXPS(SRC1, R(SRC2));
-    Compile_DestEnable(instr, SRC1);
+    Compile_DestEnable(instr, SRC1, IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2));
 }
 
 void JitCompiler::Compile_MIN(Instruction instr) {
@@ -477,7 +658,7 @@ void JitCompiler::Compile_MIN(Instruction instr) {
     Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
     // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
     MINPS(SRC1, R(SRC2));
-    Compile_DestEnable(instr, SRC1);
+    Compile_DestEnable(instr, SRC1, IsKnownFinite(instr, instr.common.src1) && IsKnownFinite(instr, instr.common.src2));
 }
 
 void JitCompiler::Compile_MOVA(Instruction instr) {
@@ -527,7 +708,7 @@ void JitCompiler::Compile_MOVA(Instruction instr) {
 
 void JitCompiler::Compile_MOV(Instruction instr) {
     Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
-    Compile_DestEnable(instr, SRC1);
+    Compile_DestEnable(instr, SRC1, IsKnownFinite(instr, instr.common.src1));
 }
 
 void JitCompiler::Compile_RCP(Instruction instr) {
@@ -556,6 +737,9 @@ void JitCompiler::Compile_NOP(Instruction instr) {
 }
 
 void JitCompiler::Compile_END(Instruction instr) {
+    // Temporaries aren't observable after the program ends, so they don't need to be written back
+    InvalidateCachedTemporaries();
+
     ABI_PopRegistersAndAdjustStack(ABI_ALL_CALLEE_SAVED, 8);
     RET();
 }
@@ -568,16 +752,20 @@ void JitCompiler::Compile_CALL(Instruction instr) {
 }
 
 void JitCompiler::Compile_CALLC(Instruction instr) {
+    Compile_FlushCachedTemporaries();
     Compile_EvaluateCondition(instr);
     FixupBranch b = J_CC(CC_Z, true);
     Compile_CALL(instr);
+    Compile_FlushCachedTemporaries();
     SetJumpTarget(b);
 }
 
 void JitCompiler::Compile_CALLU(Instruction instr) {
+    Compile_FlushCachedTemporaries();
     Compile_UniformCondition(instr);
     FixupBranch b = J_CC(CC_Z, true);
     Compile_CALL(instr);
+    Compile_FlushCachedTemporaries();
     SetJumpTarget(b);
 }
 
@@ -635,8 +823,31 @@ void JitCompiler::Compile_MAD(Instruction instr) {
         Compile_SwizzleSrc(instr, 3, instr.mad.src3, SRC3);
     }
 
-    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
-    ADDPS(SRC1, R(SRC3));
+    const bool is_inverted = instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+    const bool finite = IsKnownFinite(instr, instr.mad.src1) && IsKnownFinite(instr, instr.mad.GetSrc2(is_inverted));
+
+    if (use_fma) {
+        if (!finite) {
+            VCMPPS(SCRATCH, SRC1, R(SRC2), CMP_ORD);
+        }
+
+        VFMADD213PS(SRC1, SRC2, R(SRC3)); // SRC1 = SRC1 * SRC2 + SRC3
+
+        if (!finite) {
+            // A NaN result from non-NaN factors comes from 0 * inf, where PICA yields 0 * x = 0,
+            // so the result is SRC3. (This also catches inf - inf, which is why FMA is opt-in.)
+            VCMPPS(SRC2, SRC1, R(SRC1), CMP_UNORD);
+            ANDPS(SCRATCH, R(SRC2));
+            VBLENDVPS(SRC1, SRC1, R(SRC3), SCRATCH);
+        }
+    } else {
+        if (finite) {
+            MULPS(SRC1, R(SRC2));
+        } else {
+            Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+        }
+        ADDPS(SRC1, R(SRC3));
+    }
 
     Compile_DestEnable(instr, SRC1);
 }
@@ -644,6 +855,8 @@ void JitCompiler::Compile_MAD(Instruction instr) {
 void JitCompiler::Compile_IF(Instruction instr) {
     ASSERT_MSG(instr.flow_control.dest_offset > *offset_ptr, "Backwards if-statements not supported");
 
+    Compile_FlushCachedTemporaries();
+
     // Evaluate the "IF" condition
     if (instr.opcode.Value() == OpCode::Id::IFU) {
         Compile_UniformCondition(instr);
@@ -654,6 +867,7 @@ void JitCompiler::Compile_IF(Instruction instr) {
 
     // Compile the code that corresponds to the condition evaluating as true
     Compile_Block(instr.flow_control.dest_offset - 1);
+    Compile_FlushCachedTemporaries();
 
     // If there isn't an "ELSE" condition, we are done here
     if (instr.flow_control.num_instructions == 0) {
@@ -668,6 +882,7 @@ void JitCompiler::Compile_IF(Instruction instr) {
     // This code corresponds to the "ELSE" condition
     // Comple the code that corresponds to the condition evaluating as false
     Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions - 1);
+    Compile_FlushCachedTemporaries();
 
     SetJumpTarget(b2);
 }
@@ -689,9 +904,11 @@ void JitCompiler::Compile_LOOP(Instruction instr) {
     MOVZX(32, 8, LOOPCOUNT, R(LOOPCOUNT)); // X-component is iteration count
     ADD(32, R(LOOPCOUNT), Imm8(1)); // Iteration count is X-component + 1
 
+    Compile_FlushCachedTemporaries();
     auto loop_start = GetCodePtr();
 
     Compile_Block(instr.flow_control.dest_offset);
+    Compile_FlushCachedTemporaries();
 
     ADD(32, R(LOOPCOUNT_REG), R(LOOPINC)); // Increment LOOPCOUNT_REG by Z-component
     SUB(32, R(LOOPCOUNT), Imm8(1)); // Increment loop count by 1
@@ -703,6 +920,8 @@ void JitCompiler::Compile_LOOP(Instruction instr) {
 void JitCompiler::Compile_JMP(Instruction instr) {
     ASSERT_MSG(instr.flow_control.dest_offset > *offset_ptr, "Backwards jumps not supported");
 
+    Compile_FlushCachedTemporaries();
+
     if (instr.opcode.Value() == OpCode::Id::JMPC)
         Compile_EvaluateCondition(instr);
     else if (instr.opcode.Value() == OpCode::Id::JMPU)
@@ -713,6 +932,7 @@ void JitCompiler::Compile_JMP(Instruction instr) {
     FixupBranch b = J_CC(CC_NZ, true);
 
     Compile_Block(instr.flow_control.dest_offset);
+    Compile_FlushCachedTemporaries();
 
     SetJumpTarget(b);
 }
@@ -773,6 +993,10 @@ CompiledShader* JitCompiler::Compile() {
     MOVAPS(NEGBIT, MatR(RAX));
 
     looping = false;
+    InvalidateCachedTemporaries();
+
+    const auto& caps = Common::GetCPUCaps();
+    use_fma = Settings::values.use_shader_jit_fma && caps.avx && caps.fma;
 
     while (offset < g_state.vs.program_code.size()) {
         Compile_NextInstr(&offset);
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
+
 #include <nihstro/shader_bytecode.h>
 
 #include "common/x64/emitter.h"
@@ -65,7 +68,37 @@ private:
     void Compile_NextInstr(unsigned* offset);
 
     void Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg, Gen::X64Reg dest);
-    void Compile_DestEnable(Instruction instr, Gen::X64Reg dest);
+
+    /**
+     * Writes a result to the enabled components of the destination register
+     * @param instr VS instruction, used for determining the destination register and write mask
+     * @param src XMM register holding the result
+     * @param result_finite Whether all components of the result are known to be finite
+     */
+    void Compile_DestEnable(Instruction instr, Gen::X64Reg src, bool result_finite = false);
+
+    /// Returns true if all components of the given source register are known to be finite
+    bool IsKnownFinite(Instruction instr, SourceRegister src_reg) const;
+
+    /**
+     * Returns the XMM register caching the given temporary register, allocating one if needed.
+     * @param index Index of the temporary register
+     * @param load Whether to load the current value of the temporary into a newly allocated register
+     */
+    Gen::X64Reg Compile_GetCachedTemporary(unsigned index, bool load);
+
+    /// Writes modified cached temporaries back to the register file, keeping them cached
+    void Compile_StoreCachedTemporaries();
+
+    /**
+     * Writes modified cached temporaries back and forgets all cached state. Must be used before
+     * emitting branches and at the end of conditionally executed blocks, so that the cache state
+     * is the same on all paths merging afterwards.
+     */
+    void Compile_FlushCachedTemporaries();
+
+    /// Forgets all cached state without writing anything back
+    void InvalidateCachedTemporaries();
 
     /**
      * Compiles a `MUL src1, src2` operation, properly handling the PICA semantics when multiplying
@@ -73,6 +106,9 @@ private:
      */
     void Compile_SanitizedMul(Gen::X64Reg src1, Gen::X64Reg src2, Gen::X64Reg scratch);
 
+    /// Sums up the components of `src`, broadcasting the result to all of them. Clobbers `scratch`.
+    void Compile_HorizontalSum(Gen::X64Reg src, Gen::X64Reg scratch);
+
     void Compile_EvaluateCondition(Instruction instr);
     void Compile_UniformCondition(Instruction instr);
 
@@ -83,6 +119,29 @@ private:
 
     /// Set to true if currently in a loop, used to check for the existence of nested loops
     bool looping = false;
+
+    /// Whether MAD is compiled to fused multiply-adds, which isn't bit-exact with the interpreter
+    bool use_fma = false;
+
+    /**
+     * Temporary registers are kept in XMM registers within straight-line code, so that values
+     * passed between instructions don't round-trip through memory, and temporaries overwritten
+     * before the next flush are never stored at all.
+     */
+    struct CachedTemporary {
+        /// Index of the cached temporary, or -1 if the XMM register is unused
+        int index;
+        /// Whether the XMM register holds a value that hasn't been written back yet
+        bool dirty;
+        /// Value of temporary_use_counter when the register was last used, for LRU replacement
+        unsigned last_use;
+    };
+    static const unsigned NUM_CACHED_TEMPORARIES = 9;
+    std::array<CachedTemporary, NUM_CACHED_TEMPORARIES> cached_temporaries;
+    unsigned temporary_use_counter = 0;
+
+    /// Temporaries which are known to hold only finite values, e.g. results of SGE and SLT
+    std::bitset<16> finite_temporaries;
 };
 
 } // Shader
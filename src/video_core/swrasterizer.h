@@ -16,11 +16,11 @@ class SWRasterizer : public RasterizerInterface {
     void AddTriangle(const Pica::Shader::OutputVertex& v0,
             const Pica::Shader::OutputVertex& v1,
             const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void FlushFramebuffer() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void FlushFramebuffer() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
 };
 
 }
@@ -0,0 +1,560 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+
+#include "common/assert.h"
+#include "common/common_funcs.h"
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/tev_jit_x64.h"
+
+namespace Pica {
+
+using namespace Gen;
+
+using Source = Regs::TevStageConfig::Source;
+using ColorModifier = Regs::TevStageConfig::ColorModifier;
+using AlphaModifier = Regs::TevStageConfig::AlphaModifier;
+using Operation = Regs::TevStageConfig::Operation;
+
+static_assert(sizeof(Math::Vec4<u8>) == 4, "The TEV JIT loads colors as packed 32-bit values");
+
+/// Arguments of the compiled combiner
+static const X64Reg INPUTS = ABI_PARAM1;
+static const X64Reg OUTPUT = ABI_PARAM2;
+/// Address of the constant table below
+static const X64Reg CONSTANTS = R10;
+static const X64Reg SCRATCH = R11;
+
+// Colors are held in SSE registers with one component per 32-bit lane, so that the color combiner
+// works on lanes 0-2 and the alpha combiner on lane 3.
+
+/// Output of the last stage, i.e. the "Previous" source
+static const X64Reg COMBINER_OUTPUT = XMM0;
+/// Combiner buffer as seen by the current stage and as seen by the next stage
+static const X64Reg BUFFER = XMM1;
+static const X64Reg NEXT_BUFFER = XMM2;
+/// Modified inputs of the current stage
+static const X64Reg STAGE_INPUTS[3] = { XMM3, XMM4, XMM5 };
+static const X64Reg TEMP = XMM6;
+/// Result of the alpha combiner when it uses a different operation than the color combiner
+static const X64Reg ALPHA_RESULT = XMM7;
+
+struct TevConstants {
+    u32 invert_masks[4][4]; ///< XOR masks inverting the color and/or alpha lanes
+    u32 all_255[4];
+    u32 all_128[4];
+    u32 all_1[4];
+};
+
+static const TevConstants MEMORY_ALIGNED16(constants) = {
+    {
+        {   0,   0,   0,   0 },
+        { 255, 255, 255,   0 },
+        {   0,   0,   0, 255 },
+        { 255, 255, 255, 255 },
+    },
+    { 255, 255, 255, 255 },
+    { 128, 128, 128, 128 },
+    {   1,   1,   1,   1 },
+};
+
+static OpArg Constant(size_t offset) {
+    return MDisp(CONSTANTS, static_cast<int>(offset));
+}
+
+TevConfig TevConfig::FromRegs(const Regs& regs) {
+    TevConfig config = {};
+
+    const auto tev_stages = regs.GetTevStages();
+    for (unsigned i = 0; i < tev_stages.size(); ++i) {
+        config.stages[i].sources_raw = tev_stages[i].sources_raw;
+        config.stages[i].modifiers_raw = tev_stages[i].modifiers_raw;
+        config.stages[i].ops_raw = tev_stages[i].ops_raw;
+        config.stages[i].const_color = tev_stages[i].const_color;
+        config.stages[i].scales_raw = tev_stages[i].scales_raw;
+    }
+
+    config.update_mask_rgb = regs.tev_combiner_buffer_input.update_mask_rgb;
+    config.update_mask_a = regs.tev_combiner_buffer_input.update_mask_a;
+    config.buffer_color = regs.tev_combiner_buffer_color.raw;
+    config.alpha_test_enable = regs.output_merger.alpha_test.enable;
+    config.alpha_test_func = static_cast<u32>(regs.output_merger.alpha_test.func.Value());
+    config.alpha_test_ref = regs.output_merger.alpha_test.ref;
+    return config;
+}
+
+/// Same as the check in the OpenGL shader generator: the stage just forwards the previous output
+static bool IsPassThroughTevStage(const Regs::TevStageConfig& stage) {
+    return (stage.color_op             == Operation::Replace &&
+            stage.alpha_op             == Operation::Replace &&
+            stage.color_source1        == Source::Previous &&
+            stage.alpha_source1        == Source::Previous &&
+            stage.color_modifier1      == ColorModifier::SourceColor &&
+            stage.alpha_modifier1      == AlphaModifier::SourceAlpha &&
+            stage.GetColorMultiplier() == 1 &&
+            stage.GetAlphaMultiplier() == 1);
+}
+
+/// Number of inputs read by the given combiner operation
+static int GetNumInputs(Operation op) {
+    switch (op) {
+    case Operation::Replace:
+        return 1;
+
+    case Operation::Lerp:
+    case Operation::MultiplyThenAdd:
+    case Operation::AddThenMultiply:
+        return 3;
+
+    default:
+        return 2;
+    }
+}
+
+static bool IsSupportedSource(Source source) {
+    switch (source) {
+    case Source::PrimaryColor:
+    case Source::PrimaryFragmentColor:
+    case Source::SecondaryFragmentColor:
+    case Source::Texture0:
+    case Source::Texture1:
+    case Source::Texture2:
+    case Source::PreviousBuffer:
+    case Source::Constant:
+    case Source::Previous:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static bool IsSupportedOperation(Operation op, bool alpha) {
+    switch (op) {
+    case Operation::Replace:
+    case Operation::Modulate:
+    case Operation::Add:
+    case Operation::AddSigned:
+    case Operation::Lerp:
+    case Operation::Subtract:
+    case Operation::MultiplyThenAdd:
+    case Operation::AddThenMultiply:
+        return true;
+
+    case Operation::Dot3_RGB:
+        return !alpha;
+
+    default:
+        return false;
+    }
+}
+
+/// PSHUFD selector that replicates the components picked by the color modifier into lanes 0-2
+static bool GetColorModifierShuffle(ColorModifier modifier, u8* shuffle) {
+    switch (modifier) {
+    case ColorModifier::SourceColor:
+    case ColorModifier::OneMinusSourceColor:
+        *shuffle = 0x24; // rgb
+        return true;
+
+    case ColorModifier::SourceAlpha:
+    case ColorModifier::OneMinusSourceAlpha:
+        *shuffle = 0x3F; // aaa
+        return true;
+
+    case ColorModifier::SourceRed:
+    case ColorModifier::OneMinusSourceRed:
+        *shuffle = 0x00; // rrr
+        return true;
+
+    case ColorModifier::SourceGreen:
+    case ColorModifier::OneMinusSourceGreen:
+        *shuffle = 0x15; // ggg
+        return true;
+
+    case ColorModifier::SourceBlue:
+    case ColorModifier::OneMinusSourceBlue:
+        *shuffle = 0x2A; // bbb
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/// Component picked by the alpha modifier (0 = red, ..., 3 = alpha)
+static u8 GetAlphaModifierComponent(AlphaModifier modifier) {
+    return ((static_cast<u32>(modifier) >> 1) + 3) & 3;
+}
+
+static bool IsSupportedStage(const Regs::TevStageConfig& stage) {
+    if (!IsSupportedOperation(stage.color_op, false) || !IsSupportedOperation(stage.alpha_op, true))
+        return false;
+
+    const Source color_sources[3] = { stage.color_source1, stage.color_source2, stage.color_source3 };
+    const Source alpha_sources[3] = { stage.alpha_source1, stage.alpha_source2, stage.alpha_source3 };
+    const ColorModifier color_modifiers[3] = { stage.color_modifier1, stage.color_modifier2, stage.color_modifier3 };
+
+    int num_inputs = std::max(GetNumInputs(stage.color_op), GetNumInputs(stage.alpha_op));
+    for (int i = 0; i < num_inputs; ++i) {
+        u8 shuffle;
+        if (!IsSupportedSource(color_sources[i]) || !IsSupportedSource(alpha_sources[i]) ||
+            !GetColorModifierShuffle(color_modifiers[i], &shuffle))
+            return false;
+    }
+
+    return true;
+}
+
+/// Whether a stage reads the combiner buffer
+static bool ReadsCombinerBuffer(const Regs::TevStageConfig& stage) {
+    if (IsPassThroughTevStage(stage))
+        return false;
+
+    const Source color_sources[3] = { stage.color_source1, stage.color_source2, stage.color_source3 };
+    const Source alpha_sources[3] = { stage.alpha_source1, stage.alpha_source2, stage.alpha_source3 };
+
+    int num_inputs = std::max(GetNumInputs(stage.color_op), GetNumInputs(stage.alpha_op));
+    for (int i = 0; i < num_inputs; ++i) {
+        if (color_sources[i] == Source::PreviousBuffer || alpha_sources[i] == Source::PreviousBuffer)
+            return true;
+    }
+
+    return false;
+}
+
+void TevJit::Compile_LoadSource(X64Reg dest, Source source, u32 const_color) {
+    switch (source) {
+    case Source::PrimaryColor:
+    // HACK: Until we implement fragment lighting, use primary_color
+    case Source::PrimaryFragmentColor:
+        PMOVZXBD(dest, MDisp(INPUTS, offsetof(TevInputs, primary_color)));
+        break;
+
+    // HACK: Until we implement fragment lighting, use zero
+    case Source::SecondaryFragmentColor:
+        PXOR(dest, R(dest));
+        break;
+
+    case Source::Texture0:
+    case Source::Texture1:
+    case Source::Texture2:
+    {
+        int index = static_cast<int>(source) - static_cast<int>(Source::Texture0);
+        PMOVZXBD(dest, MDisp(INPUTS, static_cast<int>(offsetof(TevInputs, texture_color) + index * sizeof(Math::Vec4<u8>))));
+        break;
+    }
+
+    case Source::PreviousBuffer:
+        MOVDQA(dest, R(BUFFER));
+        break;
+
+    case Source::Constant:
+        MOV(32, R(SCRATCH), Imm32(const_color));
+        MOVD_xmm(dest, R(SCRATCH));
+        PMOVZXBD(dest, R(dest));
+        break;
+
+    case Source::Previous:
+        MOVDQA(dest, R(COMBINER_OUTPUT));
+        break;
+
+    default:
+        UNREACHABLE();
+    }
+}
+
+void TevJit::Compile_LoadInput(X64Reg dest, const Regs::TevStageConfig& stage, int index) {
+    const Source color_sources[3] = { stage.color_source1, stage.color_source2, stage.color_source3 };
+    const Source alpha_sources[3] = { stage.alpha_source1, stage.alpha_source2, stage.alpha_source3 };
+    const ColorModifier color_modifiers[3] = { stage.color_modifier1, stage.color_modifier2, stage.color_modifier3 };
+    const AlphaModifier alpha_modifiers[3] = { stage.alpha_modifier1, stage.alpha_modifier2, stage.alpha_modifier3 };
+
+    u8 shuffle = 0;
+    GetColorModifierShuffle(color_modifiers[index], &shuffle);
+    const u8 alpha_component = GetAlphaModifierComponent(alpha_modifiers[index]);
+
+    Compile_LoadSource(dest, color_sources[index], stage.const_color);
+
+    if (alpha_sources[index] == color_sources[index]) {
+        // Both modifiers can be applied with a single shuffle
+        shuffle |= alpha_component << 6;
+        if (shuffle != 0xE4)
+            PSHUFD(dest, R(dest), shuffle);
+    } else {
+        if (shuffle != 0x24)
+            PSHUFD(dest, R(dest), shuffle);
+
+        Compile_LoadSource(TEMP, alpha_sources[index], stage.const_color);
+        if (alpha_component != 3)
+            PSHUFD(TEMP, R(TEMP), alpha_component << 6);
+        BLENDPS(dest, R(TEMP), 0x8);
+    }
+
+    // All "OneMinus" modifiers have the lowest bit set. Since the values are at most 255, 255 - x
+    // is the same as 255 ^ x.
+    int invert = (static_cast<u32>(color_modifiers[index]) & 1) | ((static_cast<u32>(alpha_modifiers[index]) & 1) << 1);
+    if (invert != 0)
+        PXOR(dest, Constant(offsetof(TevConstants, invert_masks) + invert * 4 * sizeof(u32)));
+}
+
+void TevJit::Compile_DivideBy255(X64Reg reg) {
+    // For 0 <= x <= 2 * 255 * 255, x / 255 == (y + (y >> 8) + (y >> 16)) >> 8 with y = x + 1
+    PADDD(reg, Constant(offsetof(TevConstants, all_1)));
+    MOVDQA(TEMP, R(reg));
+    PSRLD(TEMP, 8);
+    PADDD(reg, R(TEMP));
+    PSRLD(TEMP, 8);
+    PADDD(reg, R(TEMP));
+    PSRLD(reg, 8);
+}
+
+void TevJit::Compile_Combine(X64Reg dest, Operation op) {
+    const X64Reg input0 = STAGE_INPUTS[0];
+    const X64Reg input1 = STAGE_INPUTS[1];
+    const X64Reg input2 = STAGE_INPUTS[2];
+    const OpArg all_255 = Constant(offsetof(TevConstants, all_255));
+
+    // Products of two inputs fit in 16 bits, so PMULLW is enough for them
+    switch (op) {
+    case Operation::Replace:
+        MOVDQA(dest, R(input0));
+        break;
+
+    case Operation::Modulate:
+        MOVDQA(dest, R(input0));
+        PMULLW(dest, R(input1));
+        Compile_DivideBy255(dest);
+        break;
+
+    case Operation::Add:
+        MOVDQA(dest, R(input0));
+        PADDD(dest, R(input1));
+        PMINSD(dest, all_255);
+        break;
+
+    case Operation::AddSigned:
+        MOVDQA(dest, R(input0));
+        PADDD(dest, R(input1));
+        PSUBD(dest, Constant(offsetof(TevConstants, all_128)));
+        PXOR(TEMP, R(TEMP));
+        PMAXSD(dest, R(TEMP));
+        PMINSD(dest, all_255);
+        break;
+
+    case Operation::Lerp:
+        MOVDQA(dest, R(input0));
+        PMULLW(dest, R(input2));
+        MOVDQA(TEMP, R(input2));
+        PXOR(TEMP, all_255);
+        PMULLW(TEMP, R(input1));
+        PADDD(dest, R(TEMP));
+        Compile_DivideBy255(dest);
+        break;
+
+    case Operation::Subtract:
+        MOVDQA(dest, R(input0));
+        PSUBD(dest, R(input1));
+        PXOR(TEMP, R(TEMP));
+        PMAXSD(dest, R(TEMP));
+        break;
+
+    case Operation::MultiplyThenAdd:
+        MOVDQA(dest, R(input0));
+        PMULLW(dest, R(input1));
+        MOVDQA(TEMP, R(input2));
+        PMULLW(TEMP, all_255);
+        PADDD(dest, R(TEMP));
+        Compile_DivideBy255(dest);
+        PMINSD(dest, all_255);
+        break;
+
+    case Operation::AddThenMultiply:
+        MOVDQA(dest, R(input0));
+        PADDD(dest, R(input1));
+        PMINSD(dest, all_255);
+        PMULLW(dest, R(input2));
+        Compile_DivideBy255(dest);
+        break;
+
+    case Operation::Dot3_RGB:
+        // Per component ((in0 * 2 - 255) * (in1 * 2 - 255) + 128) / 256, summed up and clamped
+        MOVDQA(dest, R(input0));
+        PSLLD(dest, 1);
+        PSUBD(dest, all_255);
+        MOVDQA(TEMP, R(input1));
+        PSLLD(TEMP, 1);
+        PSUBD(TEMP, all_255);
+        PMULLD(dest, R(TEMP));
+        PADDD(dest, Constant(offsetof(TevConstants, all_128)));
+
+        // Signed division rounding towards zero
+        MOVDQA(TEMP, R(dest));
+        PSRAD(TEMP, 31);
+        PAND(TEMP, all_255);
+        PADDD(dest, R(TEMP));
+        PSRAD(dest, 8);
+
+        PSHUFD(TEMP, R(dest), 0x55);
+        PADDD(TEMP, R(dest));
+        PSHUFD(dest, R(dest), 0xAA);
+        PADDD(dest, R(TEMP));
+        PSHUFD(dest, R(dest), 0x00);
+
+        PXOR(TEMP, R(TEMP));
+        PMAXSD(dest, R(TEMP));
+        PMINSD(dest, all_255);
+        break;
+
+    default:
+        UNREACHABLE();
+    }
+}
+
+void TevJit::Compile_AlphaTest(const TevConfig& config) {
+    const auto func = static_cast<Regs::CompareFunc>(config.alpha_test_func);
+
+    if (!config.alpha_test_enable || func == Regs::CompareFunc::Always) {
+        MOV(32, R(ABI_RETURN), Imm32(1));
+        return;
+    }
+
+    if (func == Regs::CompareFunc::Never) {
+        XOR(32, R(ABI_RETURN), R(ABI_RETURN));
+        return;
+    }
+
+    CCFlags condition = CC_E;
+    switch (func) {
+    case Regs::CompareFunc::Equal:              condition = CC_E;  break;
+    case Regs::CompareFunc::NotEqual:           condition = CC_NE; break;
+    case Regs::CompareFunc::LessThan:           condition = CC_B;  break;
+    case Regs::CompareFunc::LessThanOrEqual:    condition = CC_BE; break;
+    case Regs::CompareFunc::GreaterThan:        condition = CC_A;  break;
+    case Regs::CompareFunc::GreaterThanOrEqual: condition = CC_AE; break;
+    default:
+        break;
+    }
+
+    MOVZX(32, 8, SCRATCH, MDisp(OUTPUT, 3));
+    XOR(32, R(ABI_RETURN), R(ABI_RETURN));
+    CMP(32, R(SCRATCH), Imm32(config.alpha_test_ref));
+    SETcc(condition, R(ABI_RETURN));
+}
+
+CompiledTevCombiner* TevJit::Compile(const TevConfig& config) {
+    Regs::TevStageConfig stages[6];
+    int last_buffer_reader = -1;
+    for (int i = 0; i < 6; ++i) {
+        stages[i].sources_raw = config.stages[i].sources_raw;
+        stages[i].modifiers_raw = config.stages[i].modifiers_raw;
+        stages[i].ops_raw = config.stages[i].ops_raw;
+        stages[i].const_color = config.stages[i].const_color;
+        stages[i].scales_raw = config.stages[i].scales_raw;
+
+        if (IsPassThroughTevStage(stages[i]))
+            continue;
+
+        if (!IsSupportedStage(stages[i]))
+            return nullptr;
+
+        if (ReadsCombinerBuffer(stages[i]))
+            last_buffer_reader = i;
+    }
+
+    const u8* start = GetCodePtr();
+
+    // XMM6 and XMM7 are callee saved on Windows
+    const BitSet32 saved_regs = BitSet32 { TEMP + 16, ALPHA_RESULT + 16 } & ABI_ALL_CALLEE_SAVED;
+    ABI_PushRegistersAndAdjustStack(saved_regs, 8);
+
+    MOV(PTRBITS, R(CONSTANTS), ImmPtr(&constants));
+
+    // The C++ implementation leaves the input of the first stage undefined, start with zero
+    PXOR(COMBINER_OUTPUT, R(COMBINER_OUTPUT));
+
+    if (last_buffer_reader >= 0)
+        PXOR(BUFFER, R(BUFFER));
+    if (last_buffer_reader >= 1)
+        Compile_LoadSource(NEXT_BUFFER, Source::Constant, config.buffer_color);
+
+    for (int i = 0; i < 6; ++i) {
+        const auto& stage = stages[i];
+
+        if (!IsPassThroughTevStage(stage)) {
+            int num_inputs = std::max(GetNumInputs(stage.color_op), GetNumInputs(stage.alpha_op));
+            for (int input = 0; input < num_inputs; ++input)
+                Compile_LoadInput(STAGE_INPUTS[input], stage, input);
+
+            Compile_Combine(COMBINER_OUTPUT, stage.color_op);
+            if (stage.alpha_op != stage.color_op) {
+                Compile_Combine(ALPHA_RESULT, stage.alpha_op);
+                BLENDPS(COMBINER_OUTPUT, R(ALPHA_RESULT), 0x8);
+            }
+
+            const unsigned color_shift = (stage.color_scale < 3) ? stage.color_scale.Value() : 0;
+            const unsigned alpha_shift = (stage.alpha_scale < 3) ? stage.alpha_scale.Value() : 0;
+            if (color_shift == alpha_shift) {
+                if (color_shift != 0)
+                    PSLLD(COMBINER_OUTPUT, color_shift);
+            } else {
+                MOVDQA(TEMP, R(COMBINER_OUTPUT));
+                if (color_shift != 0)
+                    PSLLD(COMBINER_OUTPUT, color_shift);
+                if (alpha_shift != 0)
+                    PSLLD(TEMP, alpha_shift);
+                BLENDPS(COMBINER_OUTPUT, R(TEMP), 0x8);
+            }
+            if (color_shift != 0 || alpha_shift != 0)
+                PMINSD(COMBINER_OUTPUT, Constant(offsetof(TevConstants, all_255)));
+        }
+
+        // Stage i + 1 reads the buffer contents written up to stage i - 1
+        if (i < last_buffer_reader) {
+            MOVDQA(BUFFER, R(NEXT_BUFFER));
+
+            if (i + 1 < last_buffer_reader) {
+                const bool update_color = (config.update_mask_rgb & (1 << i)) != 0;
+                const bool update_alpha = (config.update_mask_a & (1 << i)) != 0;
+                if (update_color && update_alpha)
+                    MOVDQA(NEXT_BUFFER, R(COMBINER_OUTPUT));
+                else if (update_color)
+                    BLENDPS(NEXT_BUFFER, R(COMBINER_OUTPUT), 0x7);
+                else if (update_alpha)
+                    BLENDPS(NEXT_BUFFER, R(COMBINER_OUTPUT), 0x8);
+            }
+        }
+    }
+
+    // All components are within [0, 255] at this point
+    PACKUSDW(COMBINER_OUTPUT, R(COMBINER_OUTPUT));
+    PACKUSWB(COMBINER_OUTPUT, R(COMBINER_OUTPUT));
+    MOVD_xmm(MatR(OUTPUT), COMBINER_OUTPUT);
+
+    Compile_AlphaTest(config);
+
+    ABI_PopRegistersAndAdjustStack(saved_regs, 8);
+    RET();
+
+    return (CompiledTevCombiner*)start;
+}
+
+TevJit::TevJit() {
+    AllocCodeSpace(1024 * 1024);
+}
+
+void TevJit::Clear() {
+    ClearCodeSpace();
+}
+
+bool TevJit::IsSupported() {
+    return Common::GetCPUCaps().sse4_1;
+}
+
+} // namespace Pica
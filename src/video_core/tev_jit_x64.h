@@ -0,0 +1,71 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/pica.h"
+
+namespace Pica {
+
+/// Texture environment and alpha test state that a fragment combiner is compiled for. Used as the cache key.
+struct TevConfig {
+    struct Stage {
+        u32 sources_raw;
+        u32 modifiers_raw;
+        u32 ops_raw;
+        u32 const_color;
+        u32 scales_raw;
+    };
+
+    Stage stages[6];
+    u32 update_mask_rgb; ///< Stages whose color output is written to the combiner buffer
+    u32 update_mask_a;   ///< Stages whose alpha output is written to the combiner buffer
+    u32 buffer_color;    ///< Initial combiner buffer contents
+    u32 alpha_test_enable;
+    u32 alpha_test_func;
+    u32 alpha_test_ref;
+
+    static TevConfig FromRegs(const Regs& regs);
+};
+
+/// Per-fragment inputs of a compiled combiner
+struct TevInputs {
+    Math::Vec4<u8> primary_color;
+    Math::Vec4<u8> texture_color[3];
+};
+
+/// Writes the combiner output of the fragment and returns whether it passes the alpha test
+using CompiledTevCombiner = bool(const TevInputs* inputs, Math::Vec4<u8>* output);
+
+/**
+ * This class implements the texture combiner JIT compiler. It compiles the active texture
+ * environment stages and the alpha test into x86_64 code that evaluates them for a single fragment,
+ * processing the color and alpha combiners of a stage together in one SSE register. Pass-through
+ * stages are skipped and unused inputs and combiner buffer updates are never computed.
+ */
+class TevJit : public Gen::XCodeBlock {
+public:
+    TevJit();
+
+    /// Compiles the given configuration, returns nullptr if it uses something that isn't supported
+    CompiledTevCombiner* Compile(const TevConfig& config);
+
+    void Clear();
+
+    /// Whether the host supports the instructions used by compiled combiners
+    static bool IsSupported();
+
+private:
+    void Compile_LoadSource(Gen::X64Reg dest, Regs::TevStageConfig::Source source, u32 const_color);
+    void Compile_LoadInput(Gen::X64Reg dest, const Regs::TevStageConfig& stage, int index);
+    void Compile_Combine(Gen::X64Reg dest, Regs::TevStageConfig::Operation op);
+    void Compile_DivideBy255(Gen::X64Reg reg);
+    void Compile_AlphaTest(const TevConfig& config);
+};
+
+} // namespace Pica
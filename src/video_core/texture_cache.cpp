@@ -0,0 +1,103 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/make_unique.h"
+#include "common/math_util.h"
+#include "common/microprofile.h"
+
+#include "core/memory.h"
+
+#include "video_core/pica.h"
+#include "video_core/texture_cache.h"
+#include "video_core/debug_utils/debug_utils.h"
+
+namespace Pica {
+
+namespace TextureCache {
+
+/// Address, format, width and height of a texture
+using TextureKey = std::tuple<PAddr, Regs::TextureFormat, int, int>;
+
+static std::map<TextureKey, std::unique_ptr<DecodedTexture>> texture_cache;
+/// Number of texels in all cached textures
+static size_t cached_texels = 0;
+static Stats stats = {};
+
+/// Textures are few and rarely change, so rather than tracking their use just start over when full
+static const size_t MAX_CACHED_TEXELS = 16 * 1024 * 1024;
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decode", MP_RGB(128, 64, 192));
+
+void ReserveTexels(size_t num_texels) {
+    if (cached_texels + num_texels > MAX_CACHED_TEXELS)
+        InvalidateAll();
+}
+
+const DecodedTexture* GetTexture(const DebugUtils::TextureInfo& info) {
+    const TextureKey key(info.physical_address, info.format, info.width, info.height);
+
+    auto iter = texture_cache.find(key);
+    if (iter != texture_cache.end()) {
+        ++stats.hits;
+        return iter->second.get();
+    }
+
+    const u8* source = Memory::GetPhysicalPointer(info.physical_address);
+    if (source == nullptr)
+        return nullptr;
+
+    ++stats.misses;
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    const size_t num_texels = info.width * info.height;
+    auto texture = Common::make_unique<DecodedTexture>();
+    texture->address = info.physical_address;
+    texture->size = info.stride * info.height;
+    texture->hash = Common::ComputeHash64(source, texture->size);
+    texture->width = info.width;
+    texture->height = info.height;
+    texture->texels.resize(num_texels);
+    DebugUtils::DecodeTexture(source, info, texture->texels.data());
+
+    LOG_TRACE(Render_Software, "Decoded %dx%d texture at 0x%08x (%u hits, %u misses)",
+              info.width, info.height, info.physical_address, (unsigned)stats.hits, (unsigned)stats.misses);
+
+    cached_texels += num_texels;
+    return texture_cache.emplace(key, std::move(texture)).first->second.get();
+}
+
+void InvalidateInRange(PAddr addr, u32 size, bool ignore_hash) {
+    for (auto iter = texture_cache.begin(); iter != texture_cache.end();) {
+        const DecodedTexture& texture = *iter->second;
+
+        // Drop the texture only if the memory region intersects and a change is detected
+        if (MathUtil::IntervalsIntersect(addr, size, texture.address, texture.size) &&
+            (ignore_hash || texture.hash != Common::ComputeHash64(Memory::GetPhysicalPointer(texture.address), texture.size))) {
+
+            cached_texels -= texture.texels.size();
+            iter = texture_cache.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void InvalidateAll() {
+    texture_cache.clear();
+    cached_texels = 0;
+}
+
+Stats GetStats() {
+    return stats;
+}
+
+} // namespace TextureCache
+
+} // namespace Pica
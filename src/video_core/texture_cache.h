@@ -0,0 +1,67 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+    struct TextureInfo;
+}
+
+/**
+ * Cache of textures decoded to RGBA8 for the software rasterizer, so that sampling a texel doesn't
+ * need to decode it from the tiled source format every time.
+ */
+namespace TextureCache {
+
+/// Texture decoded to RGBA8, the texel that LookupTexture returns for (s, t) is at t * width + s
+struct DecodedTexture {
+    PAddr address;
+    u32 size;   ///< Size of the source data in bytes
+    u64 hash;   ///< Hash of the source data, used to check whether it changed on invalidation
+    int width;
+    int height;
+    std::vector<Math::Vec4<u8>> texels;
+};
+
+struct Stats {
+    u64 hits;
+    u64 misses;
+};
+
+/**
+ * Makes room for decoding textures with the given total number of texels, dropping all cached
+ * textures if they don't fit. Lookups never drop textures themselves, so this has to be called
+ * before looking up all the textures that are used together.
+ */
+void ReserveTexels(size_t num_texels);
+
+/**
+ * Returns the given texture decoded to RGBA8, decoding it if it isn't cached yet. The returned
+ * texture stays valid until the cache is invalidated or ReserveTexels drops it.
+ * @return The decoded texture, or nullptr if its source data isn't backed by memory
+ */
+const DecodedTexture* GetTexture(const DebugUtils::TextureInfo& info);
+
+/**
+ * Drops the cached textures whose source data intersects the given region
+ * @param ignore_hash If false, textures whose source data didn't change are kept
+ */
+void InvalidateInRange(PAddr addr, u32 size, bool ignore_hash = false);
+
+/// Drops all cached textures
+void InvalidateAll();
+
+/// Returns the number of lookups that were served from the cache and that required decoding
+Stats GetStats();
+
+} // namespace TextureCache
+
+} // namespace Pica
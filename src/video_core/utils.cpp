@@ -2,9 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+#include "common/assert.h"
+
 #include "video_core/utils.h"
 
 namespace VideoCore {
@@ -33,4 +40,178 @@ void DumpTGA(std::string filename, short width, short height, u8* raw_data) {
 
     fclose(fout);
 }
+
+/// Copies an 8x8 tile to a linear block one pixel at a time, the offsets come from the Morton table
+template <u32 bytes_per_pixel>
+static void UnswizzleTileImpl(const u8* tiled, u8* linear, int linear_stride) {
+    for (u32 y = 0; y < 8; ++y, linear += linear_stride) {
+        for (u32 x = 0; x < 8; ++x)
+            memcpy(linear + x * bytes_per_pixel, tiled + MortonInterleave(x, y) * bytes_per_pixel, bytes_per_pixel);
+    }
+}
+
+template <u32 bytes_per_pixel>
+static void SwizzleTileImpl(const u8* linear, int linear_stride, u8* tiled) {
+    for (u32 y = 0; y < 8; ++y, linear += linear_stride) {
+        for (u32 x = 0; x < 8; ++x)
+            memcpy(tiled + MortonInterleave(x, y) * bytes_per_pixel, linear + x * bytes_per_pixel, bytes_per_pixel);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// Each pair of rows y, y + 1 (y even) of a tile is made of four 2x2 subtiles that start at the
+// Morton offsets m, m + 4, m + 16 and m + 20, with m being the offset of pixel (0, y).
+static const u32 row_pair_offsets[4] = { 0, 8, 32, 40 };
+
+template <>
+void UnswizzleTileImpl<4>(const u8* tiled, u8* linear, int linear_stride) {
+    for (u32 m : row_pair_offsets) {
+        // Each register holds a 2x2 subtile, the low half is the row y and the high half row y + 1
+        __m128i a = _mm_loadu_si128((const __m128i*)(tiled + (m + 0) * 4));
+        __m128i b = _mm_loadu_si128((const __m128i*)(tiled + (m + 4) * 4));
+        __m128i c = _mm_loadu_si128((const __m128i*)(tiled + (m + 16) * 4));
+        __m128i d = _mm_loadu_si128((const __m128i*)(tiled + (m + 20) * 4));
+
+        _mm_storeu_si128((__m128i*)linear, _mm_unpacklo_epi64(a, b));
+        _mm_storeu_si128((__m128i*)(linear + 16), _mm_unpacklo_epi64(c, d));
+        linear += linear_stride;
+        _mm_storeu_si128((__m128i*)linear, _mm_unpackhi_epi64(a, b));
+        _mm_storeu_si128((__m128i*)(linear + 16), _mm_unpackhi_epi64(c, d));
+        linear += linear_stride;
+    }
+}
+
+template <>
+void SwizzleTileImpl<4>(const u8* linear, int linear_stride, u8* tiled) {
+    for (u32 m : row_pair_offsets) {
+        __m128i row0_left = _mm_loadu_si128((const __m128i*)linear);
+        __m128i row0_right = _mm_loadu_si128((const __m128i*)(linear + 16));
+        linear += linear_stride;
+        __m128i row1_left = _mm_loadu_si128((const __m128i*)linear);
+        __m128i row1_right = _mm_loadu_si128((const __m128i*)(linear + 16));
+        linear += linear_stride;
+
+        _mm_storeu_si128((__m128i*)(tiled + (m + 0) * 4), _mm_unpacklo_epi64(row0_left, row1_left));
+        _mm_storeu_si128((__m128i*)(tiled + (m + 4) * 4), _mm_unpackhi_epi64(row0_left, row1_left));
+        _mm_storeu_si128((__m128i*)(tiled + (m + 16) * 4), _mm_unpacklo_epi64(row0_right, row1_right));
+        _mm_storeu_si128((__m128i*)(tiled + (m + 20) * 4), _mm_unpackhi_epi64(row0_right, row1_right));
+    }
+}
+
+template <>
+void UnswizzleTileImpl<2>(const u8* tiled, u8* linear, int linear_stride) {
+    for (u32 m : row_pair_offsets) {
+        // Two subtiles per register, swapping the middle pixel pairs groups them by row
+        __m128i left = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(tiled + m * 2)), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i right = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(tiled + (m + 16) * 2)), _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm_storeu_si128((__m128i*)linear, _mm_unpacklo_epi64(left, right));
+        linear += linear_stride;
+        _mm_storeu_si128((__m128i*)linear, _mm_unpackhi_epi64(left, right));
+        linear += linear_stride;
+    }
+}
+
+template <>
+void SwizzleTileImpl<2>(const u8* linear, int linear_stride, u8* tiled) {
+    for (u32 m : row_pair_offsets) {
+        __m128i row0 = _mm_loadu_si128((const __m128i*)linear);
+        linear += linear_stride;
+        __m128i row1 = _mm_loadu_si128((const __m128i*)linear);
+        linear += linear_stride;
+
+        __m128i left = _mm_shuffle_epi32(_mm_unpacklo_epi64(row0, row1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i right = _mm_shuffle_epi32(_mm_unpackhi_epi64(row0, row1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i*)(tiled + m * 2), left);
+        _mm_storeu_si128((__m128i*)(tiled + (m + 16) * 2), right);
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+/**
+ * Converts between a tiled surface and a linear image, whole tiles are converted by the tile
+ * routines and the pixels of partial ones at the edges are copied individually.
+ */
+template <u32 bytes_per_pixel, bool to_linear>
+static void ConvertSurface(u8* tiled, u8* linear, int linear_stride, u32 width, u32 height) {
+    for (u32 y = 0; y < height; y += 8) {
+        // Tiles are stored by rows, each one 8 pixels high
+        u8* tile = tiled + y * width * bytes_per_pixel;
+        u8* block = linear + (int)y * linear_stride;
+
+        for (u32 x = 0; x < width; x += 8, tile += 64 * bytes_per_pixel, block += 8 * bytes_per_pixel) {
+            if (x + 8 <= width && y + 8 <= height) {
+                if (to_linear)
+                    UnswizzleTileImpl<bytes_per_pixel>(tile, block, linear_stride);
+                else
+                    SwizzleTileImpl<bytes_per_pixel>(block, linear_stride, tile);
+                continue;
+            }
+
+            const u32 block_width = std::min(width - x, 8u);
+            const u32 block_height = std::min(height - y, 8u);
+            for (u32 fine_y = 0; fine_y < block_height; ++fine_y) {
+                for (u32 fine_x = 0; fine_x < block_width; ++fine_x) {
+                    u8* tiled_pixel = tile + MortonInterleave(fine_x, fine_y) * bytes_per_pixel;
+                    u8* linear_pixel = block + (int)fine_y * linear_stride + fine_x * bytes_per_pixel;
+                    if (to_linear)
+                        memcpy(linear_pixel, tiled_pixel, bytes_per_pixel);
+                    else
+                        memcpy(tiled_pixel, linear_pixel, bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+void UnswizzleTile(const u8* tiled, u8* linear, int linear_stride, u32 bytes_per_pixel) {
+    switch (bytes_per_pixel) {
+    case 1: UnswizzleTileImpl<1>(tiled, linear, linear_stride); break;
+    case 2: UnswizzleTileImpl<2>(tiled, linear, linear_stride); break;
+    case 3: UnswizzleTileImpl<3>(tiled, linear, linear_stride); break;
+    case 4: UnswizzleTileImpl<4>(tiled, linear, linear_stride); break;
+    default:
+        UNREACHABLE();
+    }
+}
+
+void SwizzleTile(const u8* linear, int linear_stride, u8* tiled, u32 bytes_per_pixel) {
+    switch (bytes_per_pixel) {
+    case 1: SwizzleTileImpl<1>(linear, linear_stride, tiled); break;
+    case 2: SwizzleTileImpl<2>(linear, linear_stride, tiled); break;
+    case 3: SwizzleTileImpl<3>(linear, linear_stride, tiled); break;
+    case 4: SwizzleTileImpl<4>(linear, linear_stride, tiled); break;
+    default:
+        UNREACHABLE();
+    }
+}
+
+void TiledToLinear(const u8* tiled, u8* linear, int linear_stride, u32 width, u32 height,
+                   u32 bytes_per_pixel) {
+    u8* source = const_cast<u8*>(tiled); // Only read from when converting to linear
+    switch (bytes_per_pixel) {
+    case 1: ConvertSurface<1, true>(source, linear, linear_stride, width, height); break;
+    case 2: ConvertSurface<2, true>(source, linear, linear_stride, width, height); break;
+    case 3: ConvertSurface<3, true>(source, linear, linear_stride, width, height); break;
+    case 4: ConvertSurface<4, true>(source, linear, linear_stride, width, height); break;
+    default:
+        UNREACHABLE();
+    }
+}
+
+void LinearToTiled(const u8* linear, int linear_stride, u8* tiled, u32 width, u32 height,
+                   u32 bytes_per_pixel) {
+    u8* source = const_cast<u8*>(linear); // Only read from when converting to tiled
+    switch (bytes_per_pixel) {
+    case 1: ConvertSurface<1, false>(tiled, source, linear_stride, width, height); break;
+    case 2: ConvertSurface<2, false>(tiled, source, linear_stride, width, height); break;
+    case 3: ConvertSurface<3, false>(tiled, source, linear_stride, width, height); break;
+    case 4: ConvertSurface<4, false>(tiled, source, linear_stride, width, height); break;
+    default:
+        UNREACHABLE();
+    }
+}
+
 } // namespace
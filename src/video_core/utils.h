@@ -37,15 +37,22 @@ void DumpTGA(std::string filename, short width, short height, u8* raw_data);
 
 /**
  * Interleave the lower 3 bits of each coordinate to get the intra-block offsets, which are
- * arranged in a Z-order curve. More details on the bit manipulation at:
- * https://fgiesen.wordpress.com/2009/12/13/decoding-morton-codes/
+ * arranged in a Z-order curve (see GetMortonOffset for the layout).
  */
 static inline u32 MortonInterleave(u32 x, u32 y) {
-    u32 i = (x & 7) | ((y & 7) << 8); // ---- -210
-    i = (i ^ (i << 2)) & 0x1313;      // ---2 --10
-    i = (i ^ (i << 1)) & 0x1515;      // ---2 -1-0
-    i = (i | (i >> 7)) & 0x3F;
-    return i;
+    // Looking the offsets up is cheaper than interleaving the bits, see
+    // https://fgiesen.wordpress.com/2009/12/13/decoding-morton-codes/ for the bit manipulation
+    static const u8 morton_table[8 * 8] = {
+         0,  1,  4,  5, 16, 17, 20, 21,
+         2,  3,  6,  7, 18, 19, 22, 23,
+         8,  9, 12, 13, 24, 25, 28, 29,
+        10, 11, 14, 15, 26, 27, 30, 31,
+        32, 33, 36, 37, 48, 49, 52, 53,
+        34, 35, 38, 39, 50, 51, 54, 55,
+        40, 41, 44, 45, 56, 57, 60, 61,
+        42, 43, 46, 47, 58, 59, 62, 63,
+    };
+    return morton_table[((y & 7) << 3) | (x & 7)];
 }
 
 /**
@@ -82,4 +89,32 @@ static inline u32 GetMortonOffset(u32 x, u32 y, u32 bytes_per_pixel) {
     return (i + offset) * bytes_per_pixel;
 }
 
+/**
+ * Copies an 8x8 tile of pixels stored in Morton order to a block of a linear image.
+ * @param tiled Source tile, 64 * bytes_per_pixel bytes
+ * @param linear Destination of the pixel at (0, 0) of the block
+ * @param linear_stride Distance in bytes from one row of the linear image to the next one, may be
+ *                      negative to flip the block vertically
+ * @param bytes_per_pixel Size of a pixel, 1 to 4 bytes
+ */
+void UnswizzleTile(const u8* tiled, u8* linear, int linear_stride, u32 bytes_per_pixel);
+
+/// Copies a block of 8x8 pixels of a linear image to a tile in Morton order, see UnswizzleTile
+void SwizzleTile(const u8* linear, int linear_stride, u8* tiled, u32 bytes_per_pixel);
+
+/**
+ * Converts a whole tiled surface, like a texture or a framebuffer, to a linear image. The pixels
+ * of partial tiles at the surface edges are copied individually.
+ * @param tiled Source surface, laid out as GetMortonOffset describes
+ * @param linear Destination of the pixel at (0, 0)
+ * @param linear_stride Distance in bytes from one row of the linear image to the next one, may be
+ *                      negative to flip the image vertically
+ */
+void TiledToLinear(const u8* tiled, u8* linear, int linear_stride, u32 width, u32 height,
+                   u32 bytes_per_pixel);
+
+/// Converts a whole linear image to a tiled surface, see TiledToLinear
+void LinearToTiled(const u8* linear, int linear_stride, u8* tiled, u32 width, u32 height,
+                   u32 bytes_per_pixel);
+
 } // namespace
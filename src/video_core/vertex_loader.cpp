@@ -0,0 +1,226 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <unordered_map>
+
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+
+#include "core/memory.h"
+
+#include "video_core/pica.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/shader/shader.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif // ARCHITECTURE_x86_64
+
+namespace Pica {
+
+/**
+ * Loads an attribute element consisting of N components of type T. Components which are not
+ * present in the array are set to (0, 0, 0, 1). This is *not* carried over from the default
+ * attribute settings even if they're enabled for the attribute.
+ */
+template <typename T, unsigned N>
+static void LoadAttribute(const u8* data, Math::Vec4<float24>& attribute) {
+    static_assert(N >= 1 && N <= 4, "Invalid number of attribute components");
+
+    T values[N];
+    std::memcpy(values, data, sizeof(values));
+
+    static const float24 zero = float24::FromFloat32(0.0f);
+    static const float24 one = float24::FromFloat32(1.0f);
+    attribute = Math::Vec4<float24>(zero, zero, zero, one);
+
+    for (unsigned comp = 0; comp < N; ++comp)
+        attribute[comp] = float24::FromFloat32(static_cast<float>(values[comp]));
+}
+
+/// Attribute loaders, indexed by the VertexAttributeFormat and the number of elements minus one
+static const std::array<std::array<void(*)(const u8*, Math::Vec4<float24>&), 4>, 4> attribute_loader_table = {{
+    {{ LoadAttribute<s8, 1>, LoadAttribute<s8, 2>, LoadAttribute<s8, 3>, LoadAttribute<s8, 4> }},
+    {{ LoadAttribute<u8, 1>, LoadAttribute<u8, 2>, LoadAttribute<u8, 3>, LoadAttribute<u8, 4> }},
+    {{ LoadAttribute<s16, 1>, LoadAttribute<s16, 2>, LoadAttribute<s16, 3>, LoadAttribute<s16, 4> }},
+    {{ LoadAttribute<float, 1>, LoadAttribute<float, 2>, LoadAttribute<float, 3>, LoadAttribute<float, 4> }},
+}};
+
+#ifdef ARCHITECTURE_x86_64
+static std::unordered_map<u64, CompiledVertexLoader*> loader_map;
+static VertexLoaderJit jit;
+
+/// Looks up the loader compiled for the given layout, compiling it if necessary
+static CompiledVertexLoader* GetCompiledLoader(const VertexLoaderConfig& config) {
+    u64 cache_key = Common::ComputeHash64(&config, sizeof(config));
+
+    auto iter = loader_map.find(cache_key);
+    if (iter != loader_map.end())
+        return iter->second;
+
+    // Loaders are small, so rather than tracking individual ones just start over when full
+    if (jit.GetSpaceLeft() < 64 * 1024) {
+        jit.Clear();
+        loader_map.clear();
+    }
+
+    CompiledVertexLoader* loader = jit.Compile(config);
+    loader_map.emplace(cache_key, loader);
+    return loader;
+}
+#endif // ARCHITECTURE_x86_64
+
+void VertexLoader::ClearCache() {
+#ifdef ARCHITECTURE_x86_64
+    jit.Clear();
+    loader_map.clear();
+#endif // ARCHITECTURE_x86_64
+}
+
+void VertexLoader::Setup(const Pica::Regs& regs) {
+    const auto& attribute_config = regs.vertex_attributes;
+    base_address = attribute_config.GetPhysicalBaseAddress();
+    num_total_attributes = attribute_config.GetNumTotalAttributes();
+
+    vertex_attribute_sources.fill(0xdeadbeef);
+    vertex_attribute_strides.fill(0);
+    vertex_attribute_formats.fill(Regs::VertexAttributeFormat::BYTE);
+    vertex_attribute_elements.fill(0);
+    vertex_attribute_element_size.fill(0);
+
+    for (int i = 0; i < 16; ++i)
+        vertex_attribute_is_default[i] = attribute_config.IsDefaultAttribute(i);
+
+    // Setup attribute data from loaders
+    for (int loader = 0; loader < 12; ++loader) {
+        const auto& loader_config = attribute_config.attribute_loaders[loader];
+
+        u32 load_address = base_address + loader_config.data_offset;
+
+        // TODO: What happens if a loader overwrites a previous one's data?
+        for (unsigned component = 0; component < loader_config.component_count; ++component) {
+            if (component >= 12) {
+                LOG_ERROR(HW_GPU, "Overflow in the vertex attribute loader %u trying to load component %u", loader, component);
+                break;
+            }
+
+            u32 attribute_index = loader_config.GetComponent(component);
+            if (attribute_index < 12) {
+                vertex_attribute_sources[attribute_index] = load_address;
+                vertex_attribute_strides[attribute_index] = static_cast<u32>(loader_config.byte_count);
+                vertex_attribute_formats[attribute_index] = attribute_config.GetFormat(attribute_index);
+                vertex_attribute_elements[attribute_index] = attribute_config.GetNumElements(attribute_index);
+                vertex_attribute_element_size[attribute_index] = attribute_config.GetElementSizeInBytes(attribute_index);
+                load_address += attribute_config.GetStride(attribute_index);
+            } else {
+                // Attribute ids 12 to 15 signify 4, 8, 12 and 16-byte paddings
+                load_address += (attribute_index - 11) * 4;
+            }
+        }
+    }
+
+    // Resolve the per-attribute work once, rather than dispatching on the format for every component
+    for (int i = 0; i < 16; ++i) {
+        attribute_loaders[i] = nullptr;
+        attribute_pointers[i] = nullptr;
+
+        if (vertex_attribute_elements[i] == 0)
+            continue;
+
+        attribute_loaders[i] = attribute_loader_table[static_cast<size_t>(vertex_attribute_formats[i])][vertex_attribute_elements[i] - 1];
+        attribute_pointers[i] = Memory::GetPhysicalPointer(vertex_attribute_sources[i]);
+        if (attribute_pointers[i] == nullptr) {
+            LOG_ERROR(HW_GPU, "Vertex attribute %d array at 0x%08x is not mapped", i, vertex_attribute_sources[i]);
+        }
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    compiled_loader = nullptr;
+
+    if (VideoCore::g_shader_jit_enabled) {
+        VertexLoaderConfig config = {};
+        config.num_total_attributes = static_cast<u32>(num_total_attributes);
+
+        // The compiled loader addresses the attribute arrays through host pointers, so fall back to
+        // the portable loaders if any of them is not backed by memory.
+        bool arrays_mapped = true;
+        for (int i = 0; i < 16; ++i) {
+            auto& attribute = config.attributes[i];
+            attribute.stride = vertex_attribute_strides[i];
+            attribute.format = static_cast<u32>(vertex_attribute_formats[i]);
+            attribute.elements = vertex_attribute_elements[i];
+            attribute.is_default = vertex_attribute_is_default[i];
+
+            if (attribute.elements != 0)
+                arrays_mapped &= attribute_pointers[i] != nullptr;
+        }
+
+        if (arrays_mapped)
+            compiled_loader = GetCompiledLoader(config);
+    }
+#endif // ARCHITECTURE_x86_64
+}
+
+void VertexLoader::LoadVertex(int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses) {
+    // The Pica recorder needs to know about every memory access, which only the tracking path reports
+    if (g_debug_context && g_debug_context->recorder) {
+        LoadAttributes<true>(index, vertex, input, memory_accesses);
+        return;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    if (compiled_loader != nullptr) {
+        compiled_loader(vertex, &input, attribute_pointers.data());
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
+    LoadAttributes<false>(index, vertex, input, memory_accesses);
+}
+
+template <bool track_accesses>
+void VertexLoader::LoadAttributes(int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses) {
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            if (attribute_pointers[i] == nullptr) {
+                // Unmapped arrays have already been reported by Setup, leave the attribute untouched
+                continue;
+            }
+
+            const u32 offset = vertex_attribute_strides[i] * vertex;
+
+            if (track_accesses) {
+                memory_accesses.AddAccess(vertex_attribute_sources[i] + offset,
+                                          vertex_attribute_elements[i] * vertex_attribute_element_size[i]);
+            }
+
+            attribute_loaders[i](attribute_pointers[i] + offset, input.attr[i]);
+            LOG_TRACE(HW_GPU, "Loaded attribute %x for vertex %x (index %x) from 0x%08x + 0x%08x + 0x%04x: (%f, %f, %f, %f)",
+                      i, vertex, index,
+                      base_address,
+                      vertex_attribute_sources[i] - base_address,
+                      offset,
+                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
+                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+        } else if (vertex_attribute_is_default[i]) {
+            // Load the default attribute if we're configured to do so
+            input.attr[i] = g_state.vs.default_attributes[i];
+            LOG_TRACE(HW_GPU, "Loaded default attribute %x for vertex %x (index %x): (%f, %f, %f, %f)",
+                      i, vertex, index,
+                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
+                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+        } else {
+            // TODO(yuriks): In this case, no data gets loaded and the vertex
+            // remains with the last value it had. This isn't currently maintained
+            // as global state, however, and so won't work in Citra yet.
+        }
+    }
+}
+
+} // namespace Pica
@@ -0,0 +1,79 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+
+#include "common/common_types.h"
+
+#include "video_core/pica.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+class MemoryAccessTracker;
+}
+
+/**
+ * Loads the attributes of vertices from the attribute arrays described by the vertex_attributes
+ * registers into shader input vertices. The layout is decoded once per draw by Setup(), after which
+ * LoadVertex() only needs to do the per-vertex work.
+ */
+class VertexLoader {
+public:
+    /// Decodes the attribute array layout from the given register state
+    void Setup(const Pica::Regs& regs);
+
+    /**
+     * Loads the attributes of a single vertex
+     * @param index Index of the vertex in the draw, only used for logging
+     * @param vertex Index of the vertex in the attribute arrays
+     * @param input Shader input vertex to load the attributes into
+     * @param memory_accesses Tracker for the memory accessed by the draw, used by the Pica recorder
+     */
+    void LoadVertex(int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses);
+
+    int GetNumTotalAttributes() const {
+        return num_total_attributes;
+    }
+
+    /// Frees all compiled vertex loaders
+    static void ClearCache();
+
+private:
+    /// Converts the components of one attribute element from the array data into a shader input attribute
+    using AttributeLoader = void(*)(const u8* data, Math::Vec4<float24>& attribute);
+
+    /**
+     * Loads all attributes of a vertex through the per-attribute loaders resolved by Setup()
+     * @tparam track_accesses Whether to report the accessed memory, only needed by the Pica recorder
+     */
+    template <bool track_accesses>
+    void LoadAttributes(int index, int vertex, Shader::InputVertex& input, DebugUtils::MemoryAccessTracker& memory_accesses);
+
+    u32 base_address;
+    std::array<u32, 16> vertex_attribute_sources;
+    std::array<u32, 16> vertex_attribute_strides;
+    std::array<Regs::VertexAttributeFormat, 16> vertex_attribute_formats;
+    std::array<u32, 16> vertex_attribute_elements;
+    std::array<u32, 16> vertex_attribute_element_size;
+    std::array<bool, 16> vertex_attribute_is_default;
+    int num_total_attributes;
+
+    /// Loader specialized for the format and element count of each attribute
+    std::array<AttributeLoader, 16> attribute_loaders;
+    /// Host pointers to the first element of each attribute array
+    std::array<const u8*, 16> attribute_pointers;
+
+#ifdef ARCHITECTURE_x86_64
+    using CompiledLoader = void(u32 vertex, Shader::InputVertex* input, const u8* const* attribute_pointers);
+
+    /// Loader compiled for the current layout, or nullptr if LoadVertex loads the attributes itself
+    CompiledLoader* compiled_loader;
+#endif // ARCHITECTURE_x86_64
+};
+
+} // namespace Pica
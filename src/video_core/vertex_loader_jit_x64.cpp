@@ -0,0 +1,134 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/x64/abi.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/pica.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+namespace Pica {
+
+using namespace Gen;
+
+static_assert(sizeof(float24) == sizeof(float), "The vertex loader JIT stores float24 as float32");
+static_assert(sizeof(Shader::InputVertex) == 16 * 4 * sizeof(float24), "Unexpected InputVertex layout");
+
+/// Arguments of the compiled loader
+static const X64Reg VERTEX = ABI_PARAM1;
+static const X64Reg INPUT = ABI_PARAM2;
+static const X64Reg ATTRIBUTE_POINTERS = ABI_PARAM3;
+/// Address of the elements being loaded
+static const X64Reg SOURCE = RAX;
+/// Scratch registers, all of these are caller saved
+static const X64Reg SCRATCH = R10;
+static const X64Reg SCRATCH_XMM = XMM0;
+
+/// Raw float32 values for the components that aren't loaded from an array
+static const u32 default_components[4] = { 0x00000000, 0x00000000, 0x00000000, 0x3F800000 };
+
+static int AttributeOffset(int index) {
+    return index * static_cast<int>(sizeof(Math::Vec4<float24>));
+}
+
+void VertexLoaderJit::Compile_LoadAttribute(const VertexLoaderConfig::Attribute& attribute, int index) {
+    const auto format = static_cast<Regs::VertexAttributeFormat>(attribute.format);
+    const int dest = AttributeOffset(index);
+
+    // SOURCE = attribute_pointers[index] + vertex * stride
+    MOV(64, R(SOURCE), MDisp(ATTRIBUTE_POINTERS, index * static_cast<int>(sizeof(const u8*))));
+    IMUL(32, SCRATCH, R(VERTEX), Imm32(attribute.stride));
+    ADD(64, R(SOURCE), R(SCRATCH));
+
+    // Complete vectors are loaded and converted at once
+    if (attribute.elements == 4 && (format == Regs::VertexAttributeFormat::FLOAT || Common::GetCPUCaps().sse4_1)) {
+        switch (format) {
+        case Regs::VertexAttributeFormat::BYTE:
+            PMOVSXBD(SCRATCH_XMM, MatR(SOURCE));
+            CVTDQ2PS(SCRATCH_XMM, R(SCRATCH_XMM));
+            break;
+        case Regs::VertexAttributeFormat::UBYTE:
+            PMOVZXBD(SCRATCH_XMM, MatR(SOURCE));
+            CVTDQ2PS(SCRATCH_XMM, R(SCRATCH_XMM));
+            break;
+        case Regs::VertexAttributeFormat::SHORT:
+            PMOVSXWD(SCRATCH_XMM, MatR(SOURCE));
+            CVTDQ2PS(SCRATCH_XMM, R(SCRATCH_XMM));
+            break;
+        case Regs::VertexAttributeFormat::FLOAT:
+            MOVUPS(SCRATCH_XMM, MatR(SOURCE));
+            break;
+        }
+        MOVUPS(MDisp(INPUT, dest), SCRATCH_XMM);
+        return;
+    }
+
+    for (u32 comp = 0; comp < attribute.elements; ++comp) {
+        const int dest_comp = dest + comp * sizeof(float24);
+
+        switch (format) {
+        case Regs::VertexAttributeFormat::BYTE:
+            MOVSX(32, 8, SCRATCH, MDisp(SOURCE, comp));
+            CVTSI2SS(SCRATCH_XMM, R(SCRATCH));
+            MOVSS(MDisp(INPUT, dest_comp), SCRATCH_XMM);
+            break;
+        case Regs::VertexAttributeFormat::UBYTE:
+            MOVZX(32, 8, SCRATCH, MDisp(SOURCE, comp));
+            CVTSI2SS(SCRATCH_XMM, R(SCRATCH));
+            MOVSS(MDisp(INPUT, dest_comp), SCRATCH_XMM);
+            break;
+        case Regs::VertexAttributeFormat::SHORT:
+            MOVSX(32, 16, SCRATCH, MDisp(SOURCE, comp * 2));
+            CVTSI2SS(SCRATCH_XMM, R(SCRATCH));
+            MOVSS(MDisp(INPUT, dest_comp), SCRATCH_XMM);
+            break;
+        case Regs::VertexAttributeFormat::FLOAT:
+            MOV(32, R(SCRATCH), MDisp(SOURCE, comp * 4));
+            MOV(32, MDisp(INPUT, dest_comp), R(SCRATCH));
+            break;
+        }
+    }
+
+    // Default attribute values set if array elements have < 4 components. This is *not* carried
+    // over from the default attribute settings even if they're enabled for this attribute.
+    for (u32 comp = attribute.elements; comp < 4; ++comp)
+        MOV(32, MDisp(INPUT, dest + comp * sizeof(float24)), Imm32(default_components[comp]));
+}
+
+void VertexLoaderJit::Compile_DefaultAttribute(int index) {
+    MOV(PTRBITS, R(SOURCE), ImmPtr(&g_state.vs.default_attributes[index]));
+    MOVUPS(SCRATCH_XMM, MatR(SOURCE));
+    MOVUPS(MDisp(INPUT, AttributeOffset(index)), SCRATCH_XMM);
+}
+
+CompiledVertexLoader* VertexLoaderJit::Compile(const VertexLoaderConfig& config) {
+    const u8* start = GetCodePtr();
+
+    // The loader is a leaf function that only uses caller saved registers, so there is no need to
+    // set up a stack frame.
+    for (u32 i = 0; i < config.num_total_attributes && i < 16; ++i) {
+        const auto& attribute = config.attributes[i];
+
+        if (attribute.elements != 0) {
+            Compile_LoadAttribute(attribute, i);
+        } else if (attribute.is_default) {
+            Compile_DefaultAttribute(i);
+        }
+    }
+
+    RET();
+
+    return (CompiledVertexLoader*)start;
+}
+
+VertexLoaderJit::VertexLoaderJit() {
+    AllocCodeSpace(1024 * 1024);
+}
+
+void VertexLoaderJit::Clear() {
+    ClearCodeSpace();
+}
+
+} // namespace Pica
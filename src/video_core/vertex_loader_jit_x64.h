@@ -0,0 +1,47 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "common/x64/emitter.h"
+
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/// Layout of the attribute arrays that a vertex loader is compiled for. Used as the cache key.
+struct VertexLoaderConfig {
+    struct Attribute {
+        u32 stride;   ///< Distance between consecutive vertices in the attribute array, in bytes
+        u32 format;   ///< Regs::VertexAttributeFormat of the elements
+        u32 elements; ///< Number of elements loaded from the array, 0 if it is not loaded from an array
+        u32 is_default; ///< Whether the default attribute is used when it is not loaded from an array
+    };
+
+    Attribute attributes[16];
+    u32 num_total_attributes;
+};
+
+using CompiledVertexLoader = void(u32 vertex, Shader::InputVertex* input, const u8* const* attribute_pointers);
+
+/**
+ * This class implements the vertex loader JIT compiler. It compiles an attribute array layout into
+ * x86_64 code that loads and converts all attributes of a vertex straight into a shader input
+ * vertex, given host pointers to the first element of each attribute array.
+ */
+class VertexLoaderJit : public Gen::XCodeBlock {
+public:
+    VertexLoaderJit();
+
+    CompiledVertexLoader* Compile(const VertexLoaderConfig& config);
+
+    void Clear();
+
+private:
+    void Compile_LoadAttribute(const VertexLoaderConfig::Attribute& attribute, int index);
+    void Compile_DefaultAttribute(int index);
+};
+
+} // namespace Pica
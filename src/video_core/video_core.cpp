@@ -3,10 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <memory>
+#include <thread>
 
 #include "common/emu_window.h"
 #include "common/make_unique.h"
 #include "common/logging/log.h"
+#include "common/thread_pool.h"
 
 #include "core/core.h"
 #include "core/settings.h"
@@ -27,6 +29,13 @@ std::unique_ptr<RendererBase> g_renderer;             ///< Renderer plugin
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
 
+Common::ThreadPool* GetWorkerThreads() {
+    static const unsigned num_cores = std::thread::hardware_concurrency();
+    static std::unique_ptr<Common::ThreadPool> workers =
+        num_cores > 1 ? Common::make_unique<Common::ThreadPool>(num_cores - 1) : nullptr;
+    return workers.get();
+}
+
 /// Initialize the video core
 void Init(EmuWindow* emu_window) {
     Pica::Init();
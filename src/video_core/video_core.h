@@ -10,6 +10,10 @@
 class EmuWindow;
 class RendererBase;
 
+namespace Common {
+class ThreadPool;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Video Core namespace
 
@@ -37,6 +41,12 @@ extern EmuWindow*                    g_emu_window; ///< Emu window
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
 
+/**
+ * Returns the threads used to split up GPU emulation work such as vertex shading and
+ * rasterization, or nullptr if there is only a single core
+ */
+Common::ThreadPool* GetWorkerThreads();
+
 /// Start the video core
 void Start();
 